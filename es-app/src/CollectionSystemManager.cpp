@@ -5,6 +5,7 @@
 #include "utils/FileSystemUtil.h"
 #include "utils/StringUtil.h"
 #include "views/gamelist/IGameListView.h"
+#include "views/UIModeController.h"
 #include "views/ViewController.h"
 #include "FileData.h"
 #include "FileFilterIndex.h"
@@ -16,12 +17,16 @@
 #include <fstream>
 #include "Gamelist.h"
 #include "FileSorts.h"
+#include "platform.h"
 #include "utils/ThreadPool.h"
 #include "utils/AsyncUtil.h"
 
 std::string myCollectionsName = "collections";
 
 #define LAST_PLAYED_MAX	50
+#define COLLECTION_PREVIEW_MAX	10
+#define OPENED_AUTO_COLLECTIONS_MAX	3
+#define LOW_MEMORY_THRESHOLD	(64LL * 1024 * 1024)	// available bytes under which populated collections are released
 
 /* Handling the getting, initialization, deinitialization, saving and deletion of
  * a CollectionSystemManager Instance */
@@ -289,7 +294,7 @@ void CollectionSystemManager::updateSystemsList()
 	removeCollectionsFromDisplayedSystems();
 
 	std::unordered_map<std::string, FileData*> map;
-	getAllGamesCollection()->getRootFolder()->createChildrenByFilenameMap(map);
+	createGamesByPathMap(map);
 
 	// add custom enabled ones
 	addEnabledCollectionsToDisplayedSystems(&mCustomCollectionSystemsData, &map);
@@ -334,6 +339,22 @@ void CollectionSystemManager::refreshCollectionSystems(FileData* file)
 	if (!file->getSystem()->isGameSystem() || file->getType() != GAME)
 		return;
 
+	// Keeps the index of the auto collections up to date with the new metadata
+	{
+		std::unique_lock<std::mutex> lock(mAutoCollectionIndexLock);
+		if (mAutoCollectionIndex != nullptr)
+		{
+			auto& systems = mAutoCollectionIndex->systems;
+			if (std::find_if(systems.cbegin(), systems.cend(), [file](const std::pair<SystemData*, unsigned int>& sys) { return sys.first == file->getSystem(); }) != systems.cend())
+			{
+				unindexAutoCollectionGame(mAutoCollectionIndex.get(), file);
+				indexAutoCollectionGame(mAutoCollectionIndex.get(), file, file->getSystem()->hasPlatformId(PlatformIds::ARCADE));
+			}
+		}
+	}
+
+	updateAutoCollectionPreviews();
+
 	std::map<std::string, CollectionSystemData> allCollections;
 	allCollections.insert(mAutoCollectionSystemsData.cbegin(), mAutoCollectionSystemsData.cend());
 	allCollections.insert(mCustomCollectionSystemsData.cbegin(), mCustomCollectionSystemsData.cend());
@@ -441,6 +462,14 @@ void CollectionSystemManager::trimCollectionCount(FolderData* rootFolder, int li
 // deletes all collection files from collection systems related to the source file
 void CollectionSystemManager::deleteCollectionFiles(FileData* file)
 {
+	{
+		std::unique_lock<std::mutex> lock(mAutoCollectionIndexLock);
+		if (mAutoCollectionIndex != nullptr)
+			unindexAutoCollectionGame(mAutoCollectionIndex.get(), file);
+	}
+
+	updateAutoCollectionPreviews();
+
 	// collection files use the full path as key, to avoid clashes
 	std::string key = file->getFullPath();
 	// find games in collection systems
@@ -798,14 +827,11 @@ void CollectionSystemManager::initCustomCollectionSystems()
 	}
 }
 
-SystemData* CollectionSystemManager::getAllGamesCollection()
+// the games of all the systems by path, as custom collections list them
+void CollectionSystemManager::createGamesByPathMap(std::unordered_map<std::string, FileData*>& map)
 {
-	CollectionSystemData* allSysData = &mAutoCollectionSystemsData["all"];
-	if (!allSysData->isPopulated)
-	{
-		populateAutoCollection(allSysData);
-	}
-	return allSysData->system;
+	for (auto game : getAutoCollectionIndex()->allGames)
+		map[game->getFullPath()] = game;
 }
 
 SystemData* CollectionSystemManager::addNewCustomCollection(std::string name)
@@ -852,156 +878,186 @@ SystemData* CollectionSystemManager::createNewCollectionEntry(std::string name,
 	return newSys;
 }
 
+// arcadesystemname of the games of an arcade vendor collection, empty for the other collections
+static std::string getArcadeSystemName(CollectionSystemType type)
+{
+	switch (type)
+	{
+	case CPS1_COLLECTION:		return "cps1";
+	case CPS2_COLLECTION:		return "cps2";
+	case CPS3_COLLECTION:		return "cps3";
+	case CAVE_COLLECTION:		return "cave";
+	case NEOGEO_COLLECTION:		return "neogeo";
+	case SEGA_COLLECTION:		return "sega";
+	case IREM_COLLECTION:		return "irem";
+	case MIDWAY_COLLECTION:		return "midway";
+	case CAPCOM_COLLECTION:		return "capcom";
+	case TECMO_COLLECTION:		return "techmo";
+	case SNK_COLLECTION:		return "snk";
+	case NAMCO_COLLECTION:		return "namco";
+	case TAITO_COLLECTION:		return "taito";
+	case KONAMI_COLLECTION:		return "konami";
+	case JALECO_COLLECTION:		return "jaleco";
+	case ATARI_COLLECTION:		return "atari";
+	case NINTENDO_COLLECTION:	return "nintendo";
+	case SAMMY_COLLECTION:		return "sammy";
+	case ACCLAIM_COLLECTION:	return "acclaim";
+	case PSIKYO_COLLECTION:		return "psikyo";
+	case KANEKO_COLLECTION:		return "kaneko";
+	case COLECO_COLLECTION:		return "coleco";
+	case ATLUS_COLLECTION:		return "atlus";
+	case BANPRESTO_COLLECTION:	return "banpresto";
+	default:					return "";
+	}
+}
+
+// "players" metadata : "2", "1-4", "2+"...
+static bool isPlayableBy(std::string players, int count)
+{
+	if (players.empty())
+		return false;
+
+	int min = -1;
+
+	auto split = players.rfind("+");
+	if (split != std::string::npos)
+		players = Utils::String::replace(players, "+", "-999");
+
+	split = players.rfind("-");
+	if (split != std::string::npos)
+	{
+		min = atoi(players.substr(0, split).c_str());
+		players = players.substr(split + 1);
+	}
+
+	int max = atoi(players.c_str());
+	return min <= 0 ? (count == max) : (min <= count && count <= max);
+}
+
+void CollectionSystemManager::indexAutoCollectionGame(AutoCollectionIndex* index, FileData* game, bool isArcade)
+{
+	bool include = includeFileInAutoCollections(game);
+
+	if (include)
+	{
+		index->allGames.push_back(game);
+
+		if (game->getMetadata().get("playcount") > "0")
+			index->played.push_back(game);
+		else
+			index->neverPlayed.push_back(game);
+
+		if (isArcade)
+			index->arcade.push_back(game);
+	}
+
+	// we may still want to add files we don't want in auto collections in "favorites"
+	if (game->getMetadata().get("favorite") == "true")
+		index->favorites.push_back(game);
+
+	std::string players = game->getMetadata("players");
+	if (isPlayableBy(players, 2))
+		index->twoPlayers.push_back(game);
+
+	if (isPlayableBy(players, 4))
+		index->fourPlayers.push_back(game);
+
+	if (isArcade)
+		index->arcadeSystemNames[game->getMetadata("arcadesystemname")].push_back(game);
+}
+
+void CollectionSystemManager::unindexAutoCollectionGame(AutoCollectionIndex* index, FileData* game)
+{
+	auto remove = [game](std::vector<FileData*>& games)
+	{
+		auto it = std::find(games.begin(), games.end(), game);
+		if (it != games.end())
+			games.erase(it);
+	};
+
+	remove(index->allGames);
+	remove(index->played);
+	remove(index->neverPlayed);
+	remove(index->favorites);
+	remove(index->arcade);
+	remove(index->twoPlayers);
+	remove(index->fourPlayers);
+
+	for (auto& games : index->arcadeSystemNames)
+		remove(games.second);
+}
+
+AutoCollectionIndex* CollectionSystemManager::getAutoCollectionIndex()
+{
+	// Collections are populated from several threads
+	std::unique_lock<std::mutex> lock(mAutoCollectionIndexLock);
+
+	std::vector<std::pair<SystemData*, unsigned int>> systems;
+	for (auto system : SystemData::sSystemVector)
+		if (system->isGameSystem() && !system->isCollection())
+			systems.push_back(std::make_pair(system, system->getRootFolder()->getTreeVersion()));
+
+	if (mAutoCollectionIndex != nullptr && mAutoCollectionIndex->systems == systems)
+		return mAutoCollectionIndex.get();
+
+	mAutoCollectionIndex.reset(new AutoCollectionIndex());
+	mAutoCollectionIndex->systems = systems;
+
+	for (auto system : systems)
+	{
+		bool isArcade = system.first->hasPlatformId(PlatformIds::ARCADE);
+
+		for (auto game : system.first->getRootFolder()->getFilesRecursive(GAME))
+			indexAutoCollectionGame(mAutoCollectionIndex.get(), game, isArcade);
+	}
+
+	return mAutoCollectionIndex.get();
+}
+
+const std::vector<FileData*>* CollectionSystemManager::getAutoCollectionGames(AutoCollectionIndex* index, CollectionSystemType type)
+{
+	switch (type)
+	{
+	case AUTO_ALL_GAMES:	return &index->allGames;
+	case AUTO_LAST_PLAYED:	return &index->played;
+	case AUTO_NEVER_PLAYED:	return &index->neverPlayed;
+	case AUTO_FAVORITES:	return &index->favorites;
+	case AUTO_ARCADE:		return &index->arcade;
+	case AUTO_AT2PLAYERS:	return &index->twoPlayers;
+	case AUTO_AT4PLAYERS:	return &index->fourPlayers;
+	default:
+		{
+			auto it = index->arcadeSystemNames.find(getArcadeSystemName(type));
+			if (it != index->arcadeSystemNames.cend())
+				return &it->second;
+		}
+		break;
+	}
+
+	return nullptr;
+}
+
 // populates an Automatic Collection System
 void CollectionSystemManager::populateAutoCollection(CollectionSystemData* sysData)
 {
 	SystemData* newSys = sysData->system;
 	CollectionSystemDecl sysDecl = sysData->decl;
 	FolderData* rootFolder = newSys->getRootFolder();
-	
-	for(auto sysIt = SystemData::sSystemVector.cbegin(); sysIt != SystemData::sSystemVector.cend(); sysIt++)
-	{
-		std::vector<PlatformIds::PlatformId> platforms = (*sysIt)->getPlatformIds();
-		bool isArcade = std::find(platforms.begin(), platforms.end(), PlatformIds::ARCADE) != platforms.end();
 
-		// we won't iterate all collections
-		if ((*sysIt)->isGameSystem() && !(*sysIt)->isCollection()) 
-		{
-			std::vector<FileData*> files = (*sysIt)->getRootFolder()->getFilesRecursive(GAME);
-			for(auto gameIt = files.cbegin(); gameIt != files.cend(); gameIt++)
-			{
-				std::string systemarcadename;
+	// the preview games are replaced
+	clearCollection(sysData);
 
-				bool include = includeFileInAutoCollections((*gameIt));
-				switch(sysDecl.type) 
-				{
-					case AUTO_LAST_PLAYED:
-						include = include && (*gameIt)->getMetadata().get("playcount") > "0";
-						break;
-					case AUTO_NEVER_PLAYED:
-						include = include && !((*gameIt)->getMetadata("playcount") > "0");
-						break;
-					case AUTO_FAVORITES:
-						// we may still want to add files we don't want in auto collections in "favorites"
-						include = (*gameIt)->getMetadata().get("favorite") == "true";
-						break;
-					case AUTO_ARCADE:
-						include = include && isArcade;
-						break;
-					case CPS1_COLLECTION:
-						systemarcadename = "cps1";
-						break;
-					case CPS2_COLLECTION:
-						systemarcadename = "cps2";
-						break;
-					case CPS3_COLLECTION:
-						systemarcadename = "cps3";
-						break;
-					case CAVE_COLLECTION:
-						systemarcadename = "cave";
-						break;
-					case NEOGEO_COLLECTION:
-						systemarcadename = "neogeo";
-						break;
-					case SEGA_COLLECTION:
-						systemarcadename = "sega";
-						break;
-					case IREM_COLLECTION:
-						systemarcadename = "irem";
-						break;
-					case MIDWAY_COLLECTION:
-						systemarcadename = "midway";
-						break;
-					case CAPCOM_COLLECTION:
-						systemarcadename = "capcom";
-						break;
-					case TECMO_COLLECTION:
-						systemarcadename = "techmo";
-						break;
-					case SNK_COLLECTION:
-						systemarcadename = "snk";
-						break;
-					case NAMCO_COLLECTION:
-						systemarcadename = "namco";
-						break;
-					case TAITO_COLLECTION:
-						systemarcadename = "taito";
-						break;
-					case KONAMI_COLLECTION:
-						systemarcadename = "konami";
-						break;
-					case JALECO_COLLECTION:
-						systemarcadename = "jaleco";
-						break;
-					case ATARI_COLLECTION:
-						systemarcadename = "atari";
-						break;
-					case NINTENDO_COLLECTION:
-						systemarcadename = "nintendo";
-						break;
-					case SAMMY_COLLECTION:
-						systemarcadename = "sammy";
-						break;
-					case ACCLAIM_COLLECTION:
-						systemarcadename = "acclaim";
-						break;
-					case PSIKYO_COLLECTION:
-						systemarcadename = "psikyo";
-						break;
-					case KANEKO_COLLECTION:
-						systemarcadename = "kaneko";
-						break;
-					case COLECO_COLLECTION:
-						systemarcadename = "coleco";
-						break;
-					case ATLUS_COLLECTION:
-						systemarcadename = "atlus";
-						break;
-					case BANPRESTO_COLLECTION:
-						systemarcadename = "banpresto";
-						break;
-
-					case AUTO_AT2PLAYERS:
-					case AUTO_AT4PLAYERS:
-					{
-						std::string players = (*gameIt)->getMetadata("players");
-						if (players.empty())
-							include = false;
-						else
-						{
-							int min = -1;
-
-							auto split = players.rfind("+");
-							if (split != std::string::npos)
-								players = Utils::String::replace(players, "+", "-999");
-
-							split = players.rfind("-");
-							if (split != std::string::npos)
-							{
-								min = atoi(players.substr(0, split).c_str());
-								players = players.substr(split + 1);
-							}
-
-							int max = atoi(players.c_str());
-							int val = (sysDecl.type == AUTO_AT2PLAYERS ? 2 : 4);
-							include = min <= 0 ? (val == max) : (min <= val && val <= max);
-						}
-					}
-					break;
-				}
-
-				if (!systemarcadename.empty())
-					include = isArcade && (*gameIt)->getMetadata("arcadesystemname") == systemarcadename;
-
-				if (include) 
-				{
-					CollectionFileData* newGame = new CollectionFileData(*gameIt, newSys);
-					rootFolder->addChild(newGame);
-					newSys->addToIndex(newGame);
-				}
-			}
+	const std::vector<FileData*>* games = getAutoCollectionGames(getAutoCollectionIndex(), sysDecl.type);
+	if (games != nullptr)
+	{
+		for (auto game : *games)
+		{
+			CollectionFileData* newGame = new CollectionFileData(game, newSys);
+			rootFolder->addChild(newGame);
+			newSys->addToIndex(newGame);
 		}
 	}
+
 	if (sysDecl.type == AUTO_LAST_PLAYED)
 	{
 		sortLastPlayed(newSys);
@@ -1009,6 +1065,196 @@ void CollectionSystemManager::populateAutoCollection(CollectionSystemData* sysDa
 	}
 
 	sysData->isPopulated = true;
+	newSys->updateDisplayedGameCount();
+}
+
+// the first games of an Automatic Collection System, not indexed, until it's populated
+void CollectionSystemManager::updateAutoCollectionPreview(CollectionSystemData* sysData)
+{
+	if (sysData->isPopulated)
+		return;
+
+	clearCollection(sysData);
+
+	const std::vector<FileData*>* games = getAutoCollectionGames(getAutoCollectionIndex(), sysData->decl.type);
+	if (games == nullptr)
+		return;
+
+	SystemData* newSys = sysData->system;
+	FolderData* rootFolder = newSys->getRootFolder();
+
+	std::vector<FileData*> previews(games->cbegin(), games->cbegin() + std::min(games->size(), (size_t)COLLECTION_PREVIEW_MAX));
+
+	if (sysData->decl.type == AUTO_LAST_PLAYED && games->size() > previews.size())
+	{
+		// the most recently played ones, as the populated collection shows them
+		const FileSorts::SortType& sort = FileSorts::getSortTypes().at(FileSorts::LASTPLAYED_DESCENDING);
+
+		previews = *games;
+		std::partial_sort(previews.begin(), previews.begin() + COLLECTION_PREVIEW_MAX, previews.end(),
+			[&sort](FileData* a, FileData* b) { return sort.ascending ? sort.comparisonFunction(a, b) : sort.comparisonFunction(b, a); });
+
+		previews.resize(COLLECTION_PREVIEW_MAX);
+	}
+
+	for (auto game : previews)
+		rootFolder->addChild(new CollectionFileData(game, newSys));
+}
+
+void CollectionSystemManager::updateAutoCollectionPreviews()
+{
+	for (auto it = mAutoCollectionSystemsData.begin(); it != mAutoCollectionSystemsData.end(); it++)
+	{
+		if (it->second.isPopulated)
+			continue;
+
+		if (it->second.isEnabled)
+			updateAutoCollectionPreview(&it->second);
+		else if (it->second.system->getRootFolder()->getChildren().size() > 0)
+			clearCollection(&it->second); // disabled since its previews were made
+	}
+}
+
+void CollectionSystemManager::clearCollection(CollectionSystemData* sysData)
+{
+	SystemData* system = sysData->system;
+
+	auto& childs = system->getRootFolder()->getChildren();
+	while (childs.size() > 0)
+	{
+		FileData* game = childs.back();
+
+		// previews are not indexed
+		if (sysData->isPopulated)
+			system->removeFromIndex(game);
+
+		// removes itself from the root folder
+		delete game;
+	}
+
+	sysData->isPopulated = false;
+	system->updateDisplayedGameCount();
+}
+
+void CollectionSystemManager::releaseAutoCollection(CollectionSystemData* sysData)
+{
+	LOG(LogDebug) << "CollectionSystemManager::releaseAutoCollection() - " << sysData->system->getName();
+
+	ViewController::get()->removeGameListView(sysData->system);
+	clearCollection(sysData);
+
+	if (sysData->isEnabled)
+		updateAutoCollectionPreview(sysData);
+
+	auto it = std::find(mOpenedAutoCollections.begin(), mOpenedAutoCollections.end(), sysData);
+	if (it != mOpenedAutoCollections.end())
+		mOpenedAutoCollections.erase(it);
+}
+
+void CollectionSystemManager::populateCollection(SystemData* system)
+{
+	if (!system->isCollection())
+		return;
+
+	auto it = mAutoCollectionSystemsData.find(system->getName());
+	if (it == mAutoCollectionSystemsData.end() || it->second.system != system)
+		return;
+
+	CollectionSystemData* sysData = &it->second;
+
+	auto opened = std::find(mOpenedAutoCollections.begin(), mOpenedAutoCollections.end(), sysData);
+	if (opened != mOpenedAutoCollections.end())
+		mOpenedAutoCollections.erase(opened);
+
+	mOpenedAutoCollections.push_back(sysData);
+
+	if (sysData->isPopulated)
+		return;
+
+	// before populating : releaseCollections() would take this one too
+	checkMemoryPressure();
+	populateAutoCollection(sysData);
+
+	// keeps the least recently opened ones as previews, but not the one on screen
+	std::shared_ptr<GuiComponent> currentView = ViewController::get()->getCurrentView();
+
+	for (auto old = mOpenedAutoCollections.begin(); mOpenedAutoCollections.size() > OPENED_AUTO_COLLECTIONS_MAX && *old != sysData; )
+	{
+		std::shared_ptr<IGameListView> view = ViewController::get()->getGameListView((*old)->system, false);
+		if (view != nullptr && view == currentView)
+		{
+			old++;
+			continue;
+		}
+
+		releaseAutoCollection(*old);
+		old = mOpenedAutoCollections.begin();
+	}
+}
+
+bool CollectionSystemManager::isUnpopulatedAutoCollection(SystemData* system)
+{
+	auto it = mAutoCollectionSystemsData.find(system->getName());
+	return it != mAutoCollectionSystemsData.cend() && it->second.system == system && !it->second.isPopulated;
+}
+
+int CollectionSystemManager::getUnpopulatedGameCount(SystemData* system)
+{
+	if (!isUnpopulatedAutoCollection(system))
+		return -1;
+
+	auto it = mAutoCollectionSystemsData.find(system->getName());
+	const std::vector<FileData*>* games = getAutoCollectionGames(getAutoCollectionIndex(), it->second.decl.type);
+	if (games == nullptr)
+		return 0;
+
+	// same filters as FolderData::getFilesRecursive() for the displayed games
+	bool showHiddenFiles = Settings::getInstance()->getBool("ShowHiddenFiles") && !UIModeController::getInstance()->isUIModeKiosk();
+	bool filterKidGame = UIModeController::getInstance()->isUIModeKid();
+
+	int count = 0;
+	for (auto game : *games)
+	{
+		if (!showHiddenFiles && game->getHidden())
+			continue;
+
+		if (filterKidGame && game->getKidGame())
+			continue;
+
+		count++;
+	}
+
+	if (it->second.decl.type == AUTO_LAST_PLAYED && count > LAST_PLAYED_MAX)
+		count = LAST_PLAYED_MAX;
+
+	return count;
+}
+
+void CollectionSystemManager::checkMemoryPressure()
+{
+	long long available = getAvailableMemory();
+	if (available < 0 || available >= LOW_MEMORY_THRESHOLD)
+		return;
+
+	LOG(LogInfo) << "CollectionSystemManager::checkMemoryPressure() - " << (available / 1024 / 1024) << " MB available, releasing the collections";
+	releaseCollections();
+}
+
+void CollectionSystemManager::releaseCollections()
+{
+	std::shared_ptr<GuiComponent> currentView = ViewController::get()->getCurrentView();
+
+	for (auto it = mAutoCollectionSystemsData.begin(); it != mAutoCollectionSystemsData.end(); it++)
+	{
+		if (!it->second.isPopulated)
+			continue;
+
+		std::shared_ptr<IGameListView> view = ViewController::get()->getGameListView(it->second.system, false);
+		if (view != nullptr && view == currentView)
+			continue;
+
+		releaseAutoCollection(&it->second);
+	}
 }
 
 // populates a Custom Collection System
@@ -1031,13 +1277,11 @@ void CollectionSystemManager::populateCustomCollection(CollectionSystemData* sys
 	// get Configuration for this Custom System
 	std::ifstream input(path);
 
-	FolderData* folder = getAllGamesCollection()->getRootFolder();
-
 	std::unordered_map<std::string, FileData*> map;
 
 	if (pMap == nullptr)
 	{		
-		folder->createChildrenByFilenameMap(map);
+		createGamesByPathMap(map);
 		pMap = &map;
 	}
 
@@ -1099,24 +1343,21 @@ void CollectionSystemManager::addEnabledCollectionsToDisplayedSystems(std::map<s
 		LOG(LogInfo) << "CollectionSystemManager::addEnabledCollectionsToDisplayedSystems() - Collection threaded loading";
 		std::vector<CollectionSystemData*> collectionsToPopulate;
 		for (auto it = colSystemData->begin(); it != colSystemData->end(); it++)
-			if (it->second.isEnabled && !it->second.isPopulated)
+			if (it->second.isEnabled && !it->second.isPopulated && it->second.decl.isCustom)
 				collectionsToPopulate.push_back(&(it->second));
 
 		if (collectionsToPopulate.size() > 1)
 		{
-			getAllGamesCollection();
+			getAutoCollectionIndex();
 
-			Utils::ThreadPool pool;
+			Utils::TaskGroup collectionLoading;
 
 			for (auto collection : collectionsToPopulate)
 			{
-				if (collection->decl.isCustom)
-					pool.queueWorkItem([this, collection, pMap] { populateCustomCollection(collection, pMap); });
-				else
-					pool.queueWorkItem([this, collection, pMap] { populateAutoCollection(collection); });
+				collectionLoading.run([this, collection, pMap] { populateCustomCollection(collection, pMap); });
 			}
 
-			pool.wait();
+			collectionLoading.wait();
 		}
 	}
 	// add auto enabled ones
@@ -1125,7 +1366,7 @@ void CollectionSystemManager::addEnabledCollectionsToDisplayedSystems(std::map<s
 		if(!it->second.isEnabled)
 			continue;
 
-		// check if populated, otherwise populate
+		// check if populated, otherwise populate. Auto collections are populated when their gamelist is opened
 		if (!it->second.isPopulated)
 		{
 			if(it->second.decl.isCustom)
@@ -1134,7 +1375,7 @@ void CollectionSystemManager::addEnabledCollectionsToDisplayedSystems(std::map<s
 			}
 			else
 			{
-				populateAutoCollection(&(it->second));
+				updateAutoCollectionPreview(&(it->second));
 			}
 		}
 		// check if it has its own view
@@ -3,6 +3,8 @@
 #define ES_APP_COLLECTION_SYSTEM_MANAGER_H
 
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -63,6 +65,21 @@ struct CollectionSystemDecl
 	bool displayIfEmpty;
 };
 
+// Members of every auto collection, found in a single pass over the games of all the systems
+struct AutoCollectionIndex
+{
+	std::vector<std::pair<SystemData*, unsigned int>> systems; // systems indexed, with the tree version of their root folder
+
+	std::vector<FileData*> allGames;
+	std::vector<FileData*> played;
+	std::vector<FileData*> neverPlayed;
+	std::vector<FileData*> favorites;
+	std::vector<FileData*> arcade;
+	std::vector<FileData*> twoPlayers;
+	std::vector<FileData*> fourPlayers;
+	std::unordered_map<std::string, std::vector<FileData*>> arcadeSystemNames; // games of the arcade systems, by arcadesystemname
+};
+
 struct CollectionSystemData
 {
 	SystemData* system;
@@ -113,6 +130,14 @@ public:
 	void updateCollectionFolderMetadata(SystemData* sys);
 	void populateAutoCollection(CollectionSystemData* sysData);
 
+	// Enabled auto collections are only populated when their gamelist is opened : until then, their root folder
+	// only holds the first games (for the system view), and the number of games comes from the index.
+	void populateCollection(SystemData* system);
+	int getUnpopulatedGameCount(SystemData* system); // -1 if the collection is populated
+	bool isUnpopulatedAutoCollection(SystemData* system);
+	void releaseCollections(); // memory pressure : back to previews, except the collection on screen
+	void checkMemoryPressure(); // releaseCollections() when little memory is left (SDL_APP_LOWMEMORY is mobile only)
+
 private:
 	static CollectionSystemManager* sInstance;
 	SystemEnvironmentData* mCollectionEnvData;
@@ -126,7 +151,6 @@ private:
 
 	void initAutoCollectionSystems();
 	void initCustomCollectionSystems();
-	SystemData* getAllGamesCollection();
 	SystemData* createNewCollectionEntry(std::string name, CollectionSystemDecl sysDecl, bool index = true);
 	
 	void populateCustomCollection(CollectionSystemData* sysData, std::unordered_map<std::string, FileData*>* pMap = nullptr);
@@ -147,6 +171,24 @@ private:
 
 	bool includeFileInAutoCollections(FileData* file);
 
+	// Rebuilt when a system is added, removed, or gets or loses games. Metadata changes, edited or scraped, are applied by refreshCollectionSystems()
+	AutoCollectionIndex* getAutoCollectionIndex();
+	void indexAutoCollectionGame(AutoCollectionIndex* index, FileData* game, bool isArcade);
+	void unindexAutoCollectionGame(AutoCollectionIndex* index, FileData* game);
+
+	std::unique_ptr<AutoCollectionIndex> mAutoCollectionIndex;
+	std::mutex mAutoCollectionIndexLock;
+
+	const std::vector<FileData*>* getAutoCollectionGames(AutoCollectionIndex* index, CollectionSystemType type);
+	void createGamesByPathMap(std::unordered_map<std::string, FileData*>& map);
+
+	void updateAutoCollectionPreview(CollectionSystemData* sysData);
+	void updateAutoCollectionPreviews();
+	void clearCollection(CollectionSystemData* sysData);
+	void releaseAutoCollection(CollectionSystemData* sysData);
+
+	std::vector<CollectionSystemData*> mOpenedAutoCollections; // populated by populateCollection(), least recently opened first
+
 	SystemData* mCustomCollectionsBundle;
 };
 
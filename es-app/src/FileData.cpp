@@ -17,13 +17,17 @@
 #include "Window.h"
 #include "views/UIModeController.h"
 #include <assert.h>
+#include <atomic>
 #include "Gamelist.h"
 #include <algorithm>
 
 FileData::FileData(FileType type, const std::string& path, SystemData* system)
 	: mType(type), mSystem(system), mParent(NULL), mMetadata(type == GAME ? GAME_METADATA : FOLDER_METADATA) // metadata is REALLY set in the constructor!
 {
-	mPath = Utils::FileSystem::createRelativePath(path, getSystemEnvData()->mStartPath, false);
+	const std::string& startPath = getSystemEnvData()->mStartPath;
+
+	std::string relativePath = Utils::FileSystem::createRelativePath(path, startPath, false);
+	mPath = relativePath.empty() ? startPath : Utils::FileSystem::resolveRelativePath(relativePath, startPath, true);
 	
 //	TRACE("FileData : " << mPath);
 
@@ -34,12 +38,9 @@ FileData::FileData(FileType type, const std::string& path, SystemData* system)
 	mMetadata.resetChangedFlag();
 }
 
-const std::string FileData::getPath() const
-{ 	
-	if (mPath.empty())
-		return getSystemEnvData()->mStartPath;
-
-	return Utils::FileSystem::resolveRelativePath(mPath, getSystemEnvData()->mStartPath, true);	
+const std::string& FileData::getPath() const
+{
+	return mPath;
 }
 
 inline SystemEnvironmentData* FileData::getSystemEnvData() const
@@ -61,6 +62,14 @@ FileData::~FileData()
 		mSystem->removeFromIndex(this);	
 }
 
+FileSorts::SortKeys& FileData::getSortKeys() const
+{
+	if (mSortKeys == nullptr)
+		mSortKeys.reset(new FileSorts::SortKeys());
+
+	return *mSortKeys;
+}
+
 std::string FileData::getDisplayName() const
 {
 	std::string stem = Utils::FileSystem::getStem(getPath());
@@ -75,6 +84,13 @@ std::string FileData::getCleanName() const
 	return Utils::String::removeParenthesis(this->getDisplayName());
 }
 
+// Path of the local art <start path>/images/<fileName>, empty if it doesn't exist. Answered by the media index of the system
+static std::string findLocalMedia(SystemEnvironmentData* envData, const std::string& fileName)
+{
+	bool found = envData->mMediaIndex != nullptr ? envData->mMediaIndex->exists("images", fileName) : Utils::FileSystem::exists(envData->mStartPath + "/images/" + fileName);
+	return found ? envData->mStartPath + "/images/" + fileName : "";
+}
+
 const std::string FileData::getThumbnailPath()
 {
 	std::string thumbnail = getMetadata().get("thumbnail");
@@ -87,39 +103,21 @@ const std::string FileData::getThumbnailPath()
 		// no image, try to use local image
 		if(thumbnail.empty() && Settings::getInstance()->getBool("LocalArt"))
 		{
+			std::string name = getDisplayName();
+
 			const char* extList[2] = { ".png", ".jpg" };
-			for(int i = 0; i < 2; i++)
+			for(int i = 0; i < 2 && thumbnail.empty(); i++)
 			{
-				if(thumbnail.empty())
-				{
-					std::string path = getSystemEnvData()->mStartPath + "/images/" + getDisplayName() + "-thumb" + extList[i];
-					if (Utils::FileSystem::exists(path))
-					{
-						setMetadata("thumbnail", path);
-						thumbnail = path;
-					}
-				}
+				thumbnail = findLocalMedia(getSystemEnvData(), name + "-thumb" + extList[i]);
+				if (!thumbnail.empty())
+					setMetadata("thumbnail", thumbnail);
 			}
-		}
 
-		if (thumbnail.empty())
-			thumbnail = getMetadata().get("image");
-
-		// no image, try to use local image
-		if (thumbnail.empty() && Settings::getInstance()->getBool("LocalArt"))
-		{
-			const char* extList[2] = { ".png", ".jpg" };
-			for (int i = 0; i < 2; i++)
+			for (int i = 0; i < 2 && thumbnail.empty(); i++)
 			{
+				thumbnail = findLocalMedia(getSystemEnvData(), name + "-image" + extList[i]);
 				if (thumbnail.empty())
-				{
-					std::string path = getSystemEnvData()->mStartPath + "/images/" + getDisplayName() + "-image" + extList[i];					
-					if (!Utils::FileSystem::exists(path))
-						path = getSystemEnvData()->mStartPath + "/images/" + getDisplayName() + extList[i];
-
-					if (Utils::FileSystem::exists(path))
-						thumbnail = path;
-				}
+					thumbnail = findLocalMedia(getSystemEnvData(), name + extList[i]);
 			}
 		}
 	}
@@ -188,12 +186,9 @@ const std::string FileData::getVideoPath()
 	// no video, try to use local video
 	if(video.empty() && Settings::getInstance()->getBool("LocalArt"))
 	{
-		std::string path = getSystemEnvData()->mStartPath + "/images/" + getDisplayName() + "-video.mp4";
-		if (Utils::FileSystem::exists(path))
-		{
-			setMetadata("video", path);
-			video = path;
-		}
+		video = findLocalMedia(getSystemEnvData(), getDisplayName() + "-video.mp4");
+		if (!video.empty())
+			setMetadata("video", video);
 	}
 	
 	return video;
@@ -206,18 +201,14 @@ const std::string FileData::getMarqueePath()
 	// no marquee, try to use local marquee
 	if (marquee.empty() && Settings::getInstance()->getBool("LocalArt"))
 	{
+		std::string name = getDisplayName();
+
 		const char* extList[2] = { ".png", ".jpg" };
-		for(int i = 0; i < 2; i++)
+		for(int i = 0; i < 2 && marquee.empty(); i++)
 		{
-			if(marquee.empty())
-			{
-				std::string path = getSystemEnvData()->mStartPath + "/images/" + getDisplayName() + "-marquee" + extList[i];
-				if(Utils::FileSystem::exists(path))
-				{
-					setMetadata("marquee", path);
-					marquee = path;
-				}
-			}
+			marquee = findLocalMedia(getSystemEnvData(), name + "-marquee" + extList[i]);
+			if (!marquee.empty())
+				setMetadata("marquee", marquee);
 		}
 	}
 
@@ -235,18 +226,14 @@ const std::string FileData::getImagePath()
 		if (romExt == ".png" || (getSystemName() == "pico8" && romExt == ".p8"))
 			return getPath();
 			
+		std::string name = getDisplayName();
+
 		const char* extList[2] = { ".png", ".jpg" };
-		for(int i = 0; i < 2; i++)
+		for(int i = 0; i < 2 && image.empty(); i++)
 		{
-			if(image.empty())
-			{
-				std::string path = getSystemEnvData()->mStartPath + "/images/" + getDisplayName() + "-image" + extList[i];
-				if(Utils::FileSystem::exists(path))
-				{
-						setMetadata("image", path);
-						image = path;
-				}
-			}
+			image = findLocalMedia(getSystemEnvData(), name + "-image" + extList[i]);
+			if (!image.empty())
+				setMetadata("image", image);
 		}
 	}
 
@@ -391,7 +378,7 @@ SystemEnvironmentData* CollectionFileData::getSystemEnvData() const
 	return mSourceFileData->getSystemEnvData();
 }
 
-const std::string CollectionFileData::getPath() const
+const std::string& CollectionFileData::getPath() const
 {
 	return mSourceFileData->getPath();
 }
@@ -438,10 +425,29 @@ const std::string CollectionFileData::getName()
 	return Utils::String::removeParenthesis(mSourceFileData->getMetadata().get("name"));
 }
 
-const std::vector<FileData*> FolderData::getChildrenListToDisplay() 
+static const FileSorts::SortType& getDisplaySortType(unsigned int sortId)
 {
-	std::vector<FileData*> ret;
+	if (sortId >= FileSorts::getSortTypes().size())
+		sortId = 0;
+
+	return FileSorts::getSortTypes().at(sortId);
+}
+
+// Display order for a sort type : descending sorts are the ascending comparison with the operands swapped
+struct DisplayOrder
+{
+	DisplayOrder(const FileSorts::SortType& sort) : mSort(sort) { }
+
+	bool operator()(const FileData* a, const FileData* b) const
+	{
+		return mSort.ascending ? mSort.comparisonFunction(a, b) : mSort.comparisonFunction(b, a);
+	}
+
+	const FileSorts::SortType& mSort;
+};
 
+const std::vector<FileData*> FolderData::getChildrenListToDisplay() 
+{
 	std::string showFoldersMode = Settings::getInstance()->getString("FolderViewMode");
 	
 	bool showHiddenFiles = Settings::getInstance()->getBool("ShowHiddenFiles");
@@ -458,78 +464,210 @@ const std::vector<FileData*> FolderData::getChildrenListToDisplay()
 
 	auto sys = CollectionSystemManager::get()->getSystemToView(mSystem);
 
-	std::vector<std::string> hiddenExts;
+	std::string hiddenExtSetting;
 	if (!mSystem->isGroupSystem() && !mSystem->isCollection())
-		hiddenExts = Utils::String::split(Utils::String::toLower(Settings::getInstance()->getString(mSystem->getName() + ".HiddenExt")), ';');
+		hiddenExtSetting = Settings::getInstance()->getString(mSystem->getName() + ".HiddenExt");
 
 	FileFilterIndex* idx = sys->getIndex(false);
 	if (idx != nullptr && !idx->isFiltered())
 		idx = nullptr;
 
-	std::vector<FileData*>* items = &mChildren;
+	DisplayListCache* cache = mDisplayList.get();
+
+	bool sameContext = cache != nullptr &&
+		cache->system == sys &&
+		cache->sortId == sys->getSortId() &&
+		cache->sortGeneration == FileSorts::getGeneration() &&
+		cache->filterIndex == idx &&
+		(idx == nullptr || cache->filterVersion == idx->getFilterVersion()) &&
+		cache->showHiddenFiles == showHiddenFiles &&
+		cache->filterKidGame == filterKidGame &&
+		cache->folderViewMode == showFoldersMode &&
+		cache->hiddenExtSetting == hiddenExtSetting &&
+		cache->treeVersion == mTreeVersion;
+
+	if (!sameContext)
+	{
+		if (cache == nullptr)
+		{
+			cache = new DisplayListCache();
+			mDisplayList.reset(cache);
+		}
+
+		cache->system = sys;
+		cache->sortId = sys->getSortId();
+		cache->sortGeneration = FileSorts::getGeneration();
+		cache->filterIndex = idx;
+		cache->filterVersion = idx == nullptr ? 0 : idx->getFilterVersion();
+		cache->showHiddenFiles = showHiddenFiles;
+		cache->filterKidGame = filterKidGame;
+		cache->folderViewMode = showFoldersMode;
+		cache->treeVersion = mTreeVersion;
+
+		if (cache->hiddenExtSetting != hiddenExtSetting || cache->hiddenExts.empty())
+		{
+			cache->hiddenExtSetting = hiddenExtSetting;
+			cache->hiddenExts.clear();
+
+			if (!hiddenExtSetting.empty())
+				cache->hiddenExts = Utils::String::split(Utils::String::toLower(hiddenExtSetting), ';');
+		}
+
+		rebuildDisplayList();
+	}
+	else if (!updateDisplayList())
+		rebuildDisplayList();
+
+	return cache->items;
+}
+
+void FolderData::resolveDisplayCandidate(DisplayCandidate& candidate)
+{
+	DisplayListCache* cache = mDisplayList.get();
+	FileData* item = candidate.source;
+
+	candidate.shown = nullptr;
+	candidate.uniqueGame = nullptr;
+	candidate.version = item->getMetadata().getVersion();
+	candidate.uniqueGameVersion = 0;
+
+	FileFilterIndex* idx = cache->filterIndex;
+
+	if (idx != nullptr && !idx->showFile(item))
+		return;
+
+	if (!cache->showHiddenFiles && item->getHidden())
+		return;
+
+	if (cache->filterKidGame && !item->getKidGame())
+		return;
+
+	if (cache->hiddenExts.size() > 0 && item->getType() == GAME)
+	{
+		std::string extlow = Utils::String::toLower(Utils::FileSystem::getExtension(item->getFileName(), false));
+		if (std::find(cache->hiddenExts.cbegin(), cache->hiddenExts.cend(), extlow) != cache->hiddenExts.cend())
+			return;
+	}
+
+	if (item->getType() == FOLDER && cache->folderViewMode == "having multiple games")
+	{
+		FolderData* pFolder = (FolderData*)item;
+		auto fd = pFolder->findUniqueGameForFolder();
+		if (fd != nullptr)
+		{
+			candidate.uniqueGame = fd;
+			candidate.uniqueGameVersion = fd->getMetadata().getVersion();
+
+			if (idx != nullptr && !idx->showFile(fd))
+				return;
+
+			if (!cache->showHiddenFiles && fd->getHidden())
+				return;
+
+			if (cache->filterKidGame && !fd->getKidGame())
+				return;
+
+			candidate.shown = fd;
+			return;
+		}
+	}
+
+	candidate.shown = item;
+}
+
+void FolderData::rebuildDisplayList()
+{
+	DisplayListCache* cache = mDisplayList.get();
 
 	std::vector<FileData*> flatGameList;
-	if (showFoldersMode == "never")
+	if (cache->folderViewMode == "never")
+		flatGameList = getFilesRecursive(GAME, false, cache->system);
+
+	const std::vector<FileData*>& sources = cache->folderViewMode == "never" ? flatGameList : mChildren;
+
+	cache->candidates.clear();
+	cache->candidates.reserve(sources.size());
+	cache->items.clear();
+	cache->items.reserve(sources.size());
+
+	for (auto source : sources)
 	{
-		flatGameList = getFlatGameList(false, sys);
-		items = &flatGameList;
+		DisplayCandidate candidate;
+		candidate.source = source;
+		resolveDisplayCandidate(candidate);
+
+		cache->candidates.push_back(candidate);
+
+		if (candidate.shown != nullptr)
+			cache->items.push_back(candidate.shown);
 	}
 
-	bool refactorUniqueGameFolders = (showFoldersMode == "having multiple games");
+	std::sort(cache->items.begin(), cache->items.end(), DisplayOrder(getDisplaySortType(cache->sortId)));
+}
+
+// Moves, adds or removes the entries whose metadata changed since the list was built. Returns false when a full rebuild is cheaper.
+bool FolderData::updateDisplayList()
+{
+	DisplayListCache* cache = mDisplayList.get();
 
-	for (auto it = items->cbegin(); it != items->cend(); it++)
+	std::vector<size_t> changed;
+	for (size_t i = 0; i < cache->candidates.size(); i++)
 	{
-		if (idx != nullptr && !idx->showFile((*it)))
-			continue;
+		const DisplayCandidate& candidate = cache->candidates[i];
 
-		if (!showHiddenFiles && (*it)->getHidden())
-			continue;
+		// With an active filter, a folder is shown when one of its games is : that can change without the folder's own metadata changing
+		bool recheck = cache->filterIndex != nullptr && candidate.source->getType() == FOLDER;
 
-		if (filterKidGame && !(*it)->getKidGame())
-			continue;
+		if (recheck || candidate.version != candidate.source->getMetadata().getVersion() ||
+			(candidate.uniqueGame != nullptr && candidate.uniqueGameVersion != candidate.uniqueGame->getMetadata().getVersion()))
+			changed.push_back(i);
+	}
 
-		if (hiddenExts.size() > 0 && (*it)->getType() == GAME)
-		{
-			std::string extlow = Utils::String::toLower(Utils::FileSystem::getExtension((*it)->getFileName(), false));
-			if (std::find(hiddenExts.cbegin(), hiddenExts.cend(), extlow) != hiddenExts.cend())
-				continue;
-		}
+	if (changed.size() == 0)
+		return true;
 
-		if ((*it)->getType() == FOLDER && refactorUniqueGameFolders)
-		{
-			FolderData* pFolder = (FolderData*)(*it);
-			auto fd = pFolder->findUniqueGameForFolder();
-			if (fd != nullptr)
-			{
-				if (idx != nullptr && !idx->showFile(fd))
-					continue;
+	if (changed.size() > 64 && changed.size() > cache->items.size() / 8)
+		return false;
 
-				if (!showHiddenFiles && fd->getHidden())
-					continue;
+	std::vector<FileData*> inserted;
 
-				if (filterKidGame && !fd->getKidGame())
-					continue;
+	for (auto index : changed)
+	{
+		DisplayCandidate& candidate = cache->candidates[index];
+		DisplayCandidate previous = candidate;
 
-				ret.push_back(fd);
+		resolveDisplayCandidate(candidate);
 
-				continue;
-			}
+		if (candidate.shown == previous.shown && candidate.version == previous.version && candidate.uniqueGameVersion == previous.uniqueGameVersion)
+			continue;
+
+		if (previous.shown != nullptr)
+		{
+			auto it = std::find(cache->items.begin(), cache->items.end(), previous.shown);
+			if (it != cache->items.end())
+				cache->items.erase(it);
 		}
 
-		ret.push_back(*it);
+		if (candidate.shown != nullptr)
+			inserted.push_back(candidate.shown);
 	}
 
-	unsigned int currentSortId = sys->getSortId();
-	if (currentSortId >= FileSorts::getSortTypes().size())
-		currentSortId = 0;
+	// The remaining items kept their sort keys, so they're still in order
+	DisplayOrder order(getDisplaySortType(cache->sortId));
+	for (auto item : inserted)
+		cache->items.insert(std::upper_bound(cache->items.begin(), cache->items.end(), item, order), item);
 
-	const FileSorts::SortType& sort = FileSorts::getSortTypes().at(currentSortId);
-	std::sort(ret.begin(), ret.end(), sort.comparisonFunction);
+	return true;
+}
 
-	if (!sort.ascending)
-		std::reverse(ret.begin(), ret.end());
+void FolderData::treeChanged()
+{
+	// Folders of different systems are populated from several threads
+	static std::atomic<unsigned int> sTreeVersion(0);
+	unsigned int treeVersion = ++sTreeVersion;
 
-	return ret;
+	for (FolderData* folder = this; folder != nullptr; folder = folder->getParent())
+		folder->mTreeVersion = treeVersion;
 }
 
 FileData* FolderData::findUniqueGameForFolder()
@@ -628,6 +766,8 @@ void FolderData::addChild(FileData* file, bool assignParent)
 
 	if (assignParent)
 		file->setParent(this);
+
+	treeChanged();
 }
 
 void FolderData::removeChild(FileData* file)
@@ -635,12 +775,14 @@ void FolderData::removeChild(FileData* file)
 	assert(mType == FOLDER);
 	assert(file->getParent() == this);
 
-	for (auto it = mChildren.cbegin(); it != mChildren.cend(); it++)
+	// From the end : collections are emptied from their last game
+	for (auto it = mChildren.rbegin(); it != mChildren.rend(); it++)
 	{
 		if (*it == file)
 		{
 			file->setParent(NULL);
-			mChildren.erase(it);
+			mChildren.erase(std::next(it).base());
+			treeChanged();
 			return;
 		}
 	}
@@ -6,11 +6,15 @@
 #include "utils/FileSystemUtil.h"
 #include "MetaData.h"
 #include <unordered_map>
+#include <memory>
 
 class SystemData;
 class Window;
+class FileFilterIndex;
 struct SystemEnvironmentData;
 
+namespace FileSorts { struct SortKeys; }
+
 enum FileType
 {
 	GAME = 1,   // Cannot have children.
@@ -44,7 +48,8 @@ public:
 
 	inline SystemData* getSystem() const { return mSystem; }
 
-	virtual const std::string getPath() const;
+	// Absolute path, resolved once : sorts, filters and collections call it for every game
+	virtual const std::string& getPath() const;
 
 	virtual SystemEnvironmentData* getSystemEnvData() const;
 
@@ -67,7 +72,7 @@ public:
 
 	virtual std::string getKey();
 	const bool isArcadeAsset();
-	inline std::string getFullPath() { return getPath(); };
+	inline const std::string& getFullPath() { return getPath(); };
 	inline std::string getFileName() { return Utils::FileSystem::getFileName(getPath()); };
 	virtual FileData* getSourceFileData();
 	virtual std::string getSystemName() const;
@@ -90,8 +95,12 @@ public:
 	std::string getMetadata(const std::string& key) { return getMetadata().get(key); }
 	void setMetadata(const std::string& key, const std::string& value) { getMetadata().set(key, value); }
 
+	// Cache owned by FileSorts, not thread safe : a given list must not be sorted from two threads at once
+	FileSorts::SortKeys& getSortKeys() const;
+
 private:
 	MetaDataList mMetadata;
+	mutable std::unique_ptr<FileSorts::SortKeys> mSortKeys;
 
 protected:	
 	FolderData* mParent;
@@ -109,7 +118,7 @@ public:
 	void refreshMetadata();
 	FileData* getSourceFileData();
 	std::string getKey();
-	virtual const std::string getPath() const;
+	virtual const std::string& getPath() const;
 
 	virtual std::string getSystemName() const;
 	virtual SystemEnvironmentData* getSystemEnvData() const;
@@ -132,6 +141,7 @@ public:
 	{
 		mIsDisplayableAsVirtualFolder = false;
 		mOwnsChildrens = ownsChildrens;
+		mTreeVersion = 0;
 	}
 
 	~FolderData()
@@ -152,6 +162,7 @@ public:
 	FileData* FindByPath(const std::string& path);
 
 	inline const std::vector<FileData*>& getChildren() const { return mChildren; }
+	inline unsigned int getTreeVersion() const { return mTreeVersion; }
 	const std::vector<FileData*> getChildrenListToDisplay();
 	std::vector<FileData*> getFilesRecursive(unsigned int typeMask, bool displayedOnly = false, SystemData* system = nullptr) const;
 
@@ -163,11 +174,49 @@ public:
 	FileData* findUniqueGameForFolder();
 
 private:
+	// An entry that may be displayed : a child, or a game of the subtree when folders are not shown
+	struct DisplayCandidate
+	{
+		FileData*		source;
+		FileData*		shown;			// what is displayed for it (itself, or the only game of a folder), nullptr when filtered out
+		FileData*		uniqueGame;		// the only game of a folder, when folders having a single game are replaced by it
+		unsigned int	version;		// metadata versions of source and uniqueGame when they were resolved
+		unsigned int	uniqueGameVersion;
+	};
+
+	// getChildrenListToDisplay() result, kept as long as the display settings and the subtree don't change.
+	// Entries whose metadata changed (favorite, hidden, rating...) are moved or removed in place instead of rebuilding the list.
+	struct DisplayListCache
+	{
+		SystemData*			system;
+		unsigned int		sortId;
+		unsigned int		sortGeneration;
+		FileFilterIndex*	filterIndex; // nullptr when nothing is filtered
+		unsigned int		filterVersion;
+		bool				showHiddenFiles;
+		bool				filterKidGame;
+		std::string			folderViewMode;
+		std::string			hiddenExtSetting;
+		std::vector<std::string> hiddenExts;
+		unsigned int		treeVersion;
+
+		std::vector<DisplayCandidate>	candidates;
+		std::vector<FileData*>			items; // display order
+	};
+
+	void resolveDisplayCandidate(DisplayCandidate& candidate);
+	void rebuildDisplayList();
+	bool updateDisplayList();
+	void treeChanged();
+
 	std::vector<FileData*> getFlatGameList(bool displayedOnly, SystemData* system) const;
 	std::vector<FileData*> mChildren;
 
 	bool	mOwnsChildrens;
 	bool	mIsDisplayableAsVirtualFolder;
+
+	unsigned int						mTreeVersion; // changes when children are added to or removed from this folder or a subfolder
+	std::unique_ptr<DisplayListCache>	mDisplayList;
 };
 
 #endif // ES_APP_FILE_DATA_H
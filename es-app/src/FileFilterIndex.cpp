@@ -10,8 +10,12 @@
 #define UNKNOWN_LABEL "UNKNOWN"
 #define INCLUDE_UNKNOWN false;
 
+#include <algorithm>
+
+static unsigned int sFilterVersion = 0;
+
 FileFilterIndex::FileFilterIndex()
-	: filterByFavorites(false), filterByGenre(false), filterByHidden(false), filterByKidGame(false), filterByPlayers(false), filterByPubDev(false), filterByRatings(false)
+	: filterByFavorites(false), filterByGenre(false), filterByHidden(false), filterByKidGame(false), filterByPlayers(false), filterByPubDev(false), filterByRatings(false), mFilterVersion(++sFilterVersion), mSlotCount(0), mMatchesDirty(true)
 {
 	clearAllFilters();
 	FilterDataDecl filterDecls[] = {
@@ -26,6 +30,7 @@ FileFilterIndex::FileFilterIndex()
 	};
 
 	filterDataDecl = std::vector<FilterDataDecl>(filterDecls, filterDecls + sizeof(filterDecls) / sizeof(filterDecls[0]));
+	mFacets.resize(filterDataDecl.size());
 }
 
 FileFilterIndex::~FileFilterIndex()
@@ -189,6 +194,24 @@ void FileFilterIndex::addToIndex(FileData* game)
 	manageFavoritesEntryInIndex(game);
 	//manageHiddenEntryInIndex(game);
 	manageKidGameEntryInIndex(game);
+
+	if (mGameKeys.find(game) != mGameKeys.cend())
+		return;
+
+	GameKeys keys;
+	computeGameKeys(game, keys, true);
+
+	if (mFreeSlots.size() > 0)
+	{
+		keys.slot = mFreeSlots.back();
+		mFreeSlots.pop_back();
+	}
+	else
+		keys.slot = mSlotCount++;
+
+	setPostings(keys, true);
+	mGameKeys[game] = keys;
+	mMatchesDirty = true;
 }
 
 void FileFilterIndex::removeFromIndex(FileData* game)
@@ -200,6 +223,15 @@ void FileFilterIndex::removeFromIndex(FileData* game)
 	manageFavoritesEntryInIndex(game, true);
 	//manageHiddenEntryInIndex(game, true);
 	manageKidGameEntryInIndex(game, true);
+
+	auto it = mGameKeys.find(game);
+	if (it == mGameKeys.cend())
+		return;
+
+	setPostings(it->second, false);
+	mFreeSlots.push_back(it->second.slot);
+	mGameKeys.erase(it);
+	mMatchesDirty = true;
 }
 
 void FileFilterIndex::setFilter(FilterIndexType type, std::vector<std::string>* values)
@@ -225,6 +257,8 @@ void FileFilterIndex::setFilter(FilterIndexType type, std::vector<std::string>*
 				}
 			}
 		}
+
+		filtersChanged();
 	}
 	return;
 }
@@ -237,9 +271,252 @@ void FileFilterIndex::clearAllFilters()
 		*(filterData.filteredByRef) = false;
 		filterData.currentFilteredKeys->clear();
 	}
+
+	filtersChanged();
 	return;
 }
 
+void FileFilterIndex::filtersChanged()
+{
+	mFilterVersion = ++sFilterVersion;
+
+	for (size_t i = 0; i < filterDataDecl.size() && i < mFacets.size(); i++)
+	{
+		FilterFacet& facet = mFacets[i];
+		facet.selected.assign(facet.keyIds.size(), false);
+
+		for (auto& key : *filterDataDecl[i].currentFilteredKeys)
+		{
+			int id = getKeyId(i, key, true);
+			if (id < 0)
+				continue;
+
+			if (id >= (int)facet.selected.size())
+				facet.selected.resize(id + 1, false);
+
+			facet.selected[id] = true;
+		}
+	}
+
+	mMatchesDirty = true;
+}
+
+static inline void setBit(std::vector<uint64_t>& bits, int index, bool value)
+{
+	size_t word = (size_t)index / 64;
+	if (word >= bits.size())
+	{
+		if (!value)
+			return;
+
+		bits.resize(word + 1, 0);
+	}
+
+	if (value)
+		bits[word] |= (1ULL << (index % 64));
+	else
+		bits[word] &= ~(1ULL << (index % 64));
+}
+
+static inline bool testBit(const std::vector<uint64_t>& bits, int index)
+{
+	size_t word = (size_t)index / 64;
+	return word < bits.size() && (bits[word] & (1ULL << (index % 64))) != 0;
+}
+
+static inline int countBits(uint64_t value)
+{
+#if defined(__GNUC__)
+	return __builtin_popcountll(value);
+#else
+	int count = 0;
+	for (; value != 0; count++)
+		value &= value - 1;
+
+	return count;
+#endif
+}
+
+int FileFilterIndex::getKeyId(size_t facet, const std::string& key, bool create)
+{
+	if (key == UNKNOWN_LABEL)
+		return -1;
+
+	FilterFacet& data = mFacets[facet];
+
+	auto it = data.keyIds.find(key);
+	if (it != data.keyIds.cend())
+		return it->second;
+
+	if (!create)
+		return -1;
+
+	int id = (int)data.keyIds.size();
+	data.keyIds[key] = id;
+	data.postings.push_back(Bitset());
+	return id;
+}
+
+void FileFilterIndex::computeGameKeys(FileData* game, GameKeys& keys, bool create)
+{
+	keys.version = game->getMetadata().getVersion();
+	keys.slot = -1;
+
+	for (size_t i = 0; i < MAX_FILTER_TYPES; i++)
+	{
+		keys.primary[i] = -1;
+		keys.secondary[i] = -1;
+
+		if (i >= filterDataDecl.size())
+			continue;
+
+		const FilterDataDecl& decl = filterDataDecl[i];
+		keys.primary[i] = getKeyId(i, getIndexableKey(game, decl.type, false), create);
+
+		if (decl.hasSecondaryKey)
+			keys.secondary[i] = getKeyId(i, getIndexableKey(game, decl.type, true), create);
+	}
+}
+
+// Keys of an indexed game, recomputed if its metadata changed since they were stored. nullptr if the game isn't indexed.
+FileFilterIndex::GameKeys* FileFilterIndex::getIndexedGameKeys(FileData* game)
+{
+	auto it = mGameKeys.find(game);
+	if (it == mGameKeys.cend())
+		return nullptr;
+
+	GameKeys& keys = it->second;
+	if (keys.version != game->getMetadata().getVersion())
+	{
+		int slot = keys.slot;
+
+		setPostings(keys, false);
+		computeGameKeys(game, keys, true);
+		keys.slot = slot;
+		setPostings(keys, true);
+
+		if (!mMatchesDirty)
+			setBit(mMatches, slot, matchesFilters(keys));
+	}
+
+	return &keys;
+}
+
+void FileFilterIndex::setPostings(const GameKeys& keys, bool value)
+{
+	for (size_t i = 0; i < mFacets.size() && i < MAX_FILTER_TYPES; i++)
+	{
+		if (keys.primary[i] >= 0)
+			setBit(mFacets[i].postings[keys.primary[i]], keys.slot, value);
+
+		if (keys.secondary[i] >= 0 && keys.secondary[i] != keys.primary[i])
+			setBit(mFacets[i].postings[keys.secondary[i]], keys.slot, value);
+	}
+}
+
+bool FileFilterIndex::matchesFilters(const GameKeys& keys, int ignoredFacet)
+{
+	for (size_t i = 0; i < filterDataDecl.size() && i < MAX_FILTER_TYPES; i++)
+	{
+		if ((int)i == ignoredFacet || !*(filterDataDecl[i].filteredByRef))
+			continue;
+
+		const std::vector<bool>& selected = mFacets[i].selected;
+
+		int primary = keys.primary[i];
+		int secondary = keys.secondary[i];
+
+		if (primary >= 0 && primary < (int)selected.size() && selected[primary])
+			continue;
+
+		if (secondary >= 0 && secondary < (int)selected.size() && selected[secondary])
+			continue;
+
+		return false;
+	}
+
+	return true;
+}
+
+// Games having at least one of the selected keys of a filter type
+FileFilterIndex::Bitset FileFilterIndex::getFacetMatches(size_t facet)
+{
+	Bitset ret((mSlotCount + 63) / 64, 0);
+
+	const FilterFacet& data = mFacets[facet];
+	for (size_t id = 0; id < data.selected.size() && id < data.postings.size(); id++)
+	{
+		if (!data.selected[id])
+			continue;
+
+		const Bitset& posting = data.postings[id];
+		for (size_t w = 0; w < posting.size() && w < ret.size(); w++)
+			ret[w] |= posting[w];
+	}
+
+	return ret;
+}
+
+void FileFilterIndex::updateMatches()
+{
+	mMatches.assign((mSlotCount + 63) / 64, ~0ULL);
+
+	for (size_t i = 0; i < filterDataDecl.size() && i < mFacets.size(); i++)
+	{
+		if (!*(filterDataDecl[i].filteredByRef))
+			continue;
+
+		Bitset matches = getFacetMatches(i);
+		for (size_t w = 0; w < mMatches.size(); w++)
+			mMatches[w] &= matches[w];
+	}
+
+	mMatchesDirty = false;
+}
+
+std::map<std::string, int> FileFilterIndex::getFilteredCounts(FilterIndexType type)
+{
+	std::map<std::string, int> ret;
+
+	int facet = -1;
+	for (size_t i = 0; i < filterDataDecl.size(); i++)
+		if (filterDataDecl[i].type == type)
+			facet = (int)i;
+
+	if (facet < 0 || mGameKeys.size() == 0)
+		return ret;
+
+	// Bring the games edited since they were indexed up to date
+	for (auto& item : mGameKeys)
+		getIndexedGameKeys((FileData*)item.first);
+
+	Bitset others((mSlotCount + 63) / 64, ~0ULL);
+
+	for (size_t i = 0; i < filterDataDecl.size() && i < mFacets.size(); i++)
+	{
+		if ((int)i == facet || !*(filterDataDecl[i].filteredByRef))
+			continue;
+
+		Bitset matches = getFacetMatches(i);
+		for (size_t w = 0; w < others.size(); w++)
+			others[w] &= matches[w];
+	}
+
+	const FilterFacet& data = mFacets[facet];
+	for (auto& key : data.keyIds)
+	{
+		const Bitset& posting = data.postings[key.second];
+
+		int count = 0;
+		for (size_t w = 0; w < posting.size() && w < others.size(); w++)
+			count += countBits(posting[w] & others[w]);
+
+		ret[key.first] = count;
+	}
+
+	return ret;
+}
+
 void FileFilterIndex::resetFilters()
 {
 	clearAllFilters();
@@ -295,6 +572,8 @@ void FileFilterIndex::setTextFilter(const std::string text)
 	// keep both raw (for pinyin) and upper (legacy ASCII-insensitive)
 	mTextFilterRaw = text;                       // NEW
 	mTextFilter    = Utils::String::toUpper(text);
+
+	filtersChanged();
 }
 
 bool FileFilterIndex::showFile(FileData* game)
@@ -307,7 +586,7 @@ bool FileFilterIndex::showFile(FileData* game)
 	// that should be shown
 	if (game->getType() == FOLDER) 
 	{
-		std::vector<FileData*> children = ((FolderData*) game)->getChildren();
+		const std::vector<FileData*>& children = ((FolderData*) game)->getChildren();
 		// iterate through all of the children, until there's a match
 
 		for (std::vector<FileData*>::const_iterator it = children.cbegin(); it != children.cend(); ++it ) {
@@ -317,70 +596,45 @@ bool FileFilterIndex::showFile(FileData* game)
 		return false;
 	}
 
-	bool keepGoing = false;
+	bool filteredByType = false;
+	for (auto& decl : filterDataDecl)
+		if (*(decl.filteredByRef))
+			filteredByType = true;
 
-	if (!mTextFilter.empty())
+	// the text filter is only used when no other filter is active
+	if (!filteredByType)
 	{
+		if (mTextFilter.empty())
+			return false;
+
 		// 1) original case-insensitive (via upper)
 		if (Utils::String::toUpper(game->getName()).find(mTextFilter) != std::string::npos)
-			keepGoing = true;
-		else
+			return true;
+
 		// 2) fallback: pinyin-aware search (raw user query)
-		if (Utils::String::containsIgnoreCasePinyin(game->getName(), mTextFilterRaw))
-			keepGoing = true;
+		return Utils::String::containsIgnoreCasePinyin(game->getName(), mTextFilterRaw);
 	}
 
-	for (std::vector<FilterDataDecl>::const_iterator it = filterDataDecl.cbegin(); it != filterDataDecl.cend(); ++it ) {
-		FilterDataDecl filterData = (*it);
-		if(*(filterData.filteredByRef))
-		{
-			// try to find a match
-			std::string key = getIndexableKey(game, filterData.type, false);
-			keepGoing = isKeyBeingFilteredBy(key, filterData.type);
-
-			// if we didn't find a match, try for secondary keys - i.e. publisher and dev, or first genre
-			if (!keepGoing)
-			{
-				if (!filterData.hasSecondaryKey)
-				{
-					return false;
-				}
-				std::string secKey = getIndexableKey(game, filterData.type, true);
-				if (secKey != UNKNOWN_LABEL)
-				{
-					keepGoing = isKeyBeingFilteredBy(secKey, filterData.type);
-				}
-			}
-			// if still nothing, then it's not a match
-			if (!keepGoing)
-				return false;
-
-		}
+	GameKeys* keys = getIndexedGameKeys(game);
+	if (keys != nullptr)
+	{
+		if (mMatchesDirty)
+			updateMatches();
 
+		return testBit(mMatches, keys->slot);
 	}
 
-	return keepGoing;
+	// game from another system (bundled collections)
+	GameKeys unindexed;
+	computeGameKeys(game, unindexed, false);
+	return matchesFilters(unindexed);
 }
 
 bool FileFilterIndex::isKeyBeingFilteredBy(std::string key, FilterIndexType type)
 {
-	const FilterIndexType filterTypes[6] = { FAVORITES_FILTER, GENRE_FILTER, PLAYER_FILTER, PUBDEV_FILTER, RATINGS_FILTER, KIDGAME_FILTER }; // ,HIDDEN_FILTER
-	std::vector<std::string> filterKeysList[6] = { favoritesIndexFilteredKeys, genreIndexFilteredKeys, playersIndexFilteredKeys, pubDevIndexFilteredKeys, ratingsIndexFilteredKeys, kidGameIndexFilteredKeys }; // hiddenIndexFilteredKeys, 
-
-	for (int i = 0; i < 6; i++)
-	{
-		if (filterTypes[i] == type)
-		{
-			for (std::vector<std::string>::const_iterator it = filterKeysList[i].cbegin(); it != filterKeysList[i].cend(); ++it )
-			{
-				if (key == (*it))
-				{
-					return true;
-				}
-			}
-			return false;
-		}
-	}
+	for (auto& decl : filterDataDecl)
+		if (decl.type == type)
+			return std::find(decl.currentFilteredKeys->cbegin(), decl.currentFilteredKeys->cend(), key) != decl.currentFilteredKeys->cend();
 
 	return false;
 }
@@ -4,7 +4,9 @@
 #define ES_APP_FILE_FILTER_INDEX_H
 
 #include <map>
+#include <unordered_map>
 #include <vector>
+#include <stdint.h>
 
 class FileData;
 
@@ -55,6 +57,13 @@ public:
 	void setTextFilter(const std::string text);
 	inline const std::string getTextFilter() { return mTextFilter; }
 
+	// Changes whenever the active filters change
+	inline unsigned int getFilterVersion() const { return mFilterVersion; }
+
+	// For each key of 'type', the number of indexed games having it that also pass the other active filters.
+	// Empty when the index holds no games (indexes built with importIndex only have key counts).
+	std::map<std::string, int> getFilteredCounts(FilterIndexType type);
+
 private:
 	std::vector<FilterDataDecl> filterDataDecl;
 	std::string getIndexableKey(FileData* game, FilterIndexType type, bool getSecondary);
@@ -98,6 +107,45 @@ private:
 	FileData* mRootFolder;
 	std::string mTextFilter;
 	std::string mTextFilterRaw; // NEW: raw user input for pinyin matching
+
+	unsigned int mFilterVersion;
+	void filtersChanged();
+
+	// Every index key is interned to an id per filter type, and every indexed game gets a slot : the games having a key are a
+	// bitset over the slots, so filtering a whole system is a few bitset unions/intersections and a game is tested with a single bit.
+	typedef std::vector<uint64_t> Bitset;
+
+	enum { MAX_FILTER_TYPES = 8 };
+
+	struct FilterFacet
+	{
+		std::unordered_map<std::string, int>	keyIds;
+		std::vector<Bitset>						postings;	// by key id
+		std::vector<bool>						selected;	// by key id
+	};
+
+	struct GameKeys
+	{
+		unsigned int	version;	// metadata version the ids were computed from
+		int				slot;
+		int				primary[MAX_FILTER_TYPES];	// by filterDataDecl index, -1 when unknown
+		int				secondary[MAX_FILTER_TYPES];
+	};
+
+	int getKeyId(size_t facet, const std::string& key, bool create);
+	void computeGameKeys(FileData* game, GameKeys& keys, bool create);
+	GameKeys* getIndexedGameKeys(FileData* game);
+	void setPostings(const GameKeys& keys, bool value);
+	bool matchesFilters(const GameKeys& keys, int ignoredFacet = -1);
+	Bitset getFacetMatches(size_t facet);
+	void updateMatches();
+
+	std::vector<FilterFacet>						mFacets;
+	std::unordered_map<const FileData*, GameKeys>	mGameKeys;
+	std::vector<int>	mFreeSlots;
+	int					mSlotCount;
+	Bitset				mMatches;		// games passing every active filter type
+	bool				mMatchesDirty;
 };
 
 #endif // ES_APP_FILE_FILTER_INDEX_H
@@ -7,6 +7,21 @@
 namespace FileSorts
 {
 	static Singleton* sInstance = nullptr;
+	static unsigned int sGeneration = 0;
+
+	enum SortKey : unsigned int
+	{
+		KEY_NAME = 1,
+		KEY_RATING = 2,
+		KEY_TIMESPLAYED = 4,
+		KEY_PLAYERS = 8,
+		KEY_LASTPLAYED = 16,
+		KEY_RELEASEDATE = 32,
+		KEY_GENRE = 64,
+		KEY_DEVELOPER = 128,
+		KEY_PUBLISHER = 256,
+		KEY_SYSTEM = 512
+	};
 
 	Singleton* getInstance()
 	{
@@ -24,6 +39,11 @@ namespace FileSorts
 		sInstance = nullptr;
 	}
 
+	unsigned int getGeneration()
+	{
+		return getInstance()->mGeneration;
+	}
+
 	const std::vector<SortType>& getSortTypes()
 	{
 		return getInstance()->mSortTypes;
@@ -40,6 +60,11 @@ namespace FileSorts
 
 	Singleton::Singleton()
 	{
+		mGeneration = ++sGeneration;
+		mIgnoreArticles = Settings::getInstance()->getBool("IgnoreLeadingArticles");
+		if (mIgnoreArticles)
+			mArticles = Utils::String::commaStringToVector(_("A,AN,THE"));
+
 		mSortTypes.push_back(SortType(FILENAME_ASCENDING, &compareName, true, _("FILENAME, ASCENDING"), _U("\uF15d ")));
 		mSortTypes.push_back(SortType(FILENAME_DESCENDING, &compareName, false, _("FILENAME, DESCENDING"), _U("\uF15e ")));
 		mSortTypes.push_back(SortType(RATING_ASCENDING, &compareRating, true, _("RATING, ASCENDING"), _U("\uF165 ")));
@@ -62,6 +87,67 @@ namespace FileSorts
 		mSortTypes.push_back(SortType(SYSTEM_DESCENDING, &compareSystem, false, _("SYSTEM, DESCENDING"), _U("\uF15e ")));
 	}
 
+	static const SortKeys& getSortKeys(const FileData* file, SortKey key)
+	{
+		Singleton* instance = getInstance();
+		SortKeys& keys = file->getSortKeys();
+
+		const MetaDataList& metadata = file->getMetadata();
+		if (keys.version != metadata.getVersion() || keys.generation != instance->mGeneration)
+		{
+			keys.version = metadata.getVersion();
+			keys.generation = instance->mGeneration;
+			keys.validKeys = 0;
+		}
+
+		if ((keys.validKeys & key) != 0)
+			return keys;
+
+		switch (key)
+		{
+		case KEY_NAME:
+			{
+				// we use the actual metadata name, as collection files have the system appended which messes up the order
+				std::string name = ((FileData *)file)->getName();
+				if (instance->mIgnoreArticles)
+					name = stripLeadingArticle(name, instance->mArticles);
+
+				keys.name = Utils::String::ignoreCaseKey(name);
+			}
+			break;
+		case KEY_RATING:
+			keys.rating = metadata.getFloat("rating");
+			break;
+		case KEY_TIMESPLAYED:
+			keys.timesPlayed = metadata.getInt("playcount");
+			break;
+		case KEY_PLAYERS:
+			keys.players = metadata.getInt("players");
+			break;
+		case KEY_LASTPLAYED:
+			keys.lastPlayed = metadata.get("lastplayed");
+			break;
+		case KEY_RELEASEDATE:
+			keys.releaseDate = metadata.get("releasedate");
+			break;
+		case KEY_GENRE:
+			keys.genre = Utils::String::toUpper(metadata.get("genre"));
+			break;
+		case KEY_DEVELOPER:
+			keys.developer = Utils::String::toUpper(metadata.get("developer"));
+			break;
+		case KEY_PUBLISHER:
+			keys.publisher = Utils::String::toUpper(metadata.get("publisher"));
+			break;
+		case KEY_SYSTEM:
+			keys.system = Utils::String::toUpper(file->getSystemName());
+			break;
+		}
+
+		keys.validKeys |= key;
+		return keys;
+	}
+
 	//returns if file1 should come before file2
 	bool compareName(const FileData* file1, const FileData* file2)
 	{
@@ -70,17 +156,8 @@ namespace FileSorts
 			return file1->getType() == FOLDER;
 
 		}
-		// we compare the actual metadata name, as collection files have the system appended which messes up the order
-		auto name1 = ((FileData *) file1)->getName();
-		auto name2 = ((FileData *) file2)->getName();
-		const bool ignoreArticles = Settings::getInstance()->getBool("IgnoreLeadingArticles");
-		if (ignoreArticles)
-		{
-			const auto articles = Utils::String::commaStringToVector(_("A,AN,THE"));
-			name1 = stripLeadingArticle(name1, articles);
-			name2 = stripLeadingArticle(name2, articles);
-		}
-		return Utils::String::compareIgnoreCase(name1, name2) < 0;
+
+		return getSortKeys(file1, KEY_NAME).name < getSortKeys(file2, KEY_NAME).name;
 	}
 
 	std::string stripLeadingArticle(const std::string &string, const std::vector<std::string> &articles)
@@ -104,7 +181,7 @@ namespace FileSorts
 
 	bool compareRating(const FileData* file1, const FileData* file2)
 	{
-		return file1->getMetadata().getFloat("rating") < file2->getMetadata().getFloat("rating");
+		return getSortKeys(file1, KEY_RATING).rating < getSortKeys(file2, KEY_RATING).rating;
 	}
 
 	bool compareTimesPlayed(const FileData* file1, const FileData* file2)
@@ -112,7 +189,7 @@ namespace FileSorts
 		//only games have playcount metadata
 		if (file1->getMetadata().getType() == GAME_METADATA && file2->getMetadata().getType() == GAME_METADATA)
 		{
-			return (file1)->getMetadata().getInt("playcount") < (file2)->getMetadata().getInt("playcount");
+			return getSortKeys(file1, KEY_TIMESPLAYED).timesPlayed < getSortKeys(file2, KEY_TIMESPLAYED).timesPlayed;
 		}
 
 		return false;
@@ -122,46 +199,38 @@ namespace FileSorts
 	{
 		// since it's stored as an ISO string (YYYYMMDDTHHMMSS), we can compare as a string
 		// as it's a lot faster than the time casts and then time comparisons
-		return (file1)->getMetadata().get("lastplayed") < (file2)->getMetadata().get("lastplayed");
+		return getSortKeys(file1, KEY_LASTPLAYED).lastPlayed < getSortKeys(file2, KEY_LASTPLAYED).lastPlayed;
 	}
 
 	bool compareNumPlayers(const FileData* file1, const FileData* file2)
 	{
-		return (file1)->getMetadata().getInt("players") < (file2)->getMetadata().getInt("players");
+		return getSortKeys(file1, KEY_PLAYERS).players < getSortKeys(file2, KEY_PLAYERS).players;
 	}
 
 	bool compareReleaseDate(const FileData* file1, const FileData* file2)
 	{
 		// since it's stored as an ISO string (YYYYMMDDTHHMMSS), we can compare as a string
 		// as it's a lot faster than the time casts and then time comparisons
-		return (file1)->getMetadata().get("releasedate") < (file2)->getMetadata().get("releasedate");
+		return getSortKeys(file1, KEY_RELEASEDATE).releaseDate < getSortKeys(file2, KEY_RELEASEDATE).releaseDate;
 	}
 
 	bool compareGenre(const FileData* file1, const FileData* file2)
 	{
-		std::string genre1 = Utils::String::toUpper(file1->getMetadata().get("genre"));
-		std::string genre2 = Utils::String::toUpper(file2->getMetadata().get("genre"));
-		return genre1.compare(genre2) < 0;
+		return getSortKeys(file1, KEY_GENRE).genre.compare(getSortKeys(file2, KEY_GENRE).genre) < 0;
 	}
 
 	bool compareDeveloper(const FileData* file1, const FileData* file2)
 	{
-		std::string developer1 = Utils::String::toUpper(file1->getMetadata().get("developer"));
-		std::string developer2 = Utils::String::toUpper(file2->getMetadata().get("developer"));
-		return developer1.compare(developer2) < 0;
+		return getSortKeys(file1, KEY_DEVELOPER).developer.compare(getSortKeys(file2, KEY_DEVELOPER).developer) < 0;
 	}
 
 	bool comparePublisher(const FileData* file1, const FileData* file2)
 	{
-		std::string publisher1 = Utils::String::toUpper(file1->getMetadata().get("publisher"));
-		std::string publisher2 = Utils::String::toUpper(file2->getMetadata().get("publisher"));
-		return publisher1.compare(publisher2) < 0;
+		return getSortKeys(file1, KEY_PUBLISHER).publisher.compare(getSortKeys(file2, KEY_PUBLISHER).publisher) < 0;
 	}
 
 	bool compareSystem(const FileData* file1, const FileData* file2)
 	{
-		std::string system1 = Utils::String::toUpper(file1->getSystemName());
-		std::string system2 = Utils::String::toUpper(file2->getSystemName());
-		return system1.compare(system2) < 0;
+		return getSortKeys(file1, KEY_SYSTEM).system.compare(getSortKeys(file2, KEY_SYSTEM).system) < 0;
 	}
 };
@@ -34,6 +34,28 @@ namespace FileSorts
 
 	typedef bool ComparisonFunction(const FileData* a, const FileData* b);
 
+	// Values the comparators work on. They're computed on first use and kept with the FileData until its metadata,
+	// or the sort settings, change : sorting no longer reparses or allocates anything per comparison.
+	struct SortKeys
+	{
+		SortKeys() : version(0), generation(0), validKeys(0), rating(0), timesPlayed(0), players(0) { }
+
+		unsigned int	version;	// MetaDataList::getVersion() of the metadata the keys come from
+		unsigned int	generation;	// Singleton generation (leading articles)
+		unsigned int	validKeys;
+
+		std::u32string	name;		// uppercased, leading article removed
+		float			rating;
+		int				timesPlayed;
+		int				players;
+		std::string		lastPlayed;	// ISO strings (YYYYMMDDTHHMMSS) compare as strings
+		std::string		releaseDate;
+		std::string		genre;		// uppercased
+		std::string		developer;
+		std::string		publisher;
+		std::string		system;
+	};
+
 	struct SortType
 	{
 		int id;
@@ -52,9 +74,14 @@ namespace FileSorts
 		Singleton();
 
 		std::vector<SortType> mSortTypes;
+
+		unsigned int				mGeneration;
+		bool						mIgnoreArticles;
+		std::vector<std::string>	mArticles;
 	};
 
-	void reset();
+	void reset(); // call when the sort settings change, cached sort keys are recomputed
+	unsigned int getGeneration(); // changes on every reset()
 	SortType getSortType(int sortId);
 	const std::vector<SortType>& getSortTypes();
 
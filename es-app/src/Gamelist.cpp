@@ -5,6 +5,7 @@
 #include "utils/StringUtil.h"
 #include "FileData.h"
 #include "FileFilterIndex.h"
+#include "GamelistCache.h"
 #include "Log.h"
 #include "Settings.h"
 #include "SystemData.h"
@@ -17,6 +18,8 @@
 #include <unistd.h>
 #endif
 
+#include <algorithm>
+#include <chrono>
 #include <future>
 #include "utils/AsyncUtil.h"
 
@@ -108,10 +111,8 @@ FileData* findOrCreateFile(SystemData* system, const std::string& path, FileType
 	return NULL;
 }
 
-void loadGamelistFile (const std::string xmlpath, SystemData* system, std::unordered_map<std::string, FileData*>& fileMap, size_t checkSize = SIZE_MAX)
-{	
-	bool trustGamelist = Settings::getInstance()->getBool("ParseGamelistOnly");
-
+static bool readGamelistFile(const std::string& xmlpath, SystemData* system, std::vector<GamelistEntry>& entries, size_t checkSize = SIZE_MAX)
+{
 	LOG(LogInfo) << "Parsing XML file \"" << xmlpath << "\"...";
 
 	pugi::xml_document doc;
@@ -120,14 +121,14 @@ void loadGamelistFile (const std::string xmlpath, SystemData* system, std::unord
 	if (!result)
 	{
 		LOG(LogError) << "Error parsing XML file \"" << xmlpath << "\"!\n	" << result.description();
-		return;
+		return false;
 	}
 
 	pugi::xml_node root = doc.child("gameList");
 	if (!root)
 	{
 		LOG(LogError) << "Could not find <gameList> node in gamelist \"" << xmlpath << "\"!";
-		return;
+		return false;
 	}
 
 	if (checkSize != SIZE_MAX)
@@ -136,11 +137,9 @@ void loadGamelistFile (const std::string xmlpath, SystemData* system, std::unord
 		if (parentSize != checkSize)
 		{
 			LOG(LogWarning) << "gamelist size don't match !";
-			return;
+			return false;
 		}
 	}
-	
-	std::string relativeTo = system->getStartPath();
 
 	for (pugi::xml_node fileNode : root.children())
 	{
@@ -153,14 +152,47 @@ void loadGamelistFile (const std::string xmlpath, SystemData* system, std::unord
 		else if (tag != "game")
 			continue;
 
-		const std::string path = Utils::FileSystem::resolveRelativePath(fileNode.child("path").text().get(), relativeTo, false);
+		entries.push_back(GamelistEntry(type, fileNode.child("path").text().get(), MetaDataList::createFromXML(type == FOLDER ? FOLDER_METADATA : GAME_METADATA, fileNode, system)));
+	}
+
+	return true;
+}
+
+static void logMetadataMemoryUsage(SystemData* system, const std::vector<GamelistEntry>& entries)
+{
+	if (Log::getReportingLevel() < LogDebug || entries.size() == 0)
+		return;
+
+	size_t usage = 0;
+	size_t legacyUsage = 0;
+
+	for (auto& entry : entries)
+	{
+		usage += entry.metadata.getMemoryUsage();
+		legacyUsage += entry.metadata.getLegacyMemoryUsage();
+	}
+
+	LOG(LogDebug) << "Metadata of " << system->getName() << " : " << usage / entries.size() << " bytes per game (" << legacyUsage / entries.size() << " with map storage), " << MetaDataList::getInternedStringsCount() << " shared strings";
+}
+
+static void applyGamelistEntries(SystemData* system, const std::vector<GamelistEntry>& entries, std::unordered_map<std::string, FileData*>& fileMap, bool setDirty)
+{
+	logMetadataMemoryUsage(system, entries);
+
+	bool trustGamelist = Settings::getInstance()->getBool("ParseGamelistOnly");
+
+	std::string relativeTo = system->getStartPath();
+
+	for (auto& entry : entries)
+	{
+		const std::string path = Utils::FileSystem::resolveRelativePath(entry.path, relativeTo, false);
 		if (!trustGamelist && !Utils::FileSystem::exists(path))
 		{
 			LOG(LogWarning) << "File \"" << path << "\" does not exist! Ignoring.";
 			continue;
 		}
 
-		FileData* file = findOrCreateFile(system, path, type, fileMap);
+		FileData* file = findOrCreateFile(system, path, entry.type, fileMap);
 		if (!file)
 		{
 			LOG(LogError) << "Error finding/creating FileData for \"" << path << "\", skipping.";
@@ -169,7 +201,7 @@ void loadGamelistFile (const std::string xmlpath, SystemData* system, std::unord
 		else if (!file->isArcadeAsset())
 		{
 			std::string defaultName = file->getMetadata().get("name");
-			file->setMetadata(MetaDataList::createFromXML(type == FOLDER ? FOLDER_METADATA : GAME_METADATA, fileNode, system));
+			file->setMetadata(entry.metadata);
 
 			//make sure name gets set if one didn't exist
 			if (file->getMetadata().get("name").empty())
@@ -178,7 +210,7 @@ void loadGamelistFile (const std::string xmlpath, SystemData* system, std::unord
 			if (!file->getHidden() && Utils::FileSystem::isHidden(path))
 				file->getMetadata().set("hidden", "true");
 
-			if (checkSize != SIZE_MAX)
+			if (setDirty)
 				file->getMetadata().setDirty();
 			else
 				file->getMetadata().resetChangedFlag();
@@ -186,6 +218,71 @@ void loadGamelistFile (const std::string xmlpath, SystemData* system, std::unord
 	}
 }
 
+void loadGamelistFile(const std::string xmlpath, SystemData* system, std::unordered_map<std::string, FileData*>& fileMap, size_t checkSize = SIZE_MAX)
+{
+	std::vector<GamelistEntry> entries;
+	if (readGamelistFile(xmlpath, system, entries, checkSize))
+		applyGamelistEntries(system, entries, fileMap, checkSize != SIZE_MAX);
+}
+
+static int getElapsedMs(const std::chrono::steady_clock::time_point& start)
+{
+	return (int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Loads the system's gamelist.xml through its binary cache, the XML is only parsed when the cache is missing or stale
+void loadCachedGamelistFile(const std::string xmlpath, SystemData* system, std::unordered_map<std::string, FileData*>& fileMap)
+{
+	if (!Settings::getInstance()->getBool("GamelistCache"))
+	{
+		loadGamelistFile(xmlpath, system, fileMap);
+		return;
+	}
+
+	bool rebuild = Settings::getInstance()->getBool("GamelistCacheRebuild");
+	bool verify = Settings::getInstance()->getBool("GamelistCacheVerify");
+
+	std::vector<GamelistEntry> cached;
+	int xmlParseTime = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	bool cacheValid = !rebuild && GamelistCache::load(system, xmlpath, cached, xmlParseTime);
+	int cacheLoadTime = getElapsedMs(start);
+
+	if (cacheValid && !verify)
+	{
+		LOG(LogInfo) << "Loaded gamelist cache for " << system->getName() << " in " << cacheLoadTime << "ms (XML parsing took " << xmlParseTime << "ms, saved " << std::max(0, xmlParseTime - cacheLoadTime) << "ms)";
+		applyGamelistEntries(system, cached, fileMap, false);
+		return;
+	}
+
+	std::vector<GamelistEntry> entries;
+
+	start = std::chrono::steady_clock::now();
+	if (!readGamelistFile(xmlpath, system, entries))
+		return;
+
+	xmlParseTime = getElapsedMs(start);
+
+	bool saveCache = true;
+
+	if (cacheValid)
+	{
+		if (GamelistCache::isSameContent(cached, entries))
+		{
+			LOG(LogInfo) << "Gamelist cache for " << system->getName() << " verified (" << entries.size() << " entries, cache " << cacheLoadTime << "ms, XML " << xmlParseTime << "ms)";
+			saveCache = false;
+		}
+		else
+			LOG(LogWarning) << "Gamelist cache for " << system->getName() << " doesn't match gamelist.xml, rebuilding it";
+	}
+
+	applyGamelistEntries(system, entries, fileMap, false);
+
+	if (saveCache)
+		GamelistCache::save(system, xmlpath, entries, xmlParseTime);
+}
+
 std::string getTemporaryGamelistRecovery(SystemData* system)
 {
 	return Utils::FileSystem::getHomePath() + "/.emulationstation/recovery/" + system->getName();
@@ -218,7 +315,7 @@ void parseGamelist(SystemData* system, std::unordered_map<std::string, FileData*
 
 	auto size = Utils::FileSystem::getFileSize(xmlpath);
 	if (size != 0)
-		loadGamelistFile(xmlpath, system, fileMap);
+		loadCachedGamelistFile(xmlpath, system, fileMap);
 
 	auto files = Utils::FileSystem::getDirContent(getTemporaryGamelistRecovery(system), true, false);
 	for (auto file : files)
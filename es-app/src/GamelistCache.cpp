@@ -0,0 +1,310 @@
+#include <string>
+#include "GamelistCache.h"
+
+#include "utils/FileSystemUtil.h"
+#include "Log.h"
+#include "SystemData.h"
+#include <stdint.h>
+#include <string.h>
+#include <cstdio>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Bump when the layout below, or the metadata ids in MetaData.cpp, change
+#define GAMELIST_CACHE_MAGIC	0x4C475345 // "ESGL"
+#define GAMELIST_CACHE_VERSION	1
+
+// Layout (native endianness, the cache is never shared between machines) :
+//	header   : magic(u32) version(u32) xmlSize(u64) xmlTime(i64) xmlParseTime(u32) entryCount(u32) startPath(str)
+//	entries  : type(u8) path(str) valueCount(u8) valueCount * [ id(u8) value(str) ]
+//	str      : length(u32) bytes
+
+// Read-only view over the cache file, memory-mapped when the platform allows it
+class MappedCacheFile
+{
+public:
+	MappedCacheFile(const std::string& path) : mData(nullptr), mSize(0)
+	{
+#ifdef WIN32
+		FILE* file = fopen(path.c_str(), "rb");
+		if (file == nullptr)
+			return;
+
+		fseek(file, 0, SEEK_END);
+		long size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+
+		if (size > 0)
+		{
+			mBuffer.resize(size);
+			if (fread(mBuffer.data(), 1, size, file) == (size_t)size)
+			{
+				mData = mBuffer.data();
+				mSize = size;
+			}
+		}
+
+		fclose(file);
+#else
+		int fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			return;
+
+		struct stat info;
+		if (fstat(fd, &info) == 0 && info.st_size > 0)
+		{
+			void* data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (data != MAP_FAILED)
+			{
+				mData = (const char*)data;
+				mSize = info.st_size;
+			}
+		}
+
+		close(fd);
+#endif
+	}
+
+	~MappedCacheFile()
+	{
+#ifndef WIN32
+		if (mData != nullptr)
+			munmap((void*)mData, mSize);
+#endif
+	}
+
+	inline const char* data() const { return mData; }
+	inline size_t size() const { return mSize; }
+
+private:
+	const char* mData;
+	size_t		mSize;
+#ifdef WIN32
+	std::vector<char> mBuffer;
+#endif
+};
+
+class CacheReader
+{
+public:
+	CacheReader(const char* data, size_t size) : mPos(data), mEnd(data + size), mFailed(data == nullptr) { }
+
+	template<typename T> T read()
+	{
+		T value = 0;
+		if (mFailed || (size_t)(mEnd - mPos) < sizeof(T))
+		{
+			mFailed = true;
+			return value;
+		}
+
+		memcpy(&value, mPos, sizeof(T));
+		mPos += sizeof(T);
+		return value;
+	}
+
+	std::string readString()
+	{
+		uint32_t length = read<uint32_t>();
+		if (mFailed || (size_t)(mEnd - mPos) < length)
+		{
+			mFailed = true;
+			return "";
+		}
+
+		std::string value(mPos, length);
+		mPos += length;
+		return value;
+	}
+
+	inline bool failed() const { return mFailed; }
+
+private:
+	const char* mPos;
+	const char* mEnd;
+	bool		mFailed;
+};
+
+class CacheWriter
+{
+public:
+	template<typename T> void write(T value)
+	{
+		mBuffer.append((const char*)&value, sizeof(T));
+	}
+
+	void writeString(const std::string& value)
+	{
+		write<uint32_t>((uint32_t)value.size());
+		mBuffer.append(value);
+	}
+
+	inline const std::string& buffer() const { return mBuffer; }
+
+private:
+	std::string mBuffer;
+};
+
+std::string GamelistCache::getCachePath(SystemData* system)
+{
+	return Utils::FileSystem::getHomePath() + "/.emulationstation/cache/" + system->getName() + ".gamelist";
+}
+
+bool GamelistCache::load(SystemData* system, const std::string& xmlPath, std::vector<GamelistEntry>& entries, int& xmlParseTime)
+{
+	std::string path = getCachePath(system);
+	if (!Utils::FileSystem::exists(path))
+		return false;
+
+	MappedCacheFile file(path);
+	CacheReader reader(file.data(), file.size());
+
+	if (reader.read<uint32_t>() != GAMELIST_CACHE_MAGIC || reader.read<uint32_t>() != GAMELIST_CACHE_VERSION)
+	{
+		LOG(LogInfo) << "Gamelist cache \"" << path << "\" has an unknown format, ignoring it";
+		return false;
+	}
+
+	uint64_t xmlSize = reader.read<uint64_t>();
+	int64_t xmlTime = reader.read<int64_t>();
+	xmlParseTime = (int)reader.read<uint32_t>();
+	uint32_t entryCount = reader.read<uint32_t>();
+	std::string startPath = reader.readString();
+
+	if (reader.failed() || startPath != system->getStartPath() ||
+		xmlSize != (uint64_t)Utils::FileSystem::getFileSize(xmlPath) ||
+		xmlTime != (int64_t)Utils::FileSystem::getFileModificationTime(xmlPath))
+	{
+		LOG(LogInfo) << "Gamelist cache \"" << path << "\" is stale";
+		return false;
+	}
+
+	std::vector<GamelistEntry> ret;
+	ret.reserve(entryCount);
+
+	std::vector<std::pair<unsigned char, std::string>> values;
+
+	for (uint32_t i = 0; i < entryCount && !reader.failed(); i++)
+	{
+		FileType type = (FileType)reader.read<uint8_t>();
+		std::string filePath = reader.readString();
+
+		values.clear();
+
+		uint8_t valueCount = reader.read<uint8_t>();
+		for (uint8_t v = 0; v < valueCount && !reader.failed(); v++)
+		{
+			unsigned char id = reader.read<uint8_t>();
+			values.push_back(std::pair<unsigned char, std::string>(id, reader.readString()));
+		}
+
+		if (type != GAME && type != FOLDER)
+			break;
+
+		ret.push_back(GamelistEntry(type, filePath, MetaDataList::createFromRawValues(type == FOLDER ? FOLDER_METADATA : GAME_METADATA, values, system)));
+	}
+
+	if (reader.failed() || ret.size() != entryCount)
+	{
+		LOG(LogWarning) << "Gamelist cache \"" << path << "\" is corrupted, ignoring it";
+		return false;
+	}
+
+	entries = std::move(ret);
+	return true;
+}
+
+bool GamelistCache::save(SystemData* system, const std::string& xmlPath, const std::vector<GamelistEntry>& entries, int xmlParseTime)
+{
+	std::string path = getCachePath(system);
+
+	CacheWriter writer;
+	writer.write<uint32_t>(GAMELIST_CACHE_MAGIC);
+	writer.write<uint32_t>(GAMELIST_CACHE_VERSION);
+	writer.write<uint64_t>((uint64_t)Utils::FileSystem::getFileSize(xmlPath));
+	writer.write<int64_t>((int64_t)Utils::FileSystem::getFileModificationTime(xmlPath));
+	writer.write<uint32_t>((uint32_t)(xmlParseTime < 0 ? 0 : xmlParseTime));
+	writer.write<uint32_t>((uint32_t)entries.size());
+	writer.writeString(system->getStartPath());
+
+	for (auto& entry : entries)
+	{
+		auto values = entry.metadata.getRawValues();
+
+		writer.write<uint8_t>((uint8_t)entry.type);
+		writer.writeString(entry.path);
+		writer.write<uint8_t>((uint8_t)values.size());
+
+		for (auto& value : values)
+		{
+			writer.write<uint8_t>(value.first);
+			writer.writeString(value.second);
+		}
+	}
+
+	std::string folder = Utils::FileSystem::getParent(path);
+	if (!Utils::FileSystem::exists(folder))
+		Utils::FileSystem::createDirectory(folder);
+
+	// Write to a temporary file first, so a crash never leaves a truncated cache behind
+	std::string tmpFile = path + ".tmp";
+
+	FILE* file = fopen(tmpFile.c_str(), "wb");
+	if (file == nullptr)
+	{
+		LOG(LogError) << "Unable to write gamelist cache \"" << tmpFile << "\"";
+		return false;
+	}
+
+	const std::string& buffer = writer.buffer();
+	bool written = fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+	fclose(file);
+
+	if (!written)
+	{
+		LOG(LogError) << "Unable to write gamelist cache \"" << tmpFile << "\"";
+		Utils::FileSystem::removeFile(tmpFile);
+		return false;
+	}
+
+	if (Utils::FileSystem::exists(path))
+		Utils::FileSystem::removeFile(path);
+
+	if (std::rename(tmpFile.c_str(), path.c_str()) != 0)
+	{
+		LOG(LogError) << "Unable to rename \"" << tmpFile << "\" to \"" << path << "\"";
+		return false;
+	}
+
+	LOG(LogInfo) << "Gamelist cache written to \"" << path << "\" (" << entries.size() << " entries)";
+	return true;
+}
+
+void GamelistCache::remove(SystemData* system)
+{
+	std::string path = getCachePath(system);
+	if (Utils::FileSystem::exists(path))
+		Utils::FileSystem::removeFile(path);
+}
+
+bool GamelistCache::isSameContent(const std::vector<GamelistEntry>& a, const std::vector<GamelistEntry>& b)
+{
+	if (a.size() != b.size())
+		return false;
+
+	for (size_t i = 0; i < a.size(); i++)
+	{
+		if (a[i].type != b[i].type || a[i].path != b[i].path)
+			return false;
+
+		if (a[i].metadata.getRawValues() != b[i].metadata.getRawValues())
+			return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,38 @@
+#include <string>
+#pragma once
+#ifndef ES_APP_GAMELIST_CACHE_H
+#define ES_APP_GAMELIST_CACHE_H
+
+#include "FileData.h"
+#include "MetaData.h"
+#include <vector>
+
+class SystemData;
+
+// One <game> or <folder> node of a gamelist.xml, as read from the XML or from the binary cache.
+struct GamelistEntry
+{
+	GamelistEntry(FileType _type, const std::string& _path, const MetaDataList& _metadata) : type(_type), path(_path), metadata(_metadata) { }
+
+	FileType		type;
+	std::string		path; // raw <path> value, usually relative to the system start path
+	MetaDataList	metadata;
+};
+
+// Versioned binary copy of a system's gamelist.xml, stored in ~/.emulationstation/cache.
+// The cache is keyed by the size (the value tracked by SystemData::getGamelistHash) and modification time of gamelist.xml,
+// and is ignored as soon as one of them differs.
+class GamelistCache
+{
+public:
+	static std::string getCachePath(SystemData* system);
+
+	// Returns false if the cache doesn't exist, is corrupted or is stale. xmlParseTime receives the time (ms) the XML took to parse when the cache was built.
+	static bool load(SystemData* system, const std::string& xmlPath, std::vector<GamelistEntry>& entries, int& xmlParseTime);
+	static bool save(SystemData* system, const std::string& xmlPath, const std::vector<GamelistEntry>& entries, int xmlParseTime);
+	static void remove(SystemData* system);
+
+	static bool isSameContent(const std::vector<GamelistEntry>& a, const std::vector<GamelistEntry>& b);
+};
+
+#endif // ES_APP_GAMELIST_CACHE_H
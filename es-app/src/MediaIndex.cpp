@@ -0,0 +1,59 @@
+#include <string>
+#include "MediaIndex.h"
+
+#include "utils/FileSystemUtil.h"
+#include "Log.h"
+#include <SDL_timer.h>
+
+#define MEDIA_INDEX_CHECK_DELAY 2000
+
+MediaIndex::MediaIndex(const std::string& startPath) : mStartPath(startPath)
+{
+
+}
+
+void MediaIndex::list(const std::string& path, Folder& folder)
+{
+	folder.files.clear();
+	folder.modificationTime = Utils::FileSystem::getFileModificationTime(path);
+
+	if (folder.modificationTime == 0) // missing
+		return;
+
+	for (auto& file : Utils::FileSystem::getDirContent(path, false, true))
+		folder.files.insert(Utils::FileSystem::getFileName(file));
+
+	LOG(LogDebug) << "MediaIndex : " << folder.files.size() << " files in " << path;
+}
+
+bool MediaIndex::exists(const std::string& folderName, const std::string& fileName)
+{
+	std::unique_lock<std::mutex> lock(mLock);
+
+	std::string path = mStartPath + "/" + folderName;
+	unsigned int now = SDL_GetTicks();
+
+	auto it = mFolders.find(folderName);
+	if (it == mFolders.cend())
+	{
+		it = mFolders.insert(std::make_pair(folderName, Folder())).first;
+		list(path, it->second);
+		it->second.checkTime = now;
+	}
+	else if (now - it->second.checkTime >= MEDIA_INDEX_CHECK_DELAY)
+	{
+		// Adding or removing a file changes the modification time of its folder
+		if (Utils::FileSystem::getFileModificationTime(path) != it->second.modificationTime)
+			list(path, it->second);
+
+		it->second.checkTime = now;
+	}
+
+	return it->second.files.find(fileName) != it->second.files.cend();
+}
+
+void MediaIndex::invalidate()
+{
+	std::unique_lock<std::mutex> lock(mLock);
+	mFolders.clear();
+}
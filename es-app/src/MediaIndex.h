@@ -0,0 +1,42 @@
+#include <string>
+#pragma once
+#ifndef ES_APP_MEDIA_INDEX_H
+#define ES_APP_MEDIA_INDEX_H
+
+#include <ctime>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+// File names of the media folders of a system (images, videos...), so the local art of each game is looked up in memory
+// instead of probing the files one by one. Each folder is listed on its first lookup, and listed again when its
+// modification time changes (checked at most every MEDIA_INDEX_CHECK_DELAY ms).
+class MediaIndex
+{
+public:
+	MediaIndex(const std::string& startPath);
+
+	// True if <startPath>/<folder>/<fileName> exists
+	bool exists(const std::string& folder, const std::string& fileName);
+
+	// Forgets every listing, the next lookups list the folders again
+	void invalidate();
+
+private:
+	struct Folder
+	{
+		Folder() : modificationTime(0), checkTime(0) { }
+
+		time_t							modificationTime;
+		unsigned int					checkTime; // SDL ticks of the last modification time check
+		std::unordered_set<std::string>	files;
+	};
+
+	void list(const std::string& path, Folder& folder);
+
+	std::string								mStartPath;
+	std::mutex								mLock;
+	std::unordered_map<std::string, Folder>	mFolders;
+};
+
+#endif // ES_APP_MEDIA_INDEX_H
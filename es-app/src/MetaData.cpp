@@ -7,6 +7,13 @@
 #include <pugixml/src/pugixml.hpp>
 #include "SystemData.h"
 #include "Settings.h"
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include <atomic>
+#include <cstdio>
+#include <string.h>
+#include <assert.h>
 
 MetaDataDecl gameDecls[] = {
 	// key,         type,                   default,            statistic,  name in GuiMetaDataEd,  prompt in GuiMetaDataEd
@@ -56,62 +63,211 @@ MetaDataDecl folderDecls[] = {
 
 const std::vector<MetaDataDecl> folderMDD(folderDecls, folderDecls + sizeof(folderDecls) / sizeof(folderDecls[0]));
 
-std::map<std::string, unsigned char> MetaDataList::mGameIdMap = MetaDataList::BuildIdMap(GAME_METADATA);
-std::map<std::string, unsigned char> MetaDataList::mFolderIdMap = MetaDataList::BuildIdMap(FOLDER_METADATA);
+enum MetaDataStorage : unsigned char
+{
+	STORE_NAME,
+	STORE_STRING,
+	STORE_INTERNED,
+	STORE_INT,
+	STORE_FLOAT,
+	STORE_BOOL,
+	STORE_TIME
+};
 
-std::map<unsigned char, MetaDataType> MetaDataList::mGameTypeMap = MetaDataList::BuildTypeMap(GAME_METADATA);
-std::map<unsigned char, MetaDataType> MetaDataList::mFolderTypeMap = MetaDataList::BuildTypeMap(FOLDER_METADATA);
+struct MetaDataSlot
+{
+	MetaDataSlot() : decl(nullptr), storage(STORE_STRING), slot(0), defaultInt(0), defaultFloat(0) { }
+
+	const MetaDataDecl*	decl;
+	MetaDataStorage		storage;
+	unsigned char		slot; // index in mNumbers or mInterned
+	int					defaultInt;
+	float				defaultFloat;
+};
 
-std::map<unsigned char, std::string> MetaDataList::mDefaultGameMap = MetaDataList::BuildDefaultMap(GAME_METADATA);
-std::map<unsigned char, std::string> MetaDataList::mDefaultFolderMap = MetaDataList::BuildDefaultMap(FOLDER_METADATA);
+#define INVALID_METADATA_ID 255
 
-std::map<unsigned char, MetaDataType> MetaDataList::BuildTypeMap(MetaDataListType type)
+struct MetaDataSchema
 {
-	std::map<unsigned char, MetaDataType> ret;
+	MetaDataSchema(MetaDataListType type)
+	{
+		int numbers = 0;
+		int interned = 0;
+
+		const std::vector<MetaDataDecl>& mdd = getMDDByType(type);
+		for (auto iter = mdd.cbegin(); iter != mdd.cend(); iter++)
+		{
+			// The flags are 32 bit masks indexed by id
+			assert(iter->id < MetaDataList::MAX_METADATA_IDS);
+			if (iter->id >= MetaDataList::MAX_METADATA_IDS)
+			{
+				LOG(LogError) << "MetaDataSchema : metadata id out of range, " << iter->key << " is ignored";
+				continue;
+			}
+
+			if (iter->id >= slots.size())
+				slots.resize(iter->id + 1);
+
+			MetaDataSlot& md = slots[iter->id];
+			md.decl = &(*iter);
+			md.defaultInt = atoi(iter->defaultValue.c_str());
+			md.defaultFloat = (float)atof(iter->defaultValue.c_str());
+
+			ids[iter->key] = iter->id;
+
+			switch (iter->type)
+			{
+			case MD_STRING:
+			case MD_PLIST:
+				if (iter->id == 0)
+					md.storage = STORE_NAME;
+				else
+					md.storage = STORE_INTERNED;
+				break;
+			case MD_INT:
+				md.storage = STORE_INT;
+				break;
+			case MD_FLOAT:
+			case MD_RATING:
+				md.storage = STORE_FLOAT;
+				break;
+			case MD_DATE:
+			case MD_TIME:
+				md.storage = STORE_TIME;
+				break;
+			case MD_BOOL:
+				md.storage = STORE_BOOL;
+				break;
+			default:
+				md.storage = STORE_STRING;
+				break;
+			}
+
+			// Declarations that don't fit in the fixed slots are kept as plain strings
+			if (md.storage == STORE_INTERNED)
+			{
+				assert(interned < MetaDataList::MAX_INTERNED_SLOTS);
+				if (interned < MetaDataList::MAX_INTERNED_SLOTS)
+					md.slot = interned++;
+				else
+				{
+					LOG(LogError) << "MetaDataSchema : too many interned declarations, " << iter->key << " is stored as a string";
+					md.storage = STORE_STRING;
+				}
+			}
+			else if (md.storage == STORE_INT || md.storage == STORE_FLOAT || md.storage == STORE_TIME)
+			{
+				assert(numbers < MetaDataList::MAX_NUMBER_SLOTS);
+				if (numbers < MetaDataList::MAX_NUMBER_SLOTS)
+					md.slot = numbers++;
+				else
+				{
+					LOG(LogError) << "MetaDataSchema : too many numeric declarations, " << iter->key << " is stored as a string";
+					md.storage = STORE_STRING;
+				}
+			}
+		}
+	}
 
-	const std::vector<MetaDataDecl>& mdd = getMDDByType(type);
-	for (auto iter = mdd.cbegin(); iter != mdd.cend(); iter++)
-		ret[iter->id] = iter->type;
+	inline bool isValid(unsigned char id) const { return id < slots.size() && slots[id].decl != nullptr; }
 
-	return ret;
+	std::vector<MetaDataSlot> slots; // indexed by id
+	std::unordered_map<std::string, unsigned char> ids;
+};
+
+static const MetaDataSchema& getSchemaByType(MetaDataListType type)
+{
+	static MetaDataSchema gameSchema(GAME_METADATA);
+	static MetaDataSchema folderSchema(FOLDER_METADATA);
+
+	return type == FOLDER_METADATA ? folderSchema : gameSchema;
 }
 
-std::map<std::string, unsigned char> MetaDataList::BuildIdMap(MetaDataListType type)
+// Pool shared by every list. Elements of an unordered_set never move, so the pointers stay valid for the whole run.
+static std::unordered_set<std::string> sInternedStrings;
+static std::mutex sInternedStringsLock;
+
+static const std::string* internString(const std::string& value)
 {
-	std::map<std::string, unsigned char> ret;
+	std::unique_lock<std::mutex> lock(sInternedStringsLock);
+	return &(*sInternedStrings.insert(value).first);
+}
 
-	const std::vector<MetaDataDecl>& mdd = getMDDByType(type);
-	for (auto iter = mdd.cbegin(); iter != mdd.cend(); iter++)
-		ret[iter->key] = iter->id;
+size_t MetaDataList::getInternedStringsCount()
+{
+	std::unique_lock<std::mutex> lock(sInternedStringsLock);
+	return sInternedStrings.size();
+}
 
-	return ret;
+static std::string formatShortFloat(float value)
+{
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%g", value);
+	return buffer;
 }
 
-std::map<unsigned char, std::string> MetaDataList::BuildDefaultMap(MetaDataListType type)
+// "%Y%m%dT%H%M%S" -> YYYYMMDDhhmmss. Done by hand rather than through Utils::Time so that it is exact and doesn't depend on the timezone.
+static bool parsePackedTime(const std::string& value, long long& packed)
 {
-	std::map<unsigned char, std::string> ret;
+	if (value.size() != 15 || value[8] != 'T')
+		return false;
 
-	const std::vector<MetaDataDecl>& mdd = getMDDByType(type);
-	for (auto iter = mdd.cbegin(); iter != mdd.cend(); iter++)
-		ret[iter->id] = iter->defaultValue;		
+	packed = 0;
+	for (int i = 0; i < 15; i++)
+	{
+		if (i == 8)
+			continue;
 
-	return ret;
+		if (value[i] < '0' || value[i] > '9')
+			return false;
+
+		packed = packed * 10 + (value[i] - '0');
+	}
+
+	return true;
+}
+
+static std::string formatPackedTime(long long packed)
+{
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%08lldT%06lld", packed / 1000000, packed % 1000000);
+	return buffer;
+}
+
+static size_t getStringHeapSize(const std::string& value)
+{
+	// Short strings are stored inside the object itself
+	const char* data = value.data();
+	const char* object = (const char*)&value;
+	if (data >= object && data < object + sizeof(std::string))
+		return 0;
+
+	return value.capacity() + 1;
+}
+
+const MetaDataSchema& MetaDataList::getSchema() const
+{
+	return getSchemaByType(getType());
 }
 
 MetaDataType MetaDataList::getType(unsigned char id) const
 {
-	if (mType == GAME_METADATA)
-		return mGameTypeMap[id];
+	const MetaDataSchema& schema = getSchema();
+	if (!schema.isValid(id))
+		return MD_STRING;
 
-	return mFolderTypeMap[id];
+	return schema.slots[id].decl->type;
 }
 
 unsigned char MetaDataList::getId(const std::string& key) const
 {
-	if (mType == GAME_METADATA)
-		return mGameIdMap[key];
+	const MetaDataSchema& schema = getSchema();
 
-	return mFolderIdMap[key];
+	auto it = schema.ids.find(key);
+	if (it == schema.ids.cend())
+		return INVALID_METADATA_ID;
+
+	return it->second;
 }
 
 const std::vector<MetaDataDecl>& getMDDByType(MetaDataListType type)
@@ -128,9 +284,159 @@ const std::vector<MetaDataDecl>& getMDDByType(MetaDataListType type)
 	return gameMDD;
 }
 
-MetaDataList::MetaDataList(MetaDataListType type) : mType(type), mWasChanged(false), mRelativeTo(nullptr)
+static std::atomic<unsigned int> sVersionCounter(0);
+
+MetaDataList::MetaDataList(MetaDataListType type) : mType(type), mWasChanged(false), mRelativeTo(nullptr), mVersion(++sVersionCounter),
+	mSetFlags(0), mNativeFlags(0), mBoolValues(0), mShortFloats(0)
 { 
+	memset(mNumbers, 0, sizeof(mNumbers));
+	memset(mInterned, 0, sizeof(mInterned));
+}
+
+const std::string* MetaDataList::findString(unsigned char id) const
+{
+	for (auto& item : mStrings)
+		if (item.first == id)
+			return &item.second;
+
+	return nullptr;
+}
+
+void MetaDataList::setString(unsigned char id, const std::string& value)
+{
+	auto it = mStrings.begin();
+	while (it != mStrings.end() && it->first < id)
+		it++;
 
+	if (it != mStrings.end() && it->first == id)
+		it->second = value;
+	else
+		mStrings.insert(it, std::pair<unsigned char, std::string>(id, value));
+}
+
+void MetaDataList::removeString(unsigned char id)
+{
+	for (auto it = mStrings.begin(); it != mStrings.end(); it++)
+	{
+		if (it->first == id)
+		{
+			mStrings.erase(it);
+			return;
+		}
+	}
+}
+
+void MetaDataList::storeValue(unsigned char id, const std::string& value)
+{
+	const MetaDataSlot& md = getSchema().slots[id];
+	unsigned int bit = 1u << id;
+
+	mSetFlags |= bit;
+	mNativeFlags &= ~bit;
+	mShortFloats &= ~bit;
+
+	switch (md.storage)
+	{
+	case STORE_INTERNED:
+		removeString(id);
+		mInterned[md.slot] = internString(value);
+		mNativeFlags |= bit;
+		return;
+
+	case STORE_BOOL:
+		if (value == "true" || value == "false")
+		{
+			removeString(id);
+
+			if (value == "true")
+				mBoolValues |= bit;
+			else
+				mBoolValues &= ~bit;
+
+			mNativeFlags |= bit;
+			return;
+		}
+		break;
+
+	case STORE_INT:
+		{
+			int number = atoi(value.c_str());
+			if (std::to_string(number) == value)
+			{
+				removeString(id);
+				mNumbers[md.slot].i = number;
+				mNativeFlags |= bit;
+				return;
+			}
+		}
+		break;
+
+	case STORE_FLOAT:
+		{
+			float number = (float)atof(value.c_str());
+			if (std::to_string(number) == value || formatShortFloat(number) == value)
+			{
+				removeString(id);
+				mNumbers[md.slot].f = number;
+				mNativeFlags |= bit;
+
+				if (std::to_string(number) != value)
+					mShortFloats |= bit;
+
+				return;
+			}
+		}
+		break;
+
+	case STORE_TIME:
+		{
+			long long packed;
+			if (parsePackedTime(value, packed))
+			{
+				removeString(id);
+				mNumbers[md.slot].t = packed;
+				mNativeFlags |= bit;
+				return;
+			}
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	// Anything that doesn't survive a round-trip through its native type is kept verbatim
+	setString(id, value);
+}
+
+std::string MetaDataList::getStoredValue(unsigned char id) const
+{
+	const MetaDataSlot& md = getSchema().slots[id];
+	unsigned int bit = 1u << id;
+
+	if ((mNativeFlags & bit) == 0)
+	{
+		const std::string* value = findString(id);
+		return value != nullptr ? *value : md.decl->defaultValue;
+	}
+
+	switch (md.storage)
+	{
+	case STORE_INTERNED:
+		return *mInterned[md.slot];
+	case STORE_BOOL:
+		return (mBoolValues & bit) ? "true" : "false";
+	case STORE_INT:
+		return std::to_string(mNumbers[md.slot].i);
+	case STORE_FLOAT:
+		return (mShortFloats & bit) ? formatShortFloat(mNumbers[md.slot].f) : std::to_string(mNumbers[md.slot].f);
+	case STORE_TIME:
+		return formatPackedTime(mNumbers[md.slot].t);
+	default:
+		break;
+	}
+
+	return md.decl->defaultValue;
 }
 
 MetaDataList MetaDataList::createFromXML(MetaDataListType type, pugi::xml_node& node, SystemData* system)
@@ -138,8 +444,6 @@ MetaDataList MetaDataList::createFromXML(MetaDataListType type, pugi::xml_node&
 	MetaDataList mdl(type);
 	mdl.mRelativeTo = system;
 
-	auto sz = sizeof(MetaDataList);
-
 	const std::vector<MetaDataDecl>& mdd = mdl.getMDD();
 
 	for(auto iter = mdd.cbegin(); iter != mdd.cend(); iter++)
@@ -165,13 +469,70 @@ MetaDataList MetaDataList::createFromXML(MetaDataListType type, pugi::xml_node&
 			if (iter->id == 0)
 				mdl.mName = value;
 			else
-				mdl.mMap[iter->id] = value;
+				mdl.storeValue(iter->id, value);
 		}
 	}
 
 	return mdl;
 }
 
+MetaDataList MetaDataList::createFromRawValues(MetaDataListType type, const std::vector<std::pair<unsigned char, std::string>>& values, SystemData* system)
+{
+	MetaDataList mdl(type);
+	mdl.mRelativeTo = system;
+
+	const MetaDataSchema& schema = mdl.getSchema();
+
+	for (auto& value : values)
+	{
+		if (value.first == 0)
+			mdl.mName = value.second;
+		else if (schema.isValid(value.first))
+			mdl.storeValue(value.first, value.second);
+	}
+
+	return mdl;
+}
+
+std::vector<std::pair<unsigned char, std::string>> MetaDataList::getRawValues() const
+{
+	std::vector<std::pair<unsigned char, std::string>> ret;
+
+	if (!mName.empty())
+		ret.push_back(std::pair<unsigned char, std::string>(0, mName));
+
+	const MetaDataSchema& schema = getSchema();
+	for (unsigned char id = 1; id < schema.slots.size(); id++)
+		if (hasValue(id))
+			ret.push_back(std::pair<unsigned char, std::string>(id, getStoredValue(id)));
+
+	return ret;
+}
+
+size_t MetaDataList::getMemoryUsage() const
+{
+	size_t size = sizeof(MetaDataList) + getStringHeapSize(mName);
+
+	size += mStrings.capacity() * sizeof(std::pair<unsigned char, std::string>);
+	for (auto& item : mStrings)
+		size += getStringHeapSize(item.second);
+
+	return size;
+}
+
+size_t MetaDataList::getLegacyMemoryUsage() const
+{
+	// mName, mType, mWasChanged, mRelativeTo and a std::map<unsigned char, std::string>
+	size_t size = sizeof(std::string) + 2 * sizeof(void*) + sizeof(std::map<unsigned char, std::string>) + getStringHeapSize(mName);
+
+	// Every value was a red-black tree node : color + 3 links, then the pair
+	for (auto& item : getRawValues())
+		if (item.first != 0)
+			size += 4 * sizeof(void*) + sizeof(std::pair<const unsigned char, std::string>) + getStringHeapSize(item.second);
+
+	return size;
+}
+
 void MetaDataList::appendToXML(pugi::xml_node& parent, bool ignoreDefaults, const std::string& relativeTo) const
 {
 	const std::vector<MetaDataDecl>& mdd = getMDD();
@@ -184,20 +545,20 @@ void MetaDataList::appendToXML(pugi::xml_node& parent, bool ignoreDefaults, cons
 			continue;
 		}
 
-		auto mapIter = mMap.find(mddIter->id);
-		if (mapIter != mMap.cend())
+		if (hasValue(mddIter->id))
 		{
 			// we have this value!
+			std::string value = getStoredValue(mddIter->id);
+
 			// if it's just the default (and we ignore defaults), don't write it
-			if (ignoreDefaults && mapIter->second == mddIter->defaultValue)
+			if (ignoreDefaults && value == mddIter->defaultValue)
 				continue;
 			
 			// try and make paths relative if we can
-			std::string value = mapIter->second;
 			if (mddIter->type == MD_PATH)
 				value = Utils::FileSystem::createRelativePath(value, relativeTo, true);
 
-			parent.append_child(mddIter->key.c_str()).text().set(value.c_str()); // mapIter->first
+			parent.append_child(mddIter->key.c_str()).text().set(value.c_str());
 		}
 	}
 }
@@ -219,22 +580,25 @@ void MetaDataList::set(const std::string& key, const std::string& value)
 	else
 	{
 		auto id = getId(key);
-		
+		if (id == INVALID_METADATA_ID)
+			return;
+
 		// Players -> remove "1-"
 		if (mType == GAME_METADATA && id == 14 && Utils::String::startsWith(value, "1-")) // "players"
 		{
-			mMap[id] = Utils::String::replace(value, "1-", "");
+			storeValue(id, Utils::String::replace(value, "1-", ""));
+			mVersion = ++sVersionCounter;
 			return;
 		}
 
-		auto prev = mMap.find(id);
-		if (prev != mMap.cend() && prev->second == value)
+		if (hasValue(id) && getStoredValue(id) == value)
 			return;
 
-		mMap[id] = value;
+		storeValue(id, value);
 	}
 
 	mWasChanged = true;
+	mVersion = ++sVersionCounter;
 }
 
 const std::string MetaDataList::get(const std::string& key) const
@@ -243,29 +607,55 @@ const std::string MetaDataList::get(const std::string& key) const
 		return mName;
 
 	auto id = getId(key);
+	if (id == INVALID_METADATA_ID)
+		return "";
 
-	auto it = mMap.find(id);
-	if (it != mMap.end())
-	{		
-		if (getType(id) == MD_PATH && mRelativeTo != nullptr) // if it's a path, resolve relative paths				
-			return Utils::FileSystem::resolveRelativePath(it->second, mRelativeTo->getStartPath(), true);
+	if (!hasValue(id))
+		return getSchema().slots[id].decl->defaultValue;
 
-		return it->second;
-	}
-
-	if (mType == GAME_METADATA)
-		return mDefaultGameMap.at(id);
+	if (getType(id) == MD_PATH && mRelativeTo != nullptr) // if it's a path, resolve relative paths
+		return Utils::FileSystem::resolveRelativePath(getStoredValue(id), mRelativeTo->getStartPath(), true);
 
-	return mDefaultFolderMap.at(id);
+	return getStoredValue(id);
 }
 
 int MetaDataList::getInt(const std::string& key) const
 {
+	auto id = getId(key);
+	if (id != INVALID_METADATA_ID && id != 0)
+	{
+		const MetaDataSlot& md = getSchema().slots[id];
+
+		if (!hasValue(id))
+			return md.defaultInt;
+
+		if (md.storage == STORE_INT && (mNativeFlags & (1u << id)))
+			return mNumbers[md.slot].i;
+	}
+
 	return atoi(get(key).c_str());
 }
 
 float MetaDataList::getFloat(const std::string& key) const
 {
+	auto id = getId(key);
+	if (id != INVALID_METADATA_ID && id != 0)
+	{
+		const MetaDataSlot& md = getSchema().slots[id];
+
+		if (!hasValue(id))
+			return md.defaultFloat;
+
+		if (mNativeFlags & (1u << id))
+		{
+			if (md.storage == STORE_FLOAT)
+				return mNumbers[md.slot].f;
+
+			if (md.storage == STORE_INT)
+				return (float)mNumbers[md.slot].i;
+		}
+	}
+
 	return (float)atof(get(key).c_str());
 }
 
@@ -59,9 +59,18 @@ enum MetaDataListType
 
 const std::vector<MetaDataDecl>& getMDDByType(MetaDataListType type);
 
+struct MetaDataSchema;
+
+// Values are kept in fixed slots described by a per-type schema built from the MetaDataDecl tables :
+// ints, floats, bools and dates are stored natively, genre/developer/publisher-like strings are interned and shared between games,
+// and only free text (descriptions, paths...) is owned by the list. A value is only stored natively when it converts back to the
+// exact same string, so get() always returns what was set.
 class MetaDataList
 {
 public:
+	// Capacity of the fixed storage, the schema falls back to plain strings for the declarations that don't fit
+	enum { MAX_METADATA_IDS = 32, MAX_NUMBER_SLOTS = 6, MAX_INTERNED_SLOTS = 8 };
+
 	static MetaDataList createFromXML(MetaDataListType type, pugi::xml_node& node, SystemData* system);
 	void appendToXML(pugi::xml_node& parent, bool ignoreDefaults, const std::string& relativeTo) const;
 
@@ -77,39 +86,60 @@ public:
 	void resetChangedFlag();
 	void setDirty() { mWasChanged = true; }
 
+	// Changes every time a value changes. Unique across all lists, so values derived from a list (sort keys...) can be stamped with it.
+	inline unsigned int getVersion() const { return mVersion; }
+
 	inline MetaDataListType getType() const { return (MetaDataListType) mType; }
 	inline const std::vector<MetaDataDecl>& getMDD() const { return getMDDByType(getType()); }
 	const std::string& getName() const;
 
 	void importScrappedMetadata(const MetaDataList& source);
 
+	// Raw access to the stored (id, value) pairs, used by the binary gamelist cache
+	std::vector<std::pair<unsigned char, std::string>> getRawValues() const;
+	static MetaDataList createFromRawValues(MetaDataListType type, const std::vector<std::pair<unsigned char, std::string>>& values, SystemData* system);
+
+	// Memory report : bytes used by this list, and what the former std::map<id, std::string> storage would have used for the same values
+	size_t getMemoryUsage() const;
+	size_t getLegacyMemoryUsage() const;
+	static size_t getInternedStringsCount();
+
 private:
+	union NumberSlot
+	{
+		int			i;
+		float		f;
+		long long	t; // packed YYYYMMDDhhmmss
+	};
+
 	std::string		mName;
 	unsigned char	mType;
 	bool			mWasChanged;
 	SystemData*		mRelativeTo;
+	unsigned int	mVersion;
 
-	std::map<unsigned char, std::string> mMap;
-
-	unsigned char getId(const std::string& key) const;	
-	MetaDataType getType(unsigned char id) const;
-
+	unsigned int	mSetFlags;		// one bit per id : a value was stored (even if it is the default one)
+	unsigned int	mNativeFlags;	// one bit per id : the value lives in its typed slot instead of mStrings
+	unsigned int	mBoolValues;
+	unsigned int	mShortFloats;	// one bit per id : the float was written as "0.8" instead of "0.800000"
 
-private: // Static maps
+	NumberSlot			mNumbers[MAX_NUMBER_SLOTS];
+	const std::string*	mInterned[MAX_INTERNED_SLOTS];
 
-	static std::map<unsigned char, std::string> mDefaultGameMap;
-	static std::map<unsigned char, std::string> mDefaultFolderMap;
+	std::vector<std::pair<unsigned char, std::string>> mStrings; // sorted by id
 
-	static std::map<std::string, unsigned char> mGameIdMap;
-	static std::map<std::string, unsigned char> mFolderIdMap;
+	const MetaDataSchema& getSchema() const;
+	unsigned char getId(const std::string& key) const;
+	MetaDataType getType(unsigned char id) const;
 
-	static std::map<unsigned char, MetaDataType> mGameTypeMap;
-	static std::map<unsigned char, MetaDataType> mFolderTypeMap;
+	inline bool hasValue(unsigned char id) const { return (mSetFlags & (1u << id)) != 0; }
 
-	static std::map<unsigned char, std::string> BuildDefaultMap(MetaDataListType type);
-	static std::map<std::string, unsigned char> BuildIdMap(MetaDataListType type);
-	static std::map<unsigned char, MetaDataType> BuildTypeMap(MetaDataListType type);
+	void storeValue(unsigned char id, const std::string& value);
+	std::string getStoredValue(unsigned char id) const;
 
+	const std::string* findString(unsigned char id) const;
+	void setString(unsigned char id, const std::string& value);
+	void removeString(unsigned char id);
 };
 
 #endif // ES_APP_META_DATA_H
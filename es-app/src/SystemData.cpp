@@ -19,6 +19,9 @@
 #include "Window.h"
 #include "views/ViewController.h"
 #include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
 
 using namespace Utils;
 
@@ -130,17 +133,31 @@ void SystemData::populateFolder(FolderData* folder, std::unordered_map<std::stri
 		}
 	}
 	
-//	std::string filePath;
 	std::string extension;
 	bool isGame;
 	bool showHidden = Settings::getInstance()->getBool("ShowHiddenFiles");
-	
+	bool scanPorts = Settings::getInstance()->getBool("ScanPorts");
+	bool async = Utils::Async::isCanRunAsync();
+
+	// Entries are collected in directory order and attached once every subfolder is scanned, so the children order doesn't depend on task scheduling.
+	// Each subfolder fills its own map, which is merged here : no lock is needed on fileMap.
+	struct ScanItem
+	{
+		ScanItem(FileData* _file, const std::string& _path) : file(_file), path(_path) { }
+
+		FileData* file;
+		std::string path;
+		std::unordered_map<std::string, FileData*> fileMap; // subfolder content
+	};
+
+	std::deque<ScanItem> items; // deque : references must stay valid while subfolder tasks run
+	std::unique_ptr<TaskGroup> subFolders;
+
 	Utils::FileSystem::fileList dirContent = Utils::FileSystem::getDirInfo(folderPath);
 
 	for(Utils::FileSystem::fileList::const_iterator it = dirContent.cbegin(); it != dirContent.cend(); ++it)
 	{
 		auto fileInfo = *it;
-		//filePath = *it;
 
 		// skip hidden files and folders
 		if(!showHidden && fileInfo.hidden)
@@ -154,20 +171,16 @@ void SystemData::populateFolder(FolderData* folder, std::unordered_map<std::stri
 		//see issue #75: https://github.com/Aloshi/EmulationStation/issues/75
 		
 		isGame = false;
-		if (mEnvData->isValidExtension(extension)) //std::find(mEnvData->mSearchExtensions.cbegin(), mEnvData->mSearchExtensions.cend(), extension) != mEnvData->mSearchExtensions.cend())
+		if (mEnvData->isValidExtension(extension))
 		{
-			//if (fileMap.find(fileInfo.path) == fileMap.end())
-			//{
-				FileData* newGame = new FileData(GAME, fileInfo.path, this);
+			FileData* newGame = new FileData(GAME, fileInfo.path, this);
 
-				// preventing new arcade assets to be added
-				if (extension != ".zip" || !newGame->isArcadeAsset())
-				{
-					folder->addChild(newGame);
-					fileMap[fileInfo.path] = newGame;
-					isGame = true;
-				}
-			//}
+			// preventing new arcade assets to be added
+			if (extension != ".zip" || !newGame->isArcadeAsset())
+			{
+				items.push_back(ScanItem(newGame, fileInfo.path));
+				isGame = true;
+			}
 		}
 		
 		//add directories that also do not match an extension as folders
@@ -176,7 +189,7 @@ void SystemData::populateFolder(FolderData* folder, std::unordered_map<std::stri
 			std::string fn = Utils::String::toLower(Utils::FileSystem::getFileName(fileInfo.path));
 			// Don't loose time looking in downloaded_images, downloaded_videos & media folders
 
-			if (Settings::getInstance()->getBool("ScanPorts") == 1){
+			if (scanPorts){
 				if (Utils::String::startsWith(fn, "downloaded_") || fn == "media" || fn == "images" || fn == "videos" || fn == "ppsspp" || Utils::String::startsWith(fn, "."))
 				  continue;
 			}
@@ -186,19 +199,49 @@ void SystemData::populateFolder(FolderData* folder, std::unordered_map<std::stri
 			}
 
 			FolderData* newFolder = new FolderData(fileInfo.path, this);
-			populateFolder(newFolder, fileMap);
+			items.push_back(ScanItem(newFolder, fileInfo.path));
 
-			if (newFolder->getChildren().size() == 0)
-				delete newFolder;
-			else
+			ScanItem* item = &items.back();
+
+			if (async)
 			{
-				const std::string& key = newFolder->getPath();
-				if (fileMap.find(key) == fileMap.end())
-				{
-					folder->addChild(newFolder);
-					fileMap[key] = newFolder;
-				}
+				if (subFolders == nullptr)
+					subFolders.reset(new TaskGroup());
+
+				subFolders->run([this, newFolder, item] { populateFolder(newFolder, item->fileMap); });
 			}
+			else
+				populateFolder(newFolder, item->fileMap);
+		}
+	}
+
+	if (subFolders != nullptr)
+		subFolders->wait();
+
+	for (auto& item : items)
+	{
+		if (item.file->getType() != FOLDER)
+		{
+			folder->addChild(item.file);
+			fileMap[item.path] = item.file;
+			continue;
+		}
+
+		FolderData* newFolder = (FolderData*)item.file;
+		if (newFolder->getChildren().size() == 0)
+		{
+			delete newFolder;
+			continue;
+		}
+
+		for (auto& child : item.fileMap)
+			fileMap[child.first] = child.second;
+
+		const std::string& key = newFolder->getPath();
+		if (fileMap.find(key) == fileMap.end())
+		{
+			folder->addChild(newFolder);
+			fileMap[key] = newFolder;
 		}
 	}
 }
@@ -375,6 +418,7 @@ SystemData* SystemData::loadSystem(pugi::xml_node system)
 	envData->mPlatformIds = platformIds;
 	envData->mEmulators = emulatorList;
 	envData->mGroup = system.child("group").text().get();
+	envData->mMediaIndex = std::make_shared<MediaIndex>(path);
 
 	SystemData* newSys = new SystemData(md, envData);
 	if (newSys->getRootFolder()->getChildren().size() == 0)
@@ -507,28 +551,28 @@ bool SystemData::loadConfig(Window* window)
 
 	typedef SystemData* SystemDataPtr;
 
-	ThreadPool* pThreadPool = NULL;
+	TaskGroup* pTaskGroup = NULL;
 	SystemDataPtr* systems = NULL;
 	
 	if (Utils::Async::isCanRunAsync())
 	{
         LOG(LogInfo) << "SystemData::loadConfig() - Thread Loading Collection Systems!";
-		pThreadPool = new ThreadPool();
+		pTaskGroup = new TaskGroup();
 
 		systems = new SystemDataPtr[systemCount];
 		for (int i = 0; i < systemCount; i++)
 			systems[i] = nullptr;
 
-		pThreadPool->queueWorkItem([] { CollectionSystemManager::get()->loadCollectionSystems(true); });
+		pTaskGroup->run([] { CollectionSystemManager::get()->loadCollectionSystems(true); });
 	}
 
-	int processedSystem = 0;
+	std::atomic<int> processedSystem(0);
 	
 	for (pugi::xml_node system = systemList.child("system"); system; system = system.next_sibling("system"))
 	{		
-		if (pThreadPool != NULL)
+		if (pTaskGroup != NULL)
 		{
-			pThreadPool->queueWorkItem([system, currentSystem, systems, &processedSystem]
+			pTaskGroup->run([system, currentSystem, systems, &processedSystem]
 			{				
 				systems[currentSystem] = loadSystem(system);
 				processedSystem++;
@@ -552,11 +596,11 @@ bool SystemData::loadConfig(Window* window)
 		currentSystem++;
 	}
 
-	if (pThreadPool != NULL)
+	if (pTaskGroup != NULL)
 	{
 		if (window != NULL)
 		{
-			pThreadPool->wait([window, &processedSystem, systemCount, &systemsNames]
+			pTaskGroup->wait([window, &processedSystem, systemCount, &systemsNames]
 			{
 				int px = processedSystem - 1;
 				if (px >= 0 && px < systemsNames.size())
@@ -564,7 +608,7 @@ bool SystemData::loadConfig(Window* window)
 			}, 10);
 		}
 		else
-			pThreadPool->wait();
+			pTaskGroup->wait();
 
 		for (int i = 0; i < systemCount; i++)
 		{
@@ -574,7 +618,7 @@ bool SystemData::loadConfig(Window* window)
 		}
 		
 		delete[] systems;
-		delete pThreadPool;
+		delete pTaskGroup;
 
 		if (window != NULL)
 			window->renderLoadingScreen(_("Favorites"), systemCount == 0 ? 0 : currentSystem / systemCount);
@@ -856,7 +900,14 @@ FileData* SystemData::getRandomGame()
 int SystemData::getDisplayedGameCount() 
 {
 	if (mGameCount < 0)
-		mGameCount = mRootFolder->getFilesRecursive(GAME, true).size();
+	{
+		// auto collections only hold a few games until their gamelist is opened
+		if (mIsCollectionSystem)
+			mGameCount = CollectionSystemManager::get()->getUnpopulatedGameCount(this);
+
+		if (mGameCount < 0)
+			mGameCount = mRootFolder->getFilesRecursive(GAME, true).size();
+	}
 
 	return mGameCount;
 }
@@ -14,6 +14,7 @@
 #include <unordered_set>
 
 #include "FileFilterIndex.h"
+#include "MediaIndex.h"
 #include "Settings.h"
 
 class FileData;
@@ -50,6 +51,7 @@ struct SystemEnvironmentData
 	std::vector<PlatformIds::PlatformId> mPlatformIds;
 	std::vector<EmulatorData> mEmulators;
 	std::string mGroup;
+	std::shared_ptr<MediaIndex> mMediaIndex; // local art of the games, nullptr for the systems without start path
 
 	bool isValidExtension(const std::string extension)
 	{
@@ -0,0 +1,116 @@
+#include <string>
+#include "bench/BenchmarkRunner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+BenchmarkRunner::BenchmarkRunner(int iterations) : mIterations(iterations > 0 ? iterations : 1)
+{
+}
+
+void BenchmarkRunner::run(const std::string& name, const std::function<void()>& work, const std::function<void()>& setup, int iterations)
+{
+	if (iterations <= 0)
+		iterations = mIterations;
+
+	std::vector<double> timings;
+	timings.reserve(iterations);
+
+	for (int i = 0; i < iterations; i++)
+	{
+		if (setup)
+			setup();
+
+		auto start = std::chrono::steady_clock::now();
+		work();
+		auto end = std::chrono::steady_clock::now();
+
+		timings.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+	}
+
+	std::sort(timings.begin(), timings.end());
+
+	double total = 0;
+	for (auto timing : timings)
+		total += timing;
+
+	Result result;
+	result.name = name;
+	result.iterations = iterations;
+	result.minMs = timings.front();
+	result.maxMs = timings.back();
+	result.meanMs = total / iterations;
+	result.medianMs = (iterations % 2) ? timings[iterations / 2] : (timings[iterations / 2 - 1] + timings[iterations / 2]) / 2.0;
+	mResults.push_back(result);
+
+	fprintf(stderr, "  %-48s %10.3f ms (median of %d)\n", name.c_str(), result.medianMs, iterations);
+}
+
+void BenchmarkRunner::addValue(const std::string& name, double value)
+{
+	mValues.push_back(std::pair<std::string, double>(name, value));
+	fprintf(stderr, "  %-48s %10.3f\n", name.c_str(), value);
+}
+
+void BenchmarkRunner::addParameter(const std::string& name, double value)
+{
+	mParameters.push_back(std::pair<std::string, double>(name, value));
+}
+
+static std::string escapeJson(const std::string& value)
+{
+	std::string ret;
+	for (auto c : value)
+	{
+		if (c == '"' || c == '\\')
+			ret += '\\';
+
+		ret += c;
+	}
+
+	return ret;
+}
+
+bool BenchmarkRunner::writeJson(const std::string& path) const
+{
+	FILE* file = path.empty() ? stdout : fopen(path.c_str(), "wb");
+	if (file == nullptr)
+	{
+		fprintf(stderr, "Unable to write \"%s\"\n", path.c_str());
+		return false;
+	}
+
+	fprintf(file, "{\n\t\"parameters\": {");
+	for (size_t i = 0; i < mParameters.size(); i++)
+		fprintf(file, "%s\n\t\t\"%s\": %g", i ? "," : "", escapeJson(mParameters[i].first).c_str(), mParameters[i].second);
+
+	fprintf(file, "\n\t},\n\t\"results\": [");
+	for (size_t i = 0; i < mResults.size(); i++)
+	{
+		const Result& result = mResults[i];
+		fprintf(file, "%s\n\t\t{ \"name\": \"%s\", \"iterations\": %d, \"min_ms\": %.4f, \"median_ms\": %.4f, \"mean_ms\": %.4f, \"max_ms\": %.4f }",
+			i ? "," : "", escapeJson(result.name).c_str(), result.iterations, result.minMs, result.medianMs, result.meanMs, result.maxMs);
+	}
+
+	fprintf(file, "\n\t],\n\t\"values\": {");
+	for (size_t i = 0; i < mValues.size(); i++)
+		fprintf(file, "%s\n\t\t\"%s\": %g", i ? "," : "", escapeJson(mValues[i].first).c_str(), mValues[i].second);
+
+	fprintf(file, "\n\t}\n}\n");
+
+	bool written = (ferror(file) == 0);
+	if (file != stdout)
+		fclose(file);
+	else
+		fflush(file);
+
+	return written;
+}
+
+void BenchmarkRunner::printSummary() const
+{
+	fprintf(stderr, "\n%-50s %10s %10s %10s %10s\n", "case", "min", "median", "mean", "max");
+	for (auto& result : mResults)
+		fprintf(stderr, "%-50s %10.3f %10.3f %10.3f %10.3f\n", result.name.c_str(), result.minMs, result.medianMs, result.meanMs, result.maxMs);
+}
@@ -0,0 +1,46 @@
+#include <string>
+#pragma once
+#ifndef ES_APP_BENCH_BENCHMARK_RUNNER_H
+#define ES_APP_BENCH_BENCHMARK_RUNNER_H
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+// Times benchmark cases and reports them as JSON (machine readable, for regression tracking) and as a text table.
+class BenchmarkRunner
+{
+public:
+	struct Result
+	{
+		std::string	name;
+		int			iterations;
+		double		minMs;
+		double		medianMs;
+		double		meanMs;
+		double		maxMs;
+	};
+
+	BenchmarkRunner(int iterations);
+
+	// Runs 'work' 'iterations' times (or the runner default if <= 0). 'setup' runs before each iteration and isn't timed.
+	void run(const std::string& name, const std::function<void()>& work, const std::function<void()>& setup = nullptr, int iterations = 0);
+
+	// Records a value measured by the caller (a single timing, a count...)
+	void addValue(const std::string& name, double value);
+	void addParameter(const std::string& name, double value);
+
+	bool writeJson(const std::string& path) const; // empty path -> stdout
+	void printSummary() const; // stderr
+
+	inline int getIterations() const { return mIterations; }
+
+private:
+	int mIterations;
+
+	std::vector<Result> mResults;
+	std::vector<std::pair<std::string, double>> mValues;
+	std::vector<std::pair<std::string, double>> mParameters;
+};
+
+#endif // ES_APP_BENCH_BENCHMARK_RUNNER_H
@@ -0,0 +1,164 @@
+#include <string>
+#include "bench/SyntheticLibrary.h"
+
+#include "utils/FileSystemUtil.h"
+#include <cstdio>
+#include <sstream>
+
+static const char* sPlatforms[] = { "nes", "snes", "megadrive", "psx", "arcade", "gb" };
+static const char* sAdjectives[] = { "Super", "Mega", "Final", "Dark", "Little", "Crazy", "Golden", "Lost", "Ultimate", "Space", "Ninja", "Royal" };
+static const char* sNouns[] = { "Dragon", "Quest", "Racer", "Knight", "Fighter", "Island", "Castle", "Soccer", "Puzzle", "Galaxy", "Warrior", "Tennis", "Legend" };
+static const char* sGenres[] = { "Action", "Platform", "Shoot'em Up", "Racing", "Sports", "Puzzle", "RPG", "Fighting", "Adventure", "Strategy", "Simulation", "Beat'em Up" };
+static const char* sPlayers[] = { "1", "1-2", "2", "1-4", "1+" };
+static const char* sMediaTags[] = { "image", "thumbnail", "marquee", "video" };
+static const char* sMediaExtensions[] = { ".png", ".png", ".png", ".mp4" };
+
+#define COUNT_OF(x) (int)(sizeof(x) / sizeof(x[0]))
+
+// Small LCG : the same parameters must always produce the same library
+class Random
+{
+public:
+	Random(unsigned int seed) : mState(seed) { }
+
+	unsigned int next(unsigned int range)
+	{
+		mState = mState * 1103515245u + 12345u;
+		return ((mState >> 8) & 0xFFFFFF) % range;
+	}
+
+private:
+	unsigned int mState;
+};
+
+static bool createEmptyFile(const std::string& path)
+{
+	FILE* file = fopen(path.c_str(), "wb");
+	if (file == nullptr)
+		return false;
+
+	fclose(file);
+	return true;
+}
+
+static std::string format(const char* fmt, int value)
+{
+	char buffer[64];
+	snprintf(buffer, sizeof(buffer), fmt, value);
+	return buffer;
+}
+
+SyntheticLibrary::SyntheticLibrary(const std::string& root, const Parameters& parameters) : mParameters(parameters)
+{
+	std::stringstream ss;
+	ss << root << "/s" << parameters.systems << "-g" << parameters.games << "-m" << parameters.media << "-f" << parameters.gamesPerFolder;
+	mHome = ss.str();
+}
+
+bool SyntheticLibrary::generate()
+{
+	// es_systems.cfg is written last : if it exists, the library is complete
+	std::string configPath = mHome + "/.emulationstation/es_systems.cfg";
+	if (Utils::FileSystem::exists(configPath))
+		return true;
+
+	if (!Utils::FileSystem::createDirectory(mHome + "/.emulationstation"))
+		return false;
+
+	std::stringstream config;
+	config << "<?xml version=\"1.0\"?>\n<systemList>\n";
+
+	for (int i = 0; i < mParameters.systems; i++)
+	{
+		if (!generateSystem(i))
+			return false;
+
+		config << "\t<system>\n";
+		config << "\t\t<name>bench" << i << "</name>\n";
+		config << "\t\t<fullname>Benchmark " << i << "</fullname>\n";
+		config << "\t\t<path>" << mHome << "/roms/bench" << i << "</path>\n";
+		config << "\t\t<extension>.zip .7z</extension>\n";
+		config << "\t\t<command>true %ROM%</command>\n";
+		config << "\t\t<platform>" << sPlatforms[i % COUNT_OF(sPlatforms)] << "</platform>\n";
+		config << "\t\t<theme>bench</theme>\n";
+		config << "\t</system>\n";
+	}
+
+	config << "</systemList>\n";
+
+	Utils::FileSystem::writeAllText(configPath, config.str());
+	return Utils::FileSystem::exists(configPath);
+}
+
+bool SyntheticLibrary::generateSystem(int index)
+{
+	std::string systemPath = mHome + "/roms/bench" + std::to_string(index);
+	std::string mediaPath = systemPath + "/media";
+
+	if (!Utils::FileSystem::createDirectory(systemPath) || (mParameters.media > 0 && !Utils::FileSystem::createDirectory(mediaPath)))
+		return false;
+
+	Random random(1234 + index);
+
+	std::stringstream gamelist;
+	gamelist << "<?xml version=\"1.0\"?>\n<gameList>\n";
+
+	for (int i = 0; i < mParameters.games; i++)
+	{
+		std::string name = std::string(random.next(8) == 0 ? "The " : "") + sAdjectives[random.next(COUNT_OF(sAdjectives))] + " " + sNouns[random.next(COUNT_OF(sNouns))] + " " + std::to_string(i % 97 + 1);
+		std::string stem = format("%05d ", i) + name;
+
+		std::string folder;
+		if (mParameters.gamesPerFolder > 0)
+		{
+			folder = format("Folder %03d", i / mParameters.gamesPerFolder);
+			if (i % mParameters.gamesPerFolder == 0 && !Utils::FileSystem::createDirectory(systemPath + "/" + folder))
+				return false;
+
+			folder += "/";
+		}
+
+		if (!createEmptyFile(systemPath + "/" + folder + stem + ".zip"))
+			return false;
+
+		gamelist << "\t<game>\n";
+		gamelist << "\t\t<path>./" << folder << stem << ".zip</path>\n";
+		gamelist << "\t\t<name>" << name << "</name>\n";
+		gamelist << "\t\t<desc>" << name << " is a synthetic game generated by es-bench. Its only purpose is to make the gamelist look like a scraped one, description included.</desc>\n";
+
+		for (int m = 0; m < mParameters.media && m < COUNT_OF(sMediaTags); m++)
+		{
+			std::string media = stem + "-" + sMediaTags[m] + sMediaExtensions[m];
+			if (!createEmptyFile(mediaPath + "/" + media))
+				return false;
+
+			gamelist << "\t\t<" << sMediaTags[m] << ">./media/" << media << "</" << sMediaTags[m] << ">\n";
+		}
+
+		gamelist << "\t\t<rating>" << (random.next(11) / 10.0f) << "</rating>\n";
+		gamelist << "\t\t<releasedate>" << (1980 + random.next(40)) << format("%02d", 1 + random.next(12)) << format("%02d", 1 + random.next(28)) << "T000000</releasedate>\n";
+		gamelist << "\t\t<developer>Developer " << random.next(60) << "</developer>\n";
+		gamelist << "\t\t<publisher>Publisher " << random.next(30) << "</publisher>\n";
+		gamelist << "\t\t<genre>" << sGenres[random.next(COUNT_OF(sGenres))] << "</genre>\n";
+		gamelist << "\t\t<players>" << sPlayers[random.next(COUNT_OF(sPlayers))] << "</players>\n";
+
+		if (random.next(4) == 0)
+		{
+			gamelist << "\t\t<playcount>" << (1 + random.next(30)) << "</playcount>\n";
+			gamelist << "\t\t<lastplayed>2020" << format("%02d", 1 + random.next(12)) << format("%02d", 1 + random.next(28)) << "T" << format("%02d", random.next(24)) << "3000</lastplayed>\n";
+		}
+
+		if (random.next(10) == 0)
+			gamelist << "\t\t<favorite>true</favorite>\n";
+
+		if (random.next(15) == 0)
+			gamelist << "\t\t<kidgame>true</kidgame>\n";
+
+		gamelist << "\t</game>\n";
+	}
+
+	gamelist << "</gameList>\n";
+
+	Utils::FileSystem::writeAllText(systemPath + "/gamelist.xml", gamelist.str());
+	return true;
+}
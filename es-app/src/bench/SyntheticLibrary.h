@@ -0,0 +1,36 @@
+#include <string>
+#pragma once
+#ifndef ES_APP_BENCH_SYNTHETIC_LIBRARY_H
+#define ES_APP_BENCH_SYNTHETIC_LIBRARY_H
+
+// Generates a fake home folder for es-bench : es_systems.cfg, ROM trees (empty files), media files and gamelist.xml files.
+// The content is deterministic, so two runs with the same parameters benchmark the same library.
+class SyntheticLibrary
+{
+public:
+	struct Parameters
+	{
+		Parameters() : systems(4), games(2000), media(2), gamesPerFolder(0) { }
+
+		int systems;
+		int games;			// per system
+		int media;			// media files per game (image, thumbnail, marquee, video)
+		int gamesPerFolder;	// 0 -> every game at the root of the system folder
+	};
+
+	// The library goes to a subfolder of 'root' named after the parameters, and is only generated once
+	SyntheticLibrary(const std::string& root, const Parameters& parameters);
+
+	bool generate();
+
+	inline const std::string& getHomePath() const { return mHome; }
+	inline const Parameters& getParameters() const { return mParameters; }
+
+private:
+	bool generateSystem(int index);
+
+	std::string	mHome;
+	Parameters	mParameters;
+};
+
+#endif // ES_APP_BENCH_SYNTHETIC_LIBRARY_H
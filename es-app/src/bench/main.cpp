@@ -0,0 +1,373 @@
+#include <string>
+// es-bench : headless benchmarks of the library loading and browsing code paths.
+// Generates a synthetic library, then times system loading, gamelist parsing, folder scanning, collections,
+// sorting and filtering, and the pixel kernels of the image loading. Nothing is rendered : no display or GPU is needed.
+
+#include "bench/BenchmarkRunner.h"
+#include "bench/SyntheticLibrary.h"
+#include "utils/FileSystemUtil.h"
+#include "utils/PixelUtil.h"
+#include "views/ViewController.h"
+#include "CollectionSystemManager.h"
+#include "FileData.h"
+#include "FileFilterIndex.h"
+#include "FileSorts.h"
+#include "Gamelist.h"
+#include "Log.h"
+#include "Settings.h"
+#include "SystemData.h"
+#include "Window.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string.h>
+
+static void printUsage()
+{
+	fprintf(stderr,
+		"es-bench - EmulationStation headless benchmarks\n\n"
+		"--systems [count]	systems to generate (default 4)\n"
+		"--games [count]		games per system (default 2000)\n"
+		"--media [count]		media files per game, 0 to 4 (default 2)\n"
+		"--folders [count]	games per subfolder, 0 for a flat system folder (default 0)\n"
+		"--iterations [count]	iterations per case (default 5)\n"
+		"--root [path]		where the synthetic libraries are generated (default /tmp/es-bench)\n"
+		"--output [path]		write the JSON results to a file instead of stdout\n");
+}
+
+static std::vector<SystemData*> getGameSystems()
+{
+	std::vector<SystemData*> ret;
+	for (auto system : SystemData::sSystemVector)
+		if (system->isGameSystem() && !system->isCollection())
+			ret.push_back(system);
+
+	return ret;
+}
+
+// Same sequence as the "reload" actions of the menus
+static void reloadSystems(Window* window)
+{
+	CollectionSystemManager::deinit();
+	CollectionSystemManager::init(window);
+	SystemData::loadConfig(nullptr);
+}
+
+static void benchLoading(BenchmarkRunner& runner, Window* window)
+{
+	Settings* settings = Settings::getInstance();
+
+	settings->setBool("GamelistCache", false);
+	runner.run("SystemData::loadConfig (gamelist.xml)", [window] { reloadSystems(window); });
+
+	settings->setBool("GamelistCache", true);
+	reloadSystems(window); // writes the caches
+	runner.run("SystemData::loadConfig (gamelist cache)", [window] { reloadSystems(window); });
+
+	settings->setBool("IgnoreGamelist", true);
+	runner.run("SystemData::loadConfig (populateFolder only)", [window] { reloadSystems(window); });
+	settings->setBool("IgnoreGamelist", false);
+
+	settings->setBool("ParseGamelistOnly", true);
+	runner.run("SystemData::loadConfig (parseGamelist only)", [window] { reloadSystems(window); });
+	settings->setBool("ParseGamelistOnly", false);
+
+	reloadSystems(window);
+
+	int games = 0;
+	for (auto system : getGameSystems())
+		games += (int)system->getRootFolder()->getFilesRecursive(GAME).size();
+
+	runner.addValue("games", games);
+
+	// Applies the gamelists again over the loaded trees, like a gamelist reload does
+	runner.run("parseGamelist (all systems)", []
+	{
+		for (auto system : getGameSystems())
+		{
+			std::unordered_map<std::string, FileData*> fileMap;
+			for (auto file : system->getRootFolder()->getFilesRecursive(GAME | FOLDER))
+				fileMap[file->getPath()] = file;
+
+			parseGamelist(system, fileMap);
+		}
+	});
+}
+
+static void benchCollections(BenchmarkRunner& runner, Window* window)
+{
+	Settings* settings = Settings::getInstance();
+	std::string enabled = settings->getString("CollectionSystemsAuto");
+
+	// Collections are loaded unpopulated, then every automatic collection is populated
+	settings->setString("CollectionSystemsAuto", "");
+
+	runner.run("CollectionSystemManager::populateAutoCollection (all)", []
+	{
+		for (auto& collection : CollectionSystemManager::get()->getAutoCollectionSystems())
+			if (!collection.second.isPopulated)
+				CollectionSystemManager::get()->populateAutoCollection(&collection.second);
+	},
+	[window] { reloadSystems(window); });
+
+	settings->setString("CollectionSystemsAuto", enabled);
+	reloadSystems(window);
+}
+
+static void benchSorting(BenchmarkRunner& runner)
+{
+	std::vector<SystemData*> systems = getGameSystems();
+
+	// Copied : FileSorts::reset() destroys the list
+	std::vector<FileSorts::SortType> sorts = FileSorts::getSortTypes();
+
+	for (auto& sort : sorts)
+	{
+		int sortId = sort.id;
+		for (auto system : systems)
+			system->setSortId(sortId);
+
+		// Sort keys and display lists are rebuilt after a reset, then served from the cache
+		runner.run("getChildrenListToDisplay (" + sort.description + ")", [&systems]
+		{
+			for (auto system : systems)
+				system->getRootFolder()->getChildrenListToDisplay();
+		},
+		[] { FileSorts::reset(); });
+
+		runner.run("getChildrenListToDisplay (" + sort.description + ", cached)", [&systems]
+		{
+			for (auto system : systems)
+				system->getRootFolder()->getChildrenListToDisplay();
+		});
+	}
+
+	for (auto system : systems)
+		system->setSortId(0);
+}
+
+static void selectFirstKeys(FileFilterIndex* index, FilterIndexType type, size_t count)
+{
+	std::vector<std::string> keys;
+	for (auto& decl : index->getFilterDataDecls())
+	{
+		if (decl.type != type)
+			continue;
+
+		for (auto& key : *decl.allIndexKeys)
+			if (keys.size() < count)
+				keys.push_back(key.first);
+	}
+
+	index->setFilter(type, &keys);
+}
+
+static void benchFiltering(BenchmarkRunner& runner)
+{
+	std::vector<SystemData*> systems = getGameSystems();
+
+	runner.run("SystemData::getIndex (build)", [&systems]
+	{
+		for (auto system : systems)
+			system->getIndex(true);
+	},
+	[&systems]
+	{
+		for (auto system : systems)
+			system->deleteIndex();
+	}, 1);
+
+	for (auto system : systems)
+	{
+		FileFilterIndex* index = system->getIndex(true);
+		selectFirstKeys(index, GENRE_FILTER, 3);
+		selectFirstKeys(index, PLAYER_FILTER, 2);
+	}
+
+	runner.run("FileFilterIndex::showFile (genre + players)", [&systems]
+	{
+		for (auto system : systems)
+		{
+			FileFilterIndex* index = system->getIndex(false);
+			for (auto game : system->getRootFolder()->getFilesRecursive(GAME))
+				index->showFile(game);
+		}
+	});
+
+	runner.run("FileFilterIndex::getFilteredCounts (genre)", [&systems]
+	{
+		for (auto system : systems)
+			system->getIndex(false)->getFilteredCounts(GENRE_FILTER);
+	});
+
+	runner.run("getChildrenListToDisplay (filtered)", [&systems]
+	{
+		for (auto system : systems)
+			system->getRootFolder()->getChildrenListToDisplay();
+	},
+	[&systems]
+	{
+		// Changing the filters invalidates the display lists
+		for (auto system : systems)
+			selectFirstKeys(system->getIndex(false), PLAYER_FILTER, 2);
+	});
+
+	for (auto system : systems)
+		system->getIndex(false)->resetFilters();
+}
+
+// Times each pixel kernel with every implementation the CPU has, and checks they give the scalar results.
+// Returns the number of kernels that don't.
+static int benchPixels(BenchmarkRunner& runner)
+{
+	const size_t width = 1024;
+	const size_t height = 1024;
+
+	std::vector<unsigned char> source(width * height * 4);
+	unsigned int seed = 12345;
+	for (auto& c : source)
+	{
+		seed = seed * 1103515245 + 12345;
+		c = (unsigned char)(seed >> 16);
+	}
+
+	// Every kernel, on the same picture : swizzled, flipped, premultiplied, halved then downscaled to an odd size, and swizzled as 565 pixels
+	auto runKernels = [&source, width, height](std::vector<unsigned char>& pixels)
+	{
+		pixels.resize(width * height * 4 + (width / 2) * (height / 2) * 4 + 300 * 200 * 4 + width * height * 2);
+
+		unsigned char* half = pixels.data() + width * height * 4;
+		unsigned char* odd = half + (width / 2) * (height / 2) * 4;
+		unsigned char* rgb565 = odd + 300 * 200 * 4;
+
+		Utils::Pixel::swapRedBlue(source.data(), pixels.data(), width * height);
+		Utils::Pixel::flipVertical(pixels.data(), width, height);
+		Utils::Pixel::premultiplyAlpha(pixels.data(), width * height);
+		Utils::Pixel::boxDownscale(pixels.data(), width, height, width * 4, half, width / 2, height / 2);
+		Utils::Pixel::boxDownscale(pixels.data(), width, height, width * 4, odd, 300, 200);
+
+		memcpy(rgb565, source.data(), width * height * 2);
+		Utils::Pixel::swapRedBlue565(rgb565, width * height);
+	};
+
+	Utils::Pixel::Implementation defaultImplementation = Utils::Pixel::getImplementation();
+
+	std::vector<unsigned char> reference;
+	Utils::Pixel::setImplementation(Utils::Pixel::SCALAR);
+	runKernels(reference);
+
+	int mismatches = 0;
+
+	const Utils::Pixel::Implementation implementations[] = { Utils::Pixel::SCALAR, Utils::Pixel::SSE2, Utils::Pixel::NEON };
+	for (auto implementation : implementations)
+	{
+		if (!Utils::Pixel::setImplementation(implementation))
+			continue;
+
+		std::string name = Utils::Pixel::getImplementationName(implementation);
+
+		std::vector<unsigned char> result;
+		runKernels(result);
+		if (result != reference)
+		{
+			fprintf(stderr, "Pixel kernels : the %s results differ from the scalar ones\n", name.c_str());
+			mismatches++;
+		}
+
+		std::vector<unsigned char> pixels(source);
+		std::vector<unsigned char> half((width / 2) * (height / 2) * 4);
+
+		runner.run("Pixel::swapRedBlue 1024x1024 (" + name + ")", [&] { Utils::Pixel::swapRedBlue(pixels.data(), pixels.data(), width * height); });
+		runner.run("Pixel::swapRedBlue565 1024x1024 (" + name + ")", [&] { Utils::Pixel::swapRedBlue565(pixels.data(), width * height); });
+		runner.run("Pixel::flipVertical 1024x1024 (" + name + ")", [&] { Utils::Pixel::flipVertical(pixels.data(), width, height); });
+		runner.run("Pixel::premultiplyAlpha 1024x1024 (" + name + ")", [&] { Utils::Pixel::premultiplyAlpha(pixels.data(), width * height); }, [&] { pixels = source; });
+		runner.run("Pixel::boxDownscale 1024x1024 -> 512x512 (" + name + ")", [&] { Utils::Pixel::boxDownscale(source.data(), width, height, width * 4, half.data(), width / 2, height / 2); });
+	}
+
+	Utils::Pixel::setImplementation(defaultImplementation);
+	runner.addValue("pixel_kernel_mismatches", mismatches);
+
+	return mismatches;
+}
+
+int main(int argc, char* argv[])
+{
+	SyntheticLibrary::Parameters parameters;
+	std::string root = "/tmp/es-bench";
+	std::string output;
+	int iterations = 5;
+
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = (i + 1 < argc);
+
+		if (strcmp(argv[i], "--systems") == 0 && hasValue)
+			parameters.systems = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--games") == 0 && hasValue)
+			parameters.games = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--media") == 0 && hasValue)
+			parameters.media = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--folders") == 0 && hasValue)
+			parameters.gamesPerFolder = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--iterations") == 0 && hasValue)
+			iterations = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--root") == 0 && hasValue)
+			root = argv[++i];
+		else if (strcmp(argv[i], "--output") == 0 && hasValue)
+			output = argv[++i];
+		else
+		{
+			printUsage();
+			return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+		}
+	}
+
+	SyntheticLibrary library(root, parameters);
+
+	BenchmarkRunner runner(iterations);
+	runner.addParameter("systems", parameters.systems);
+	runner.addParameter("games", parameters.games);
+	runner.addParameter("media", parameters.media);
+	runner.addParameter("gamesPerFolder", parameters.gamesPerFolder);
+	runner.addParameter("iterations", runner.getIterations());
+
+	fprintf(stderr, "Library : %s\n", library.getHomePath().c_str());
+
+	auto start = std::chrono::steady_clock::now();
+	if (!library.generate())
+	{
+		fprintf(stderr, "Unable to generate the synthetic library in \"%s\"\n", library.getHomePath().c_str());
+		return 1;
+	}
+
+	runner.addValue("generate_ms", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+	// Everything (settings, logs, gamelist caches) stays in the synthetic home
+	Utils::FileSystem::setHomePath(library.getHomePath());
+
+	Settings* settings = Settings::getInstance();
+	settings->setBool("SaveGamelistsOnExit", false);
+
+	Log::setupReportingLevel();
+	Log::init();
+
+	// The window is never initialized : it's only there for the classes that need one
+	Window window;
+	ViewController::init(&window);
+	CollectionSystemManager::init(&window);
+
+	benchLoading(runner, &window);
+	benchCollections(runner, &window);
+	benchSorting(runner);
+	benchFiltering(runner);
+	int pixelMismatches = benchPixels(runner);
+
+	runner.printSummary();
+	bool written = runner.writeJson(output);
+
+	CollectionSystemManager::deinit();
+	SystemData::deleteSystems();
+	Log::close();
+
+	return written && pixelMismatches == 0 ? 0 : 1;
+}
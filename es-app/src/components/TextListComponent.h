@@ -45,6 +45,8 @@ public:
 	void render(const Transform4x4f& parentTrans) override;
 	void applyTheme(const std::shared_ptr<ThemeData>& theme, const std::string& view, const std::string& element, unsigned int properties) override;
 
+	bool isAnimating() override { return mMarqueeTime > 0 || IList<TextListData, T>::isAnimating(); }
+
 	void add(const std::string& name, const T& obj, unsigned int colorId);
 	
 	enum Alignment
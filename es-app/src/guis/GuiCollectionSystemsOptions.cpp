@@ -250,10 +250,7 @@ void GuiCollectionSystemsOptions::addSystemsToMenu()
 			autoOptionList->add(it->second.decl.longName, it->second.decl.name, it->second.isEnabled);
 		else
 		{
-			if (!it->second.isPopulated)
-				CollectionSystemManager::get()->populateAutoCollection(&(it->second));
-
-			if (it->second.system->getRootFolder()->getChildren().size() == 0)
+			if (it->second.system->getDisplayedGameCount() == 0)
 				continue;
 
 			if (!hasGroup)
@@ -16,6 +16,7 @@ public:
 
 	bool input(InputConfig* config, Input input);
 	void update(int deltaTime);
+	bool isAnimating() override { return mScrollDir != 0 || GuiComponent::isAnimating(); }
 
 private:
 	void setScrollDir(int dir);
@@ -77,19 +77,54 @@ void GuiGamelistFilter::addFiltersToMenu()
 		if (allKeys->size() > 0)
 			mMenu.addWithLabel(menuLabel, optionList);
 
+		// keep the counts of the other filters up to date while selecting
+		optionList->setSelectedChangedCallback([this](const std::string&)
+		{
+			applySelection();
+			updateCounts();
+		});
+
 		mFilterOptions[type] = optionList;
 	}
+
+	updateCounts();
 }
 
-void GuiGamelistFilter::applyFilters()
+// Shows, next to each key, how many games would be left if it were selected along with the other active filters
+void GuiGamelistFilter::updateCounts()
 {
 	std::vector<FilterDataDecl> decls = mFilterIndex->getFilterDataDecls();
+	for (auto& decl : decls)
+	{
+		auto option = mFilterOptions.find(decl.type);
+		if (option == mFilterOptions.cend())
+			continue;
+
+		std::map<std::string, int> counts = mFilterIndex->getFilteredCounts(decl.type);
+		if (counts.size() == 0)
+			continue;
+
+		for (auto& key : *decl.allIndexKeys)
+		{
+			auto count = counts.find(key.first);
+			if (count != counts.cend())
+				option->second->setEntryName(key.first, key.first + " (" + std::to_string(count->second) + ")");
+		}
+	}
+}
+
+void GuiGamelistFilter::applySelection()
+{
 	for (std::map<FilterIndexType, std::shared_ptr< OptionListComponent<std::string> >>::const_iterator it = mFilterOptions.cbegin(); it != mFilterOptions.cend(); ++it ) {
 		std::shared_ptr< OptionListComponent<std::string> > optionList = it->second;
 		std::vector<std::string> filters = optionList->getSelectedObjects();
 		mFilterIndex->setFilter(it->first, &filters);
 	}
+}
 
+void GuiGamelistFilter::applyFilters()
+{
+	applySelection();
 	delete this;
 
 }
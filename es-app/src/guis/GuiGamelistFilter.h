@@ -23,6 +23,8 @@ public:
 private:
 	void initializeMenu();
 	void applyFilters();
+	void applySelection();
+	void updateCounts();
 	void resetAllFilters();
 	void addFiltersToMenu();
 
@@ -14,6 +14,8 @@
 #include "views/ViewController.h"
 #include "CollectionSystemManager.h"
 #include "EmulationStation.h"
+#include "FileSorts.h"
+#include "FrameProfiler.h"
 #include "Scripting.h"
 #include "SystemData.h"
 #include "VolumeControl.h"
@@ -1257,6 +1259,7 @@ void GuiMenu::openUISettings()
 	{
 		if (Settings::getInstance()->setBool("IgnoreLeadingArticles", ignoreArticles->getState()))
 		{
+			FileSorts::reset();
 			s->setVariable("reloadAll", true);
 		}
 	});
@@ -1887,6 +1890,18 @@ void GuiMenu::openOtherSettings()
 	s->addWithLabel(_("SHOW FRAMERATE"), framerate);
 	s->addSaveFunc([framerate] { Settings::getInstance()->setBool("DrawFramerate", framerate->getState()); });
 
+	// frame profiler
+	auto profiler = std::make_shared<SwitchComponent>(mWindow);
+	profiler->setState(Settings::getInstance()->getBool("FrameProfiler"));
+	s->addWithLabel(_("FRAME PROFILER"), profiler);
+	s->addSaveFunc([profiler]
+	{
+		if (Settings::getInstance()->setBool("FrameProfiler", profiler->getState()) && !profiler->getState())
+			FrameProfiler::dumpChromeTrace(); // keep what was recorded
+
+		FrameProfiler::setEnabled(profiler->getState());
+	});
+
 	// threaded loading
 	auto threadedLoading = std::make_shared<SwitchComponent>(mWindow);
 	threadedLoading->setState(Settings::getInstance()->getBool("ThreadedLoading"));
@@ -11,6 +11,7 @@
 #include "PowerSaver.h"
 #include "SystemData.h"
 #include "Window.h"
+#include "CollectionSystemManager.h"
 
 GuiScraperMulti::GuiScraperMulti(Window* window, const std::queue<ScraperSearchParams>& searches, bool approveResults) :
 	GuiComponent(window), mBackground(window, ":/frame.png"), mGrid(window, Vector2i(1, 5)),
@@ -121,6 +122,7 @@ void GuiScraperMulti::acceptResult(const ScraperSearchResult& result)
 	ScraperSearchParams& search = mSearchQueue.front();
 
 	search.game->getMetadata().importScrappedMetadata(result.mdl);
+	CollectionSystemManager::get()->refreshCollectionSystems(search.game);
 	saveToGamelistRecovery(search.game);
 	// updateGamelist(search.system);
 
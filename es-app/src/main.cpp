@@ -8,6 +8,7 @@
 #include "views/ViewController.h"
 #include "CollectionSystemManager.h"
 #include "EmulationStation.h"
+#include "FrameProfiler.h"
 #include "InputManager.h"
 #include "InputConfig.h"
 #include "Log.h"
@@ -21,6 +22,7 @@
 #include <SDL_events.h>
 #include <SDL_main.h>
 #include <SDL_timer.h>
+#include <algorithm>
 #include <iostream>
 #include <time.h>
 
@@ -30,7 +32,9 @@
 #include <unistd.h>
 #endif
 
+#include "resources/Font.h"
 #include "resources/TextureData.h"
+#include "resources/ThumbnailCache.h"
 #include <FreeImage.h>
 #include "AudioManager.h"
 #include "NetworkThread.h"
@@ -221,6 +225,14 @@ bool parseArgs(int argc, char* argv[])
 		{
 			Settings::getInstance()->setBool("IgnoreGamelist", true);
 		}
+		else if (strcmp(argv[i], "--rebuild-gamelist-cache") == 0)
+		{
+			Settings::getInstance()->setBool("GamelistCacheRebuild", true);
+		}
+		else if (strcmp(argv[i], "--verify-gamelist-cache") == 0)
+		{
+			Settings::getInstance()->setBool("GamelistCacheVerify", true);
+		}
 		else if (strcmp(argv[i], "--show-hidden-files") == 0)
 		{
 			Settings::getInstance()->setBool("ShowHiddenFiles", true);
@@ -229,6 +241,10 @@ bool parseArgs(int argc, char* argv[])
 		{
 			Settings::getInstance()->setBool("DrawFramerate", true);
 		}
+		else if (strcmp(argv[i], "--profile-frames") == 0)
+		{
+			Settings::getInstance()->setBool("FrameProfiler", true);
+		}
 		else if (strcmp(argv[i], "--no-exit") == 0)
 		{
 			Settings::getInstance()->setBool("ShowExit", false);
@@ -314,7 +330,10 @@ bool parseArgs(int argc, char* argv[])
 				"--resolution [width] [height]	try and force a particular resolution\n"
 				"--gamelist-only			skip automatic game search, only read from gamelist.xml\n"
 				"--ignore-gamelist		ignore the gamelist (useful for troubleshooting)\n"
+				"--rebuild-gamelist-cache	parse every gamelist.xml and rewrite its binary cache\n"
+				"--verify-gamelist-cache		parse every gamelist.xml and check it against its binary cache\n"
 				"--draw-framerate		display the framerate\n"
+				"--profile-frames		record frame timings, show them in an overlay and dump them to frametrace.json on exit\n"
 				"--no-exit			don't show the exit option in the menu\n"
 				"--no-splash			don't show the splash screen\n"
 				"--debug				more logging, show console on Windows\n"
@@ -505,6 +524,9 @@ int main(int argc, char* argv[])
 			window.renderLoadingScreen(_("Loading..."));
 	}
 
+	if (Settings::getInstance()->getBool("FileSystemCacheWatch"))
+		Utils::FileSystem::enableFileCacheWatch();
+
 	const char* errorMsg = NULL;
 	if(!loadSystemConfigFile(&window, &errorMsg))
 	{
@@ -587,9 +609,13 @@ int main(int argc, char* argv[])
 
 	int lastTime = SDL_GetTicks();
 	int ps_time = SDL_GetTicks();
+	int memoryCheckTime = SDL_GetTicks();
 	int exitMode = 0;
 
 	bool running = true;
+	bool idle = false; // the last frame was not rendered, nothing changed on screen
+
+	FrameProfiler::setEnabled(Settings::getInstance()->getBool("FrameProfiler"));
 
 	while(running)
 	{
@@ -598,20 +624,34 @@ int main(int argc, char* argv[])
 		SDL_Event event;
 		bool ps_standby = PowerSaver::getState() && (int) SDL_GetTicks() - ps_time > PowerSaver::getMode();
 
-		if (ps_standby ? SDL_WaitEventTimeout(&event, PowerSaver::getTimeout()) : SDL_PollEvent(&event))
+		// Nothing to draw : waits for an event, or the next timer of the window (clock, screensaver...)
+		int timeout = ps_standby ? PowerSaver::getTimeout() : 0;
+		if (idle)
+			timeout = ps_standby ? std::min(timeout, window.getIdleTimeout()) : window.getIdleTimeout();
+
+		bool wait = ps_standby || idle;
+
+		if (wait ? SDL_WaitEventTimeout(&event, timeout) : SDL_PollEvent(&event))
 		{
+			bool input = false;
+
 			do
 			{
-				InputManager::getInstance()->parseEvent(event, &window);
+				if (InputManager::getInstance()->parseEvent(event, &window))
+					input = true;
 
 				if (event.type == SDL_QUIT)
 					running = false;
+				else if (event.type == SDL_APP_LOWMEMORY)
+					CollectionSystemManager::get()->releaseCollections();
 			} 
 			while(SDL_PollEvent(&event));
 
-			// triggered if exiting from SDL_WaitEvent due to event
-			if (ps_standby)
-				// show as if continuing from last event
+			window.invalidate();
+
+			// triggered if exiting from SDL_WaitEvent due to input : show as if continuing from last event.
+			// Other wake-ups (posted functions, notifications) keep the real delta, for the screensaver and clock timers
+			if (wait && input)
 				lastTime = SDL_GetTicks();
 
 			// reset counter
@@ -639,10 +679,34 @@ int main(int argc, char* argv[])
 		if (deltaTime < 0)
 			deltaTime = 1000;
 
+		// SDL_APP_LOWMEMORY is only sent on mobile platforms : checks what's left every 5 seconds
+		if (curTime - memoryCheckTime >= 5000)
+		{
+			memoryCheckTime = curTime;
+			CollectionSystemManager::get()->checkMemoryPressure();
+		}
+
+		FrameProfiler::beginFrame();
+
 		processAudioTitles(&window);
 
-		window.update(deltaTime);
-		window.render();
+		{
+			FrameProfiler::PhaseScope profile(FrameProfiler::UPDATE);
+			window.update(deltaTime);
+		}
+
+		// The screen stays as it is : no render, no swap
+		idle = !window.needsRender();
+		if (idle)
+		{
+			Log::flush();
+			continue;
+		}
+
+		{
+			FrameProfiler::PhaseScope profile(FrameProfiler::RENDER);
+			window.render();
+		}
 		
 		Log::flush();
 
@@ -659,7 +723,12 @@ int main(int argc, char* argv[])
 		int swapStart = SDL_GetTicks();
 #endif
 
-		Renderer::swapBuffers();				
+		{
+			FrameProfiler::PhaseScope profile(FrameProfiler::SWAP);
+			Renderer::swapBuffers();
+		}
+
+		FrameProfiler::endFrame();
 /*
 #ifdef WIN32	
 		int swapDuration = SDL_GetTicks() - swapStart;
@@ -673,6 +742,9 @@ int main(int argc, char* argv[])
 
 	ThreadedScraper::stop();
 
+	if (FrameProfiler::isEnabled())
+		FrameProfiler::dumpChromeTrace();
+
 	while(window.peekGui() != ViewController::get())
 		delete window.peekGui();
 
@@ -680,9 +752,12 @@ int main(int argc, char* argv[])
 		window.renderLoadingScreen(_("SAVING DATA. PLEASE WAIT..."));
 
 	ImageIO::saveImageCache();
+	ThumbnailCache::getInstance()->shutdown();
+	Font::shutdown();
 	MameNames::deinit();
 	CollectionSystemManager::deinit();
 	SystemData::deleteSystems();
+	Utils::FileSystem::disableFileCacheWatch();
 
 	// call this ONLY when linking with FreeImage as a static library
 #ifdef FREEIMAGE_LIB
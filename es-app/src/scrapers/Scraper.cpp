@@ -195,6 +195,9 @@ MDResolveHandle::MDResolveHandle(const ScraperSearchResult& result, const Scrape
 {
 	mPercent = -1;
 
+	if (search.system != nullptr && search.system->getSystemEnvData() != nullptr)
+		mMediaIndex = search.system->getSystemEnvData()->mMediaIndex;
+
 	std::string ext;
 
 	// If we have a file extension returned by the scraper, then use it.
@@ -376,7 +379,13 @@ void MDResolveHandle::update()
 	}
 	
 	if(mFuncs.empty())
+	{
+		// The folders may have changed within the second of their last listing
+		if (mMediaIndex != nullptr)
+			mMediaIndex->invalidate();
+
 		setStatus(ASYNC_DONE);
+	}
 }
 
 std::unique_ptr<ImageDownloadHandle> downloadImageAsync(const std::string& url, const std::string& saveAs)
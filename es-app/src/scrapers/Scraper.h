@@ -15,6 +15,7 @@
 #define MAX_SCRAPER_RESULTS 7
 
 class FileData;
+class MediaIndex;
 class SystemData;
 
 struct ScraperSearchParams
@@ -159,6 +160,7 @@ public:
 
 private:
 	ScraperSearchResult mResult;
+	std::shared_ptr<MediaIndex> mMediaIndex; // of the scraped system : the downloads add files to its folders
 
 	class ResolvePair
 	{	
@@ -7,6 +7,7 @@
 #include "guis/GuiMsgBox.h"
 #include "Gamelist.h"
 #include "Log.h"
+#include "CollectionSystemManager.h"
 
 #define GUIICON _U("\uF03E ")
 
@@ -186,6 +187,7 @@ void ThreadedScraper::acceptResult(const ScraperSearchResult& result)
 	{
 		LOG(LogDebug) << "ThreadedScraper::importScrappedMetadata";
 		game->getMetadata().importScrappedMetadata(result.mdl);
+		CollectionSystemManager::get()->refreshCollectionSystems(game);
 
 		LOG(LogDebug) << "ThreadedScraper::saveToGamelistRecovery";
 		saveToGamelistRecovery(game);
@@ -588,6 +588,23 @@ void SystemView::update(int deltaTime)
 	GuiComponent::update(deltaTime);
 }
 
+bool SystemView::isAnimating()
+{
+	if (IList<SystemViewData, SystemData*>::isAnimating())
+		return true;
+
+	if (mStaticVideoBackground != nullptr && mStaticVideoBackground->isAnimating())
+		return true;
+
+	// Extras are not children, and only the ones of the selected system are active
+	if (mCursor >= 0 && mCursor < (int)mEntries.size())
+		for (auto extra : mEntries.at(mCursor).data.backgroundExtras)
+			if (extra->isAnimating())
+				return true;
+
+	return false;
+}
+
 void SystemView::onCursorChanged(const CursorState& /*state*/)
 {
 	if (mLastSystem != getSelected()) {
@@ -66,6 +66,7 @@ public:
 	void showNavigationBar(const std::string& title, const std::function<std::string(SystemData* system)>& selector);
 	void update(int deltaTime) override;
 	void render(const Transform4x4f& parentTrans) override;
+	bool isAnimating() override;
 
 	void onThemeChanged(const std::shared_ptr<ThemeData>& theme);
 
@@ -12,12 +12,15 @@
 #include "views/gamelist/VideoGameListView.h"
 #include "views/SystemView.h"
 #include "views/UIModeController.h"
+#include "CollectionSystemManager.h"
 #include "FileFilterIndex.h"
 #include "Log.h"
 #include "Settings.h"
 #include "SystemData.h"
 #include "Window.h"
 #include "AudioManager.h"
+#include "resources/TextureData.h"
+#include "resources/ThumbnailCache.h"
 #include "utils/ThreadPool.h"
 #include <mutex>
 
@@ -174,6 +177,24 @@ void ViewController::goToGameList(SystemData* system, bool forceImmediate)
 		mCurrentView->onShow();
 
 	playViewTransition(forceImmediate);
+	prewarmThumbnails(system);
+}
+
+// Downscales the pictures of the system in the background, at the sizes they were last displayed with
+void ViewController::prewarmThumbnails(SystemData* system)
+{
+	if (!TextureData::OPTIMIZEVRAM || !ThumbnailCache::getInstance()->isEnabled())
+		return;
+
+	std::vector<std::string> paths;
+	for (auto game : system->getRootFolder()->getFilesRecursive(GAME))
+	{
+		for (auto path : { game->getImagePath(), game->getThumbnailPath(), game->getMarqueePath() })
+			if (!path.empty())
+				paths.push_back(path);
+	}
+
+	ThumbnailCache::getInstance()->prewarm(paths);
 }
 
 void ViewController::playViewTransition(bool forceImmediate)
@@ -261,6 +282,8 @@ void ViewController::launch(FileData* game, Vector3f center)
 	mWindow->stopInfoPopup(); // make sure we disable any existing info popup
 	mLockInput = true;
 
+	ThumbnailCache::getInstance()->cancelPrewarm();
+
 	mWindow->loadCustomImageLoadingScreen(game->getImagePath(), game->getName());
 
 	std::string transition_style = Settings::getInstance()->getString("GameTransitionStyle");
@@ -317,6 +340,9 @@ std::shared_ptr<IGameListView> ViewController::getGameListView(SystemData* syste
 	if (!loadIfnull)
 		return nullptr;
 
+	// auto collections only hold a few games until their gamelist is opened
+	CollectionSystemManager::get()->populateCollection(system);
+
 	system->setUIModeFilters();
 	system->updateDisplayedGameCount();
 
@@ -521,6 +547,17 @@ void ViewController::update(int deltaTime)
 	updateSelf(deltaTime);
 }
 
+bool ViewController::isAnimating()
+{
+	// Camera moves and fades
+	for (unsigned char i = 0; i < MAX_ANIMATIONS; i++)
+		if (isAnimationPlaying(i))
+			return true;
+
+	// The other views are children too, but only the current one is updated
+	return mCurrentView != nullptr && mCurrentView->isAnimating();
+}
+
 void ViewController::render(const Transform4x4f& parentTrans)
 {
 	Transform4x4f trans = mCamera * parentTrans;
@@ -589,6 +626,10 @@ void ViewController::preload()
 			mWindow->renderLoadingScreen(_("Preloading UI"), (float) i / (float)max);
 		}
 
+		// Creating their view would populate them, and push the previous ones out of the opened collections
+		if (CollectionSystemManager::get()->isUnpopulatedAutoCollection(*it))
+			continue;
+
 		(*it)->resetFilters();
 		getGameListView(*it);
 	}
@@ -700,19 +741,24 @@ void ViewController::reloadAll(Window* window)
 	if (window)
 		window->renderLoadingScreen(_("Loading theme..."));	
 
-	Utils::ThreadPool pool;
+	Utils::TaskGroup themeLoading;
 	
 	for (auto it = cursorMap.cbegin(); it != cursorMap.cend(); it++)
 	{
 		auto system = it->first;
-		pool.queueWorkItem([system]
+
+		// Media may have been added since the folders were listed
+		if (system->getSystemEnvData() != nullptr && system->getSystemEnvData()->mMediaIndex != nullptr)
+			system->getSystemEnvData()->mMediaIndex->invalidate();
+
+		themeLoading.run([system]
 		{
 			system->loadTheme();
 			system->resetFilters();	
 		});		
 	}
 
-	pool.wait();
+	themeLoading.wait();
 
 	// load themes, create gamelistviews and reset filters
 	for(auto it = cursorMap.cbegin(); it != cursorMap.cend(); it++)
@@ -50,6 +50,7 @@ public:
 	bool input(InputConfig* config, Input input) override;
 	void update(int deltaTime) override;
 	void render(const Transform4x4f& parentTrans) override;
+	bool isAnimating() override;
 
 	enum ViewMode
 	{
@@ -81,6 +82,7 @@ public:
 	};
 
 	inline const State& getState() const { return mState; }
+	inline const std::shared_ptr<GuiComponent>& getCurrentView() const { return mCurrentView; }
 
 	virtual std::vector<HelpPrompt> getHelpPrompts() override;
 	virtual HelpStyle getHelpStyle() override;
@@ -100,6 +102,7 @@ private:
 	static ViewController* sInstance;
 
 	void playViewTransition(bool forceImmediate);
+	void prewarmThumbnails(SystemData* system);
 	int getSystemId(SystemData* system);
 
 	std::shared_ptr<GuiComponent> mCurrentView;
@@ -23,7 +23,7 @@ DetailedGameListView::DetailedGameListView(Window* window, FolderData* root) :
 
 	mRating(window), mReleaseDate(window), mDeveloper(window), mPublisher(window), 
 	mGenre(window), mPlayers(window), mLastPlayed(window), mPlayCount(window),
-	mName(window)
+	mName(window), mLastCursor(-1)
 {
 	const float padding = 0.01f;
 
@@ -338,6 +338,43 @@ std::string DetailedGameListView::getMetadata(FileData* file, std::string name)
 
 #include "platform.h"
 
+// Queues the pictures of the next games in the scrolling direction, and of the previous one with a lower priority
+void DetailedGameListView::prefetchImages()
+{
+	int cursor = mList.getCursorIndex();
+	int direction = (cursor >= mLastCursor) ? 1 : -1;
+	mLastCursor = cursor;
+
+	// Kept until the next call : the previous prefetches still needed are found again by TextureResource::get, the others are dropped
+	std::vector<std::shared_ptr<TextureResource>> textures;
+
+	auto prefetch = [this, &textures](int index, TextureLoadPriority priority)
+	{
+		if (index < 0 || index >= mList.size())
+			return;
+
+		FileData* file = mList.getObjectAt(index);
+		if (file->getType() != GAME)
+			return;
+
+		std::string imagePath = file->getImagePath().empty() ? file->getThumbnailPath() : file->getImagePath();
+
+		std::shared_ptr<TextureResource> texture;
+		if (mImage != nullptr && (texture = mImage->prefetch(imagePath, priority)) != nullptr)
+			textures.push_back(texture);
+
+		if (mMarquee != nullptr && (texture = mMarquee->prefetch(file->getMarqueePath(), priority, mMarquee->getMaxSizeInfo())) != nullptr)
+			textures.push_back(texture);
+	};
+
+	// Latest queued is loaded first
+	prefetch(cursor + 2 * direction, TEXTURE_LOAD_PREFETCH);
+	prefetch(cursor + direction, TEXTURE_LOAD_PREFETCH);
+	prefetch(cursor - direction, TEXTURE_LOAD_SPECULATIVE);
+
+	mPrefetchedTextures = textures;
+}
+
 void DetailedGameListView::updateInfoPanel()
 {
 	FileData* file = (mList.size() == 0 || mList.isScrolling()) ? NULL : mList.getSelected();
@@ -381,6 +418,8 @@ void DetailedGameListView::updateInfoPanel()
 		if (mMarquee != nullptr)
 			mMarquee->setImage(file->getMarqueePath(), false, mMarquee->getMaxSizeInfo());
 
+		prefetchImages();
+
 		mDescription.setText(getMetadata(file, "desc"));
 		mDescContainer.reset();
 
@@ -31,6 +31,7 @@ public:
 
 private:
 	void updateInfoPanel();
+	void prefetchImages();
 	
 	void createVideo();
 	void createMarquee();
@@ -64,6 +65,9 @@ private:
 	ScrollableContainer mDescContainer;
 	TextComponent mDescription;
 
+	int mLastCursor;
+	std::vector<std::shared_ptr<TextureResource>> mPrefetchedTextures;
+
 
 };
 
@@ -0,0 +1,295 @@
+#include <string>
+#include "FrameProfiler.h"
+
+#include "renderers/Renderer.h"
+#include "utils/FileSystemUtil.h"
+#include "GuiComponent.h"
+#include "Log.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <typeindex>
+#include <unordered_map>
+
+#if defined(__GNUC__)
+#include <cxxabi.h>
+#include <stdlib.h>
+#endif
+
+bool FrameProfiler::sEnabled = false;
+bool FrameProfiler::sInFrame = false;
+
+struct OpenScope
+{
+	int64_t start;
+	int64_t nested; // time spent in the scopes opened inside this one
+};
+
+static std::vector<FrameProfiler::Frame> sFrames;
+static int sFrameIndex = 0; // slot of the frame being recorded
+static int sFrameCount = 0;
+static std::chrono::steady_clock::time_point sEpoch;
+static std::vector<OpenScope> sOpenScopes;
+
+static const std::string sPhaseNames[FrameProfiler::PHASE_COUNT] = { "update", "render", "swapBuffers", "texture upload", "posted functions" };
+static std::unordered_map<std::type_index, std::string> sComponentNames;
+
+static inline int64_t now()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - sEpoch).count();
+}
+
+static const std::string* getComponentName(const GuiComponent* component)
+{
+	std::type_index type(typeid(*component));
+
+	auto it = sComponentNames.find(type);
+	if (it != sComponentNames.cend())
+		return &it->second;
+
+	std::string name = type.name();
+
+#if defined(__GNUC__)
+	int status = 0;
+	char* demangled = abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status);
+	if (demangled != nullptr)
+	{
+		if (status == 0)
+			name = demangled;
+
+		free(demangled);
+	}
+#endif
+
+	return &(sComponentNames[type] = name);
+}
+
+void FrameProfiler::setEnabled(bool enabled)
+{
+	if (enabled == sEnabled)
+		return;
+
+	if (enabled)
+	{
+		sFrames.assign(FRAME_HISTORY, Frame());
+		sFrameIndex = 0;
+		sFrameCount = 0;
+		sEpoch = std::chrono::steady_clock::now();
+	}
+
+	// The recorded frames are kept when disabling, so they can still be dumped
+	sOpenScopes.clear();
+	sInFrame = false;
+	sEnabled = enabled;
+}
+
+void FrameProfiler::beginFrame()
+{
+	if (!sEnabled)
+		return;
+
+	Frame& frame = sFrames[sFrameIndex];
+	frame.start = now();
+	frame.duration = 0;
+	frame.textureUploads = 0;
+	frame.drawCalls = 0;
+	frame.stateChanges = 0;
+	frame.spans.clear();
+
+	for (int i = 0; i < PHASE_COUNT; i++)
+		frame.phases[i] = 0;
+
+	sOpenScopes.clear();
+	sInFrame = true;
+}
+
+void FrameProfiler::endFrame()
+{
+	if (!sEnabled || !sInFrame)
+		return;
+
+	Frame& frame = sFrames[sFrameIndex];
+	frame.duration = (int)(now() - frame.start);
+
+	// Counted up to swapBuffers()
+	const Renderer::Statistics& statistics = Renderer::getLastFrameStatistics();
+	frame.drawCalls = statistics.drawCalls;
+	frame.stateChanges = statistics.stateChanges;
+
+	sInFrame = false;
+	sFrameIndex = (sFrameIndex + 1) % FRAME_HISTORY;
+	if (sFrameCount < FRAME_HISTORY)
+		sFrameCount++;
+}
+
+int FrameProfiler::getFrameCount()
+{
+	return sFrameCount;
+}
+
+const FrameProfiler::Frame& FrameProfiler::getFrame(int index)
+{
+	int first = (sFrameIndex - sFrameCount + FRAME_HISTORY) % FRAME_HISTORY;
+	return sFrames[(first + index) % FRAME_HISTORY];
+}
+
+void FrameProfiler::enter()
+{
+	OpenScope scope;
+	scope.start = now();
+	scope.nested = 0;
+	sOpenScopes.push_back(scope);
+}
+
+void FrameProfiler::leave(const std::string* name, bool component, int& duration)
+{
+	duration = 0;
+	if (sOpenScopes.empty() || sFrames.empty())
+		return;
+
+	OpenScope scope = sOpenScopes.back();
+	sOpenScopes.pop_back();
+
+	duration = (int)(now() - scope.start);
+	if (!sOpenScopes.empty())
+		sOpenScopes.back().nested += duration;
+
+	Frame& frame = sFrames[sFrameIndex];
+	if (frame.spans.size() >= MAX_SPANS_PER_FRAME)
+		return;
+
+	Span span;
+	span.name = name;
+	span.start = scope.start;
+	span.duration = duration;
+	span.self = (int)(duration - scope.nested);
+	span.depth = (int)sOpenScopes.size();
+	span.component = component;
+	frame.spans.push_back(span);
+}
+
+void FrameProfiler::leavePhase(Phase phase)
+{
+	int duration;
+	leave(&sPhaseNames[phase], false, duration);
+
+	if (sFrames.empty())
+		return;
+
+	Frame& frame = sFrames[sFrameIndex];
+	frame.phases[phase] += duration;
+
+	if (phase == TEXTURE_UPLOAD)
+		frame.textureUploads++;
+}
+
+void FrameProfiler::leaveComponent(const GuiComponent* component)
+{
+	int duration;
+	leave(getComponentName(component), true, duration);
+}
+
+std::vector<FrameProfiler::Offender> FrameProfiler::getWorstOffenders(int count)
+{
+	struct Cost
+	{
+		Cost() : total(0), max(0) { }
+
+		int64_t total;
+		int		max;
+	};
+
+	std::unordered_map<const std::string*, Cost> costs;
+
+	for (int i = 0; i < sFrameCount; i++)
+	{
+		// Self time is summed per frame first, so the max is the worst frame and not the worst single call
+		std::unordered_map<const std::string*, int> frameCosts;
+		for (auto& span : getFrame(i).spans)
+			if (span.component)
+				frameCosts[span.name] += span.self;
+
+		for (auto& item : frameCosts)
+		{
+			Cost& cost = costs[item.first];
+			cost.total += item.second;
+			cost.max = std::max(cost.max, item.second);
+		}
+	}
+
+	std::vector<std::pair<const std::string*, Cost>> sorted(costs.cbegin(), costs.cend());
+	std::sort(sorted.begin(), sorted.end(), [](const std::pair<const std::string*, Cost>& a, const std::pair<const std::string*, Cost>& b) { return a.second.total > b.second.total; });
+
+	std::vector<Offender> ret;
+	for (int i = 0; i < count && i < (int)sorted.size(); i++)
+	{
+		Offender offender;
+		offender.name = *sorted[i].first;
+		offender.averageSelf = (int)(sorted[i].second.total / std::max(1, sFrameCount));
+		offender.maxSelf = sorted[i].second.max;
+		ret.push_back(offender);
+	}
+
+	return ret;
+}
+
+static std::string escapeJson(const std::string& value)
+{
+	std::string ret;
+	ret.reserve(value.size());
+
+	for (auto c : value)
+	{
+		if (c == '"' || c == '\\')
+			ret += '\\';
+
+		ret += c;
+	}
+
+	return ret;
+}
+
+bool FrameProfiler::dumpChromeTrace(const std::string& tracePath)
+{
+	std::string path = tracePath.empty() ? Utils::FileSystem::getHomePath() + "/.emulationstation/frametrace.json" : tracePath;
+
+	FILE* file = fopen(path.c_str(), "wb");
+	if (file == nullptr)
+	{
+		LOG(LogError) << "Unable to write frame trace \"" << path << "\"";
+		return false;
+	}
+
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+	bool first = true;
+	for (int i = 0; i < sFrameCount; i++)
+	{
+		const Frame& frame = getFrame(i);
+
+		fprintf(file, "%s{\"name\":\"frame\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%lld,\"dur\":%d,\"args\":{\"textureUploads\":%d,\"drawCalls\":%d,\"stateChanges\":%d}}",
+			first ? "" : ",\n", (long long)frame.start, frame.duration, frame.textureUploads, frame.drawCalls, frame.stateChanges);
+
+		first = false;
+
+		for (auto& span : frame.spans)
+			fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%lld,\"dur\":%d,\"args\":{\"self\":%d}}",
+				escapeJson(*span.name).c_str(), span.component ? "component" : "phase", (long long)span.start, span.duration, span.self);
+	}
+
+	fprintf(file, "\n]}\n");
+
+	bool written = (ferror(file) == 0);
+	fclose(file);
+
+	if (written)
+	{
+		LOG(LogInfo) << "Frame trace written to \"" << path << "\" (" << sFrameCount << " frames)";
+	}
+	else
+	{
+		LOG(LogError) << "Unable to write frame trace \"" << path << "\"";
+	}
+
+	return written;
+}
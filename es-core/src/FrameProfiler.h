@@ -0,0 +1,97 @@
+#include <string>
+#pragma once
+#ifndef ES_CORE_FRAME_PROFILER_H
+#define ES_CORE_FRAME_PROFILER_H
+
+#include <stdint.h>
+#include <vector>
+
+class GuiComponent;
+
+// Records where the main loop spends its time for the last FRAME_HISTORY frames : update, render, swapBuffers,
+// texture uploads, posted functions, the render cost of every GuiComponent subtree, and the renderer draw calls.
+// Enabled by the "FrameProfiler" setting. Must only be used from the main (GL) thread.
+class FrameProfiler
+{
+public:
+	enum Phase { UPDATE, RENDER, SWAP, TEXTURE_UPLOAD, POSTED_FUNCTIONS, PHASE_COUNT };
+	enum { FRAME_HISTORY = 240, MAX_SPANS_PER_FRAME = 1024 };
+
+	struct Span
+	{
+		const std::string* name; // interned for the application lifetime
+		int64_t	start;		// us since the profiler was enabled
+		int		duration;	// us
+		int		self;		// us, duration minus the spans nested inside
+		int		depth;
+		bool	component;
+	};
+
+	struct Frame
+	{
+		int64_t	start;
+		int		duration;
+		int		phases[PHASE_COUNT]; // us
+		int		textureUploads;
+		int		drawCalls;		// GL draw calls, after batching
+		int		stateChanges;	// texture binds, blending and matrix changes
+
+		std::vector<Span> spans;
+	};
+
+	struct Offender
+	{
+		std::string name;
+		int averageSelf; // us per frame
+		int maxSelf;
+	};
+
+	static inline bool isEnabled() { return sEnabled; }
+	static void setEnabled(bool enabled);
+
+	static void beginFrame();
+	static void endFrame();
+
+	// Recorded frames, oldest first
+	static int getFrameCount();
+	static const Frame& getFrame(int index);
+
+	// Component types with the highest self render time over the recorded frames
+	static std::vector<Offender> getWorstOffenders(int count);
+
+	// Chrome trace event format (chrome://tracing, ui.perfetto.dev). Empty path -> ~/.emulationstation/frametrace.json
+	static bool dumpChromeTrace(const std::string& path = "");
+
+	class PhaseScope
+	{
+	public:
+		PhaseScope(Phase phase) : mActive(sEnabled && sInFrame), mPhase(phase) { if (mActive) enter(); }
+		~PhaseScope() { if (mActive) leavePhase(mPhase); }
+
+	private:
+		bool	mActive;
+		Phase	mPhase;
+	};
+
+	class ComponentScope
+	{
+	public:
+		ComponentScope(const GuiComponent* component) : mActive(sEnabled && sInFrame), mComponent(component) { if (mActive) enter(); }
+		~ComponentScope() { if (mActive) leaveComponent(mComponent); }
+
+	private:
+		bool				mActive;
+		const GuiComponent*	mComponent;
+	};
+
+private:
+	static void enter();
+	static void leavePhase(Phase phase);
+	static void leaveComponent(const GuiComponent* component);
+	static void leave(const std::string* name, bool component, int& duration);
+
+	static bool sEnabled;
+	static bool sInFrame;
+};
+
+#endif // ES_CORE_FRAME_PROFILER_H
@@ -4,6 +4,7 @@
 #include "animations/Animation.h"
 #include "animations/AnimationController.h"
 #include "animations/LambdaAnimation.h"
+#include "FrameProfiler.h"
 #include "Log.h"
 #include "renderers/Renderer.h"
 #include "ThemeData.h"
@@ -78,6 +79,7 @@ void GuiComponent::renderChildren(const Transform4x4f& transform) const
 {
 	for(unsigned int i = 0; i < getChildCount(); i++)
 	{
+		FrameProfiler::ComponentScope profile(getChild(i));
 		getChild(i)->render(transform);
 	}
 }
@@ -499,6 +501,19 @@ bool GuiComponent::isProcessing() const
 	return mIsProcessing;
 }
 
+bool GuiComponent::isAnimating()
+{
+	for (unsigned char i = 0; i < MAX_ANIMATIONS; i++)
+		if (mAnimationMap[i] != NULL)
+			return true;
+
+	for (auto child : mChildren)
+		if (child->isVisible() && child->isAnimating())
+			return true;
+
+	return false;
+}
+
 void GuiComponent::onShow()
 {
 	for(unsigned int i = 0; i < getChildCount(); i++)
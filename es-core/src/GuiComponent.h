@@ -162,6 +162,11 @@ public:
 	// Returns true if the component is busy doing background processing (e.g. HTTP downloads)
 	bool isProcessing() const;
 
+	// Returns true if the component changes from one frame to the next without any input (animations, videos, scrolling...).
+	// The Window doesn't render the frames while nothing on screen is animating.
+	// Default implementation checks the animation slots and the visible children.
+	virtual bool isAnimating();
+
 	void animateTo(Vector2f from, Vector2f to, unsigned int flags = 0xFFFFFFFF, int delay = 350);
 	void animateTo(Vector2f from, unsigned int flags = AnimateFlags::OPACITY | AnimateFlags::SCALE, int delay = 350) { animateTo(from, from, flags, delay); }
 
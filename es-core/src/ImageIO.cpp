@@ -9,6 +9,7 @@
 #include <iostream>
 #include "math/Vector2i.h"
 #include "utils/FileSystemUtil.h"
+#include "utils/PixelUtil.h"
 #include "utils/StringUtil.h"
 #include "resources/ResourceManager.h"
 
@@ -301,35 +302,15 @@ std::vector<unsigned char> ImageIO::loadFromMemoryRGBA32(const unsigned char * d
 					width = FreeImage_GetWidth(fiBitmap);
 					height = FreeImage_GetHeight(fiBitmap);
 
-					//loop through scanlines and add all pixel data to the return vector
+					//loop through scanlines and convert them from BGRA to RGBA, straight into the return vector
 					//this is necessary, because width*height*bpp might not be == pitch
+					rawData.resize(width * height * 4);
 
-					unsigned char * tempData = new unsigned char[width * height * 4];
-					unsigned char * bytes = FreeImage_GetBits(fiBitmap);
+					for (size_t y = 0; y < height; y++)
+						Utils::Pixel::swapRedBlue(FreeImage_GetScanLine(fiBitmap, (int)y), rawData.data() + y * width * 4, width);
 
-				//	memcpy(tempData, bytes, width * height * 4);
-/*
-					for (size_t i = 0; i < height; i++)
-					{
-						const BYTE * scanLine = FreeImage_GetScanLine(fiBitmap, (int)i);
-						memcpy(tempData + (i * width * 4), scanLine, width * 4);
-					}*/
-					//convert from BGRA to RGBA
-					for(size_t i = 0; i < width*height; i++)
-					{
-						RGBQUAD bgra = ((RGBQUAD *)bytes)[i];
-						RGBQUAD rgba;
-						rgba.rgbBlue = bgra.rgbRed;
-						rgba.rgbGreen = bgra.rgbGreen;
-						rgba.rgbRed = bgra.rgbBlue;
-						rgba.rgbReserved = bgra.rgbReserved;
-						((RGBQUAD *)tempData)[i] = rgba;
-					}
-					
-					rawData = std::vector<unsigned char>(tempData, tempData + width * height * 4);
 					//free bitmap data
 					FreeImage_Unload(fiBitmap);
-					delete[] tempData;
 				}
 			}
 			else
@@ -439,12 +420,27 @@ unsigned char* ImageIO::loadFromMemoryRGBA32Ex(const unsigned char * data, const
 					height = FreeImage_GetHeight(fiBitmap);
 
 					baseSize = Vector2i(width, height);
+
+					unsigned char* tempData = nullptr;
 					
 					if (maxWidth > 0 && maxHeight > 0 && (width > maxWidth || height > maxHeight))
 					{
 						Vector2i sz = adjustPictureSize(Vector2i(width, height), Vector2i(maxWidth, maxHeight), externZoom);
-						if (sz.x() != width || sz.y() != height)
-						{							
+						if (sz.x() > 0 && sz.y() > 0 && sz.x() <= width && sz.y() <= height && (sz.x() != width || sz.y() != height))
+						{
+							// Box filtered straight from the bitmap into the returned buffer, then swizzled in place
+							tempData = new unsigned char[sz.x() * sz.y() * 4];
+							Utils::Pixel::boxDownscale(FreeImage_GetBits(fiBitmap), width, height, FreeImage_GetPitch(fiBitmap), tempData, sz.x(), sz.y());
+							Utils::Pixel::swapRedBlue(tempData, tempData, sz.x() * sz.y());
+
+							width = sz.x();
+							height = sz.y();
+
+							packedSize = Vector2i(width, height);
+						}
+						else if (sz.x() != width || sz.y() != height)
+						{
+							// "extern zoom" sizes can be larger than the picture in one direction
 							FIBITMAP* imageRescaled = FreeImage_Rescale(fiBitmap, sz.x(), sz.y(), FILTER_BOX);
 							FreeImage_Unload(fiBitmap);
 							fiBitmap = imageRescaled;
@@ -458,20 +454,12 @@ unsigned char* ImageIO::loadFromMemoryRGBA32Ex(const unsigned char * data, const
 					
 					//loop through scanlines and add all pixel data to the return vector
 					//this is necessary, because width*height*bpp might not be == pitch
-
-					unsigned char* tempData = new unsigned char[width * height * 4];
-
-					int w = (int)width;
-
-					for (int y = (int)height; --y >= 0; )
+					if (tempData == nullptr)
 					{
-						unsigned int* argb = (unsigned int*)FreeImage_GetScanLine(fiBitmap, y);
-						unsigned int* abgr = (unsigned int*)(tempData + (y * width * 4));
-						for (int x = w; --x >= 0;)
-						{
-							unsigned int c = argb[x];
-							abgr[x] = (c & 0xFF00FF00) | ((c & 0xFF) << 16) | ((c >> 16) & 0xFF);
-						}
+						tempData = new unsigned char[width * height * 4];
+
+						for (size_t y = 0; y < height; y++)
+							Utils::Pixel::swapRedBlue(FreeImage_GetScanLine(fiBitmap, (int)y), tempData + y * width * 4, width);
 					}
 				
 					FreeImage_Unload(fiBitmap);
@@ -498,15 +486,5 @@ unsigned char* ImageIO::loadFromMemoryRGBA32Ex(const unsigned char * data, const
 
 void ImageIO::flipPixelsVert(unsigned char* imagePx, const size_t& width, const size_t& height)
 {
-	unsigned int temp;
-	unsigned int* arr = (unsigned int*)imagePx;
-	for(size_t y = 0; y < height / 2; y++)
-	{
-		for(size_t x = 0; x < width; x++)
-		{
-			temp = arr[x + (y * width)];
-			arr[x + (y * width)] = arr[x + (height * width) - ((y + 1) * width)];
-			arr[x + (height * width) - ((y + 1) * width)] = temp;
-		}
-	}
+	Utils::Pixel::flipVertical(imagePx, width, height);
 }
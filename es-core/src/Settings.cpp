@@ -23,6 +23,8 @@ std::vector<const char*> settings_dont_save {
 	{ "ForceKid" },
 	{ "ForceKiosk" },
 	{ "IgnoreGamelist" },
+	{ "GamelistCacheRebuild" },
+	{ "GamelistCacheVerify" },
 	{ "HideConsole" },
 	{ "ShowExit" },
 	{ "SplashScreen" },
@@ -73,6 +75,7 @@ void Settings::setDefaults()
 	mBoolMap["ShowHiddenFiles"] = false;
     mBoolMap["IgnoreLeadingArticles"] = false;
 	mBoolMap["DrawFramerate"] = false;
+	mBoolMap["FrameProfiler"] = false;
 	mBoolMap["ShowExit"] = true;		
 
 #if WIN32
@@ -99,6 +102,9 @@ void Settings::setDefaults()
 	mBoolMap["ShowHelpPrompts"] = true;
 	mBoolMap["ScrapeRatings"] = true;
 	mBoolMap["IgnoreGamelist"] = false;
+	mBoolMap["GamelistCache"] = true;
+	mBoolMap["GamelistCacheRebuild"] = false;
+	mBoolMap["GamelistCacheVerify"] = false;
 	mBoolMap["HideConsole"] = true;
 	mBoolMap["QuickSystemSelect"] = true;
 	mBoolMap["MoveCarousel"] = true;
@@ -113,7 +119,14 @@ void Settings::setDefaults()
 	mStringMap["GameLoadingIMode"] = "pic";
 	mStringMap["ImagedelayTime"] = "1.5";
 	mBoolMap["OptimizeVRAM"] = true;	
+	mBoolMap["TextureAtlas"] = true; // pack the small static textures into shared pages
+	mBoolMap["SkipIdleFrames"] = true; // don't render the frames where nothing changed
+	mBoolMap["GlyphCache"] = true; // keep the rasterized glyphs in ~/.emulationstation/glyphs
+	mStringMap["FontPrerenderRanges"] = "auto"; // hexadecimal codepoint ranges rasterized in the background ("0400-04FF,AC00-D7A3"), "auto" or empty
+	mIntMap["ThumbnailCacheSize"] = 128; // MB of downscaled pictures kept in ~/.emulationstation/thumbnails, 0 = disabled
 	mBoolMap["ThreadedLoading"] = true;	
+	mBoolMap["FileSystemCacheWatch"] = false; // keep the stat cache for the whole run, invalidated by inotify (Linux)
+	mIntMap["LoaderThreads"] = 0; // 0 = one per hardware thread
 	mBoolMap["MusicTitles"] = true;
 
 	mBoolMap["Debug"] = false;
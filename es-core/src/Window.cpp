@@ -5,6 +5,8 @@
 #include "components/ImageComponent.h"
 #include "components/TextComponent.h"
 #include "resources/Font.h"
+#include "resources/TextureAtlas.h"
+#include "resources/TextureData.h"
 #include "resources/TextureResource.h"
 #include "InputManager.h"
 #include "Log.h"
@@ -16,15 +18,20 @@
 #include "components/AsyncNotificationComponent.h"
 #include "guis/GuiMsgBox.h"
 #include "AudioManager.h"
+#include "FrameProfiler.h"
 
-Window::Window() : mNormalizeNextUpdate(false), mFrameTimeElapsed(0), mFrameCountElapsed(0), mAverageDeltaTime(10),
-  mAllowSleep(true), mSleeping(false), mTimeSinceLastInput(0), mScreenSaver(NULL), mRenderScreenSaver(false), mInfoPopup(NULL), mClockElapsed(0),
-  mIgnoreKeys(false)// batocera
+#define IDLE_REFRESH_DELAY	1000	// ms between two frames when nothing reports a change, for the components that don't
+#define TEXTURE_POLL_DELAY	15		// ms the idle loop waits while textures are loading in the background
+
+Window::Window() : mScreenSaver(NULL), mInfoPopup(NULL), mRenderScreenSaver(false), mFrameTimeElapsed(0), mFrameCountElapsed(0), mAverageDeltaTime(10),
+  mClockElapsed(0), mNormalizeNextUpdate(false), mAllowSleep(true), mSleeping(false), mTimeSinceLastInput(0),
+  mInvalidated(true), mLastRenderTime(0), mLastTextureLoadCount(0), mIgnoreKeys(false) // batocera
 {	
 	mHelp = new HelpComponent(this);
 	mBackgroundOverlay = new ImageComponent(this);	
 
 	mSplash = NULL;	
+	mMainThreadId = std::this_thread::get_id();
 }
 
 Window::~Window()
@@ -50,10 +57,13 @@ void Window::pushGui(GuiComponent* gui)
 	}
 	mGuiStack.push_back(gui);
 	gui->updateHelpPrompts();
+	invalidate();
 }
 
 void Window::removeGui(GuiComponent* gui)
 {
+	invalidate();
+
 	for(auto i = mGuiStack.cbegin(); i != mGuiStack.cend(); i++)
 	{
 		if(*i == gui)
@@ -79,6 +89,24 @@ GuiComponent* Window::peekGui()
 	return mGuiStack.back();
 }
 
+// SDL user event pushed by invalidate() from the other threads, (Uint32)-1 until SDL is initialized
+static std::atomic<Uint32> sWakeEventType((Uint32)-1);
+
+void Window::invalidate()
+{
+	if (mInvalidated.exchange(true) || std::this_thread::get_id() == mMainThreadId)
+		return;
+
+	Uint32 wakeEventType = sWakeEventType;
+	if (wakeEventType == (Uint32)-1)
+		return;
+
+	SDL_Event event;
+	event.type      = wakeEventType;
+	event.user.code = 0;
+	SDL_PushEvent(&event);
+}
+
 bool Window::init(bool initRenderer)
 {
 	LOG(LogInfo) << "Window::init";
@@ -92,6 +120,11 @@ bool Window::init(bool initRenderer)
 		}
 
 		InputManager::getInstance()->init();
+
+		if (sWakeEventType == (Uint32)-1)
+			sWakeEventType = SDL_RegisterEvents(1);
+
+		Renderer::setStatusChangedCallback([this] { invalidate(); });
 	}
 	else
 		Renderer::activateWindow();
@@ -156,17 +189,24 @@ void Window::deinit(bool deinitRenderer)
 	ResourceManager::getInstance()->unloadAll();
 
 	if (deinitRenderer)
+	{
+		Renderer::setStatusChangedCallback(nullptr);
 		Renderer::deinit();
+	}
 }
 
 void Window::textInput(const char* text)
 {
+	invalidate();
+
 	if(peekGui())
 		peekGui()->textInput(text);
 }
 
 void Window::input(InputConfig* config, Input input)
 {
+	invalidate();
+
 	if (config->isMappedTo("system_hk", input))
 	{
 		if (input.value != 0)
@@ -246,6 +286,7 @@ void Window::update(int deltaTime)
 {	
 	processPostedFunctions();
 	processNotificationMessages();
+	Font::update();
 
 	if(mNormalizeNextUpdate)
 	{
@@ -275,9 +316,20 @@ void Window::update(int deltaTime)
 
 			ss << "\nFont VRAM: " << fontVramUsageMb << " Tex VRAM: " << textureVramUsageMb <<
 				  " Tex Max: " << textureTotalUsageMb;
+
+			// texture budget
+			ss << "\nTex uploaded: " << TextureData::getTotalVRAMUsage() / 1000.0f / 1000.0f <<
+				  " decoded: " << TextureData::getTotalRAMUsage() / 1000.0f / 1000.0f <<
+				  " queued: " << TextureResource::getLoadQueueSize() / 1000.0f / 1000.0f <<
+				  " budget: " << Settings::getInstance()->getInt("MaxVRAM") <<
+				  " evicted: " << TextureResource::getEvictionCount() <<
+				  " atlas: " << TextureAtlas::getInstance()->getRegionCount() << "/" << TextureAtlas::getInstance()->getPageCount();
 			mFrameDataText = std::unique_ptr<TextCache>(mDefaultFonts.at(1)->buildTextCache(ss.str(), 50.f, 50.f, 0xFF00FFFF));
 		}
 
+		if (FrameProfiler::isEnabled())
+			updateProfilerText();
+
 		mFrameTimeElapsed = 0;
 		mFrameCountElapsed = 0;
 	}
@@ -319,7 +371,11 @@ void Window::update(int deltaTime)
 				setlocale(LC_TIME, oldLocale.c_str());
 #endif
 
-				mClock->setText(clockBuf);
+				if (mClock->getText() != clockBuf)
+				{
+					mClock->setText(clockBuf);
+					invalidate();
+				}
 			}
 
 			mClockElapsed = 1000; // next update in 1000ms
@@ -342,6 +398,8 @@ void Window::render()
 {
 	Transform4x4f transform = Transform4x4f::Identity();
 
+	mLastRenderTime = SDL_GetTicks();
+
 	mRenderedHelpPrompts = false;
 
 	// draw only bottom and top of GuiStack (if they are different)
@@ -350,17 +408,26 @@ void Window::render()
 		auto& bottom = mGuiStack.front();
 		auto& top = mGuiStack.back();
 
-		bottom->render(transform);
+		{
+			FrameProfiler::ComponentScope profile(bottom);
+			bottom->render(transform);
+		}
+
 		if(bottom != top)
 		{
 			if (top->isKindOf<GuiMsgBox>() && mGuiStack.size() > 2)
 			{
 				auto& middle = mGuiStack.at(mGuiStack.size() - 2);
 				if (middle != bottom)
+				{
+					FrameProfiler::ComponentScope profile(middle);
 					middle->render(transform);
+				}
 			}
 
 			mBackgroundOverlay->render(transform);
+
+			FrameProfiler::ComponentScope profile(top);
 			top->render(transform);
 		}
 	}
@@ -410,6 +477,9 @@ void Window::render()
 	for (auto extra : mScreenExtras)
 		extra->render(transform);
 
+	if (FrameProfiler::isEnabled())
+		renderProfiler();
+
 	if(mTimeSinceLastInput >= screensaverTime && screensaverTime != 0)
 	{
 		if (!isProcessing() && mAllowSleep && (!mScreenSaver || mScreenSaver->allowSleep()))
@@ -423,6 +493,98 @@ void Window::render()
 	}
 }
 
+void Window::updateProfilerText()
+{
+	int count = FrameProfiler::getFrameCount();
+	if (count == 0)
+		return;
+
+	int64_t total = 0;
+	int worst = 0;
+	int64_t phases[FrameProfiler::PHASE_COUNT] = { 0 };
+	int uploads = 0;
+	int64_t drawCalls = 0;
+	int64_t stateChanges = 0;
+
+	for (int i = 0; i < count; i++)
+	{
+		const FrameProfiler::Frame& frame = FrameProfiler::getFrame(i);
+
+		total += frame.duration;
+		worst = std::max(worst, frame.duration);
+		uploads += frame.textureUploads;
+		drawCalls += frame.drawCalls;
+		stateChanges += frame.stateChanges;
+
+		for (int p = 0; p < FrameProfiler::PHASE_COUNT; p++)
+			phases[p] += frame.phases[p];
+	}
+
+	std::stringstream ss;
+	ss << std::fixed << std::setprecision(2);
+	ss << "frame " << (total / count) / 1000.0f << "ms (max " << worst / 1000.0f << "ms)";
+	ss << "  update " << (phases[FrameProfiler::UPDATE] / count) / 1000.0f;
+	ss << "  render " << (phases[FrameProfiler::RENDER] / count) / 1000.0f;
+	ss << "  swap " << (phases[FrameProfiler::SWAP] / count) / 1000.0f;
+	ss << "\ntextures " << (phases[FrameProfiler::TEXTURE_UPLOAD] / count) / 1000.0f << "ms (" << uploads << " uploads)";
+	ss << "  posted " << (phases[FrameProfiler::POSTED_FUNCTIONS] / count) / 1000.0f << "ms";
+	ss << "\ndraw calls " << drawCalls / count << "  state changes " << stateChanges / count;
+
+	unsigned int layoutHits, layoutMisses;
+	Font::getTextLayoutCacheStats(layoutHits, layoutMisses);
+	ss << "\ntext layouts " << layoutHits << " reused, " << layoutMisses << " built";
+
+	for (auto& offender : FrameProfiler::getWorstOffenders(5))
+		ss << "\n" << offender.name << " " << offender.averageSelf / 1000.0f << "ms (max " << offender.maxSelf / 1000.0f << "ms)";
+
+	mProfilerText = std::unique_ptr<TextCache>(mDefaultFonts.at(0)->buildTextCache(ss.str(), 8.f, 8.f, 0xFFFF00FF));
+}
+
+// Frame-time graph of the recorded frames : update (blue), render (green) & swapBuffers (grey) stacked, with 16.7 and 33.3ms marks
+void Window::renderProfiler()
+{
+	const float screenWidth = (float)Renderer::getScreenWidth();
+	const float screenHeight = (float)Renderer::getScreenHeight();
+
+	const float barWidth = Math::max(1.0f, Math::round(screenWidth * 0.5f / FrameProfiler::FRAME_HISTORY));
+	const float graphWidth = barWidth * FrameProfiler::FRAME_HISTORY;
+	const float graphHeight = Math::round(screenHeight * 0.2f);
+	const float graphX = Math::round(screenWidth - graphWidth - 8);
+	const float graphY = Math::round(screenHeight - graphHeight - 8);
+	const float scale = graphHeight / 50000.0f; // full height = 50ms
+
+	Renderer::setMatrix(Transform4x4f::Identity());
+	Renderer::drawRect(graphX, graphY, graphWidth, graphHeight, 0x000000A0);
+
+	int count = FrameProfiler::getFrameCount();
+	for (int i = 0; i < count; i++)
+	{
+		const FrameProfiler::Frame& frame = FrameProfiler::getFrame(i);
+
+		float x = graphX + (FrameProfiler::FRAME_HISTORY - count + i) * barWidth;
+		float y = graphY + graphHeight;
+
+		const FrameProfiler::Phase phases[] = { FrameProfiler::UPDATE, FrameProfiler::RENDER, FrameProfiler::SWAP };
+		const unsigned int colors[] = { 0x4080FFE0, 0x40FF40E0, 0xA0A0A0E0 };
+
+		for (int p = 0; p < 3; p++)
+		{
+			float h = Math::min(frame.phases[phases[p]] * scale, y - graphY);
+			if (h <= 0)
+				continue;
+
+			y -= h;
+			Renderer::drawRect(x, y, barWidth, h, colors[p]);
+		}
+	}
+
+	Renderer::drawRect(graphX, Math::round(graphY + graphHeight - 16667 * scale), graphWidth, 1, 0xFFFF00A0);
+	Renderer::drawRect(graphX, Math::round(graphY + graphHeight - 33333 * scale), graphWidth, 1, 0xFF0000A0);
+
+	if (mProfilerText)
+		mDefaultFonts.at(0)->renderTextCache(mProfilerText.get());
+}
+
 void Window::normalizeNextUpdate()
 {
 	mNormalizeNextUpdate = true;
@@ -573,6 +735,7 @@ void Window::setHelpPrompts(const std::vector<HelpPrompt>& prompts, const HelpSt
 
 	mHelp->clearPrompts();
 	mHelp->setStyle(style);
+	invalidate();
 	
 	mClockElapsed = -1;
 
@@ -656,6 +819,73 @@ bool Window::isProcessing()
 	return count_if(mGuiStack.cbegin(), mGuiStack.cend(), [](GuiComponent* c) { return c->isProcessing(); }) > 0;
 }
 
+bool Window::needsRender()
+{
+	bool invalidated = mInvalidated.exchange(false);
+
+	// Textures loaded in the background since the last frame
+	unsigned int textureLoadCount = TextureResource::getAsyncLoadCount();
+	if (textureLoadCount != mLastTextureLoadCount)
+	{
+		mLastTextureLoadCount = textureLoadCount;
+		invalidated = true;
+	}
+
+	if (invalidated || !Settings::getInstance()->getBool("SkipIdleFrames"))
+		return true;
+
+	// These overlays measure every frame
+	if (Settings::getInstance()->getBool("DrawFramerate") || FrameProfiler::isEnabled())
+		return true;
+
+	if (SDL_GetTicks() - mLastRenderTime >= IDLE_REFRESH_DELAY)
+		return true;
+
+	// render() starts the screensaver, then puts the window to sleep
+	unsigned int screensaverTime = (unsigned int)Settings::getInstance()->getInt("ScreenSaverTime");
+	if (screensaverTime != 0 && mTimeSinceLastInput >= screensaverTime)
+		return true;
+
+	if (mRenderScreenSaver || (mScreenSaver && mScreenSaver->isScreenSaverActive()))
+		return true;
+
+	if (mInfoPopup && mInfoPopup->isRunning())
+		return true;
+
+	if (isProcessing())
+		return true;
+
+	// Only the bottom and the top of the stack are rendered (plus the one under a message box, which is not updated)
+	if (mGuiStack.size() && (mGuiStack.front()->isAnimating() || mGuiStack.back()->isAnimating()))
+		return true;
+
+	for (auto extra : mScreenExtras)
+		if (extra->isAnimating())
+			return true;
+
+	return false;
+}
+
+int Window::getIdleTimeout()
+{
+	int timeout = IDLE_REFRESH_DELAY - (int)(SDL_GetTicks() - mLastRenderTime);
+
+	// Next clock refresh
+	if (Settings::getInstance()->getBool("DrawClock") && mClock && mClockElapsed > 0 && mClockElapsed < timeout)
+		timeout = mClockElapsed;
+
+	// Screensaver start
+	unsigned int screensaverTime = (unsigned int)Settings::getInstance()->getInt("ScreenSaverTime");
+	if (screensaverTime != 0 && mTimeSinceLastInput < screensaverTime && (int)(screensaverTime - mTimeSinceLastInput) < timeout)
+		timeout = (int)(screensaverTime - mTimeSinceLastInput);
+
+	// The loader threads don't wake the main loop up : polls for the textures they complete
+	if (TextureResource::getPendingLoadCount() > 0 && timeout > TEXTURE_POLL_DELAY)
+		timeout = TEXTURE_POLL_DELAY;
+
+	return timeout < 1 ? 1 : timeout;
+}
+
 void Window::startScreenSaver()
 {
 	if (mScreenSaver && !mRenderScreenSaver)
@@ -718,6 +948,8 @@ void Window::displayNotificationMessage(std::string message, int duration)
 	msg.first = message;
 	msg.second = duration;
 	mNotificationMessages.push_back(msg);
+
+	invalidate();
 }
 
 void Window::processNotificationMessages()
@@ -736,6 +968,7 @@ void Window::processNotificationMessages()
 		delete mInfoPopup;
 
 	mInfoPopup = new GuiInfoPopup(this, msg.first, msg.second);
+	invalidate();
 }
 
 void Window::registerNotificationComponent(AsyncNotificationComponent* pc)
@@ -746,6 +979,7 @@ void Window::registerNotificationComponent(AsyncNotificationComponent* pc)
 		return;
 
 	mAsyncNotificationComponent.push_back(pc);
+	invalidate();
 }
 
 void Window::unRegisterNotificationComponent(AsyncNotificationComponent* pc)
@@ -755,6 +989,8 @@ void Window::unRegisterNotificationComponent(AsyncNotificationComponent* pc)
 	auto it = std::find(mAsyncNotificationComponent.cbegin(), mAsyncNotificationComponent.cend(), pc);
 	if (it != mAsyncNotificationComponent.cend())
 		mAsyncNotificationComponent.erase(it);
+
+	invalidate();
 }
 
 void Window::renderRegisteredNotificationComponents(const Transform4x4f& trans)
@@ -781,10 +1017,12 @@ void Window::postToUiThread(const std::function<void(Window*)>& func)
 	std::unique_lock<std::mutex> lock(mNotificationMessagesLock);
 
 	mFunctions.push_back(func);
+	invalidate();
 }
 
 void Window::processPostedFunctions()
 {
+	FrameProfiler::PhaseScope profile(FrameProfiler::POSTED_FUNCTIONS);
 	std::unique_lock<std::mutex> lock(mNotificationMessagesLock);
 
 	for (auto func : mFunctions)
@@ -800,6 +1038,7 @@ void Window::onThemeChanged(const std::shared_ptr<ThemeData>& theme)
 
 	mScreenExtras.clear();
 	mScreenExtras = ThemeData::makeExtras(theme, "screen", this);
+	invalidate();
 
 	std::stable_sort(mScreenExtras.begin(), mScreenExtras.end(), [](GuiComponent* a, GuiComponent* b) { return b->getZIndex() > a->getZIndex(); });
 
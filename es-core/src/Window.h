@@ -7,8 +7,10 @@
 #include "InputConfig.h"
 #include "Settings.h"
 
+#include <atomic>
 #include <memory>
 #include <functional>
+#include <thread>
 
 class FileData;
 class Font;
@@ -46,6 +48,7 @@ public:
 	public:
 		virtual void render(const Transform4x4f& parentTrans) = 0;
 		virtual void stop() = 0;
+		virtual bool isRunning() = 0;
 		virtual ~InfoPopup() {};
 	};
 
@@ -67,6 +70,14 @@ public:
 
 	void normalizeNextUpdate();
 
+	// Idle frame skipping : the main loop only renders and swaps when something changed or is animating,
+	// and otherwise waits for an event up to getIdleTimeout() ms.
+	// invalidate() can be called from any thread when something on screen changed without any input :
+	// from another thread, it also pushes a wake event so the main loop doesn't wait for the timeout.
+	void invalidate();
+	bool needsRender();
+	int getIdleTimeout();
+
 	inline bool isSleeping() const { return mSleeping; }
 	bool getAllowSleep();
 	void setAllowSleep(bool sleep);
@@ -134,6 +145,10 @@ private:
 	int mAverageDeltaTime;
 
 	std::unique_ptr<TextCache> mFrameDataText;
+	std::unique_ptr<TextCache> mProfilerText;
+
+	void updateProfilerText();
+	void renderProfiler();
 
 	// clock // batocera
 	int mClockElapsed;
@@ -148,6 +163,11 @@ private:
 
 	bool mRenderedHelpPrompts;
 
+	std::atomic<bool>	mInvalidated;
+	std::thread::id		mMainThreadId;
+	unsigned int		mLastRenderTime;
+	unsigned int		mLastTextureLoadCount;
+
 	bool mIgnoreKeys;
 };
 
@@ -30,6 +30,7 @@ public:
 	void reset(); // set to frame 0
 
 	void update(int deltaTime) override;
+	bool isAnimating() override { return (mEnabled && mFrames.size() > 1) || GuiComponent::isAnimating(); }
 	void render(const Transform4x4f& trans) override;
 
 	void onSizeChanged() override;
@@ -6,6 +6,7 @@
 #include "components/NinePatchComponent.h"
 #include "components/TextComponent.h"
 #include "EsLocale.h"
+#include "Window.h"
 
 #define PADDING_PX  (Renderer::getScreenWidth()*0.01)
 
@@ -76,6 +77,7 @@ void AsyncNotificationComponent::updateText(const std::string text, const std::s
 
 	mNextGameName = text;
 	mNextAction = action;
+	mWindow->invalidate();
 }
 
 void AsyncNotificationComponent::updatePercent(int percent)
@@ -83,6 +85,7 @@ void AsyncNotificationComponent::updatePercent(int percent)
 	std::unique_lock<std::mutex> lock(mMutex);
 
 	mPercent = percent;
+	mWindow->invalidate();
 }
 
 void AsyncNotificationComponent::updateTitle(const std::string text)
@@ -90,6 +93,7 @@ void AsyncNotificationComponent::updateTitle(const std::string text)
 	std::unique_lock<std::mutex> lock(mMutex);
 
 	mNextTitle = text;
+	mWindow->invalidate();
 }
 
 void AsyncNotificationComponent::render(const Transform4x4f& parentTrans)
@@ -109,6 +109,15 @@ std::shared_ptr<TextureResource> GridTileComponent::getTexture(bool marquee)
 	return nullptr; 
 }
 
+void GridTileComponent::setLoadPriority(TextureLoadPriority priority)
+{
+	if (mImage != nullptr)
+		mImage->setLoadPriority(priority);
+
+	if (mMarquee != nullptr)
+		mMarquee->setLoadPriority(priority);
+}
+
 void GridTileComponent::resize()
 {
 	auto currentProperties = getCurrentProperties();
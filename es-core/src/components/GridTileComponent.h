@@ -227,6 +227,7 @@ public:
 	virtual void onScreenSaverDeactivate();
 
 	std::shared_ptr<TextureResource> getTexture(bool marquee = false);
+	void setLoadPriority(TextureLoadPriority priority);
 
 private:
 	void	resetProperties();
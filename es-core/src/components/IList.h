@@ -100,6 +100,12 @@ public:
 		return (mScrollVelocity != 0 && mScrollTier > 0);
 	}
 
+	// Held direction or fading title overlay
+	bool isAnimating() override
+	{
+		return mScrollVelocity != 0 || mTitleOverlayOpacity > 0 || GuiComponent::isAnimating();
+	}
+
 	int getScrollingVelocity()
 	{
 		return mScrollVelocity;
@@ -198,6 +204,8 @@ public:
 
 	inline int size() const { return (int)mEntries.size(); }
 
+	inline const UserData& getObjectAt(int index) const { return mEntries.at(index).object; }
+
 	inline std::vector<UserData> getObjects()
 	{
 		std::vector<UserData> objects;
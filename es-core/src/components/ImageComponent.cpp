@@ -8,7 +8,9 @@
 #include "ThemeData.h"
 
 #include "resources/TextureData.h"
+#include "utils/AsyncUtil.h"
 #include "utils/FileSystemUtil.h"
+#include "ImageIO.h"
 
 Vector2i ImageComponent::getTextureSize() const
 {
@@ -24,9 +26,9 @@ Vector2f ImageComponent::getSize() const
 }
 
 ImageComponent::ImageComponent(Window* window, bool forceLoad, bool dynamic) : GuiComponent(window),
-	mTargetIsMax(false), mTargetIsMin(false), mFlipX(false), mFlipY(false), mTargetSize(0, 0), mColorShift(0xFFFFFFFF), mColorShiftEnd(0xFFFFFFFF),
-	mForceLoad(forceLoad), mDynamic(dynamic), mFadeOpacity(0), mFading(false), mRotateByTargetSize(false), mVisible(true),
-	mTopLeftCrop(0.0f, 0.0f), mBottomRightCrop(1.0f, 1.0f), mMirror(0.0f, 0.0f), mAllowAsync(false),
+	mTargetSize(0, 0), mFlipX(false), mFlipY(false), mTargetIsMax(false), mTargetIsMin(false), mUVRect(0, 0, 1, 1), mColorShift(0xFFFFFFFF), mColorShiftEnd(0xFFFFFFFF),
+	mFadeOpacity(0), mFading(false), mForceLoad(forceLoad), mDynamic(dynamic), mRotateByTargetSize(false), mVisible(true), mAllowAsync(false),
+	mTopLeftCrop(0.0f, 0.0f), mBottomRightCrop(1.0f, 1.0f), mMirror(0.0f, 0.0f),
 	mPadding(Vector4f(0, 0, 0, 0))
 {
 	mLinear = false;
@@ -203,6 +205,31 @@ void ImageComponent::setImage(const std::shared_ptr<TextureResource>& texture)
 	resize();
 }
 
+void ImageComponent::setLoadPriority(TextureLoadPriority priority)
+{
+	TextureResource::setLoadPriority(mLoadingTexture != nullptr ? mLoadingTexture : mTexture, priority);
+}
+
+std::shared_ptr<TextureResource> ImageComponent::prefetch(const std::string& path, TextureLoadPriority priority, MaxSizeInfo maxSize)
+{
+	if (mForceLoad || !mDynamic || !Utils::Async::isCanRunAsync())
+		return nullptr;
+
+	// Internal resources are static textures, loaded right away
+	std::string canonicalPath = Utils::FileSystem::getCanonicalPath(path);
+	if (canonicalPath.empty() || canonicalPath[0] == ':' || canonicalPath == mPath || !ResourceManager::getInstance()->fileExists(canonicalPath))
+		return nullptr;
+
+	// TextureResource falls back to a blocking load when it can't read the size from the header
+	unsigned int width, height;
+	if (!ImageIO::getImageSize(canonicalPath.c_str(), &width, &height))
+		return nullptr;
+
+	std::shared_ptr<TextureResource> texture = TextureResource::get(canonicalPath, false, mLinear, false, mDynamic, true, maxSize);
+	TextureResource::setLoadPriority(texture, priority);
+	return texture;
+}
+
 void ImageComponent::setResize(float width, float height)
 {
 	if (mSize.x() != 0 && mSize.y() != 0 && !mTargetIsMax && !mTargetIsMin && mTargetSize.x() == width && mTargetSize.y() == height)
@@ -361,6 +388,17 @@ void ImageComponent::updateVertices()
 		for (int i = 0; i < 4; i++)
 			mVertices[i].tex[1] = py - mVertices[i].tex[1];
 	}
+
+	// Packed in an atlas page : the coordinates are mapped to its region (tiled textures are never packed)
+	mUVRect = mTexture->getUVRect();
+	if (mUVRect != Vector4f(0, 0, 1, 1))
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			mVertices[i].tex[0] = mUVRect.x() + mVertices[i].tex[0] * (mUVRect.z() - mUVRect.x());
+			mVertices[i].tex[1] = mUVRect.y() + mVertices[i].tex[1] * (mUVRect.w() - mUVRect.y());
+		}
+	}
 }
 
 void ImageComponent::render(const Transform4x4f& parentTrans)
@@ -399,6 +437,10 @@ void ImageComponent::render(const Transform4x4f& parentTrans)
 			return;
 		}
 
+		// The shared texture was packed again (rasterized at another size...)
+		if (mTexture->getUVRect() != mUVRect)
+			updateVertices();
+
 		if (mVerticalAlignment == ALIGN_TOP)
 			trans.translate(Vector3f(0, targetSizePos.y(), 0.0f));
 		else if (mVerticalAlignment == ALIGN_BOTTOM)
@@ -724,6 +766,15 @@ void ImageComponent::onHide()
 }
 
 
+bool ImageComponent::isAnimating()
+{
+	// The fade starts once the texture has arrived : the Window already redraws when a background load completes
+	if (mFading && mTexture != nullptr && mTexture->isLoaded())
+		return true;
+
+	return GuiComponent::isAnimating();
+}
+
 void ImageComponent::update(int deltaTime)
 {
 	GuiComponent::update(deltaTime);
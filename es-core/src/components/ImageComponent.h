@@ -32,6 +32,11 @@ public:
 	//Use an already existing texture.
 	void setImage(const std::shared_ptr<TextureResource>& texture);
 
+	// Changes the loading priority of the texture being loaded, if any
+	void setLoadPriority(TextureLoadPriority priority);
+	// Queues the texture of an image this component may display soon. The texture is dropped from the loading queue when the returned reference is released, nullptr when it can't be loaded in the background.
+	std::shared_ptr<TextureResource> prefetch(const std::string& path, TextureLoadPriority priority, MaxSizeInfo maxSize = MaxSizeInfo());
+
 	void onSizeChanged() override;
 	void setOpacity(unsigned char opacity) override;
 
@@ -119,6 +124,7 @@ public:
 	virtual void onShow() override;
 	virtual void onHide() override;
 	virtual void update(int deltaTime);
+	bool isAnimating() override;
 
 	void setPlaylist(std::shared_ptr<IPlaylist> playList);
 
@@ -138,6 +144,7 @@ private:
 	void resize();
 
 	Renderer::Vertex mVertices[4];
+	Vector4f mUVRect; // texture region mVertices were built for (atlas page)
 //	GLubyte mColors[6*4];
 
 	void updateVertices();
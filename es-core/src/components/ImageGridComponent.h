@@ -74,6 +74,8 @@ public:
 	void render(const Transform4x4f& parentTrans) override;
 	virtual void applyTheme(const std::shared_ptr<ThemeData>& theme, const std::string& view, const std::string& element, unsigned int properties) override;
 
+	bool isAnimating() override;
+
 	void onSizeChanged() override;
 	inline void setCursorChangedCallback(const std::function<void(CursorState state)>& func) { mCursorChangedCallback = func; }
 
@@ -102,6 +104,7 @@ private:
 	void buildTiles();
 	void updateTiles(bool allowAnimation = true, bool updateSelectedState = true);
 	void updateTileAtPos(int tilePos, int imgPos, bool allowAnimation = true, bool updateSelectedState = true);
+	void updateLoadPriorities();
 	void calcGridDimension();
 	
 	bool isVertical() { return mScrollDirection == SCROLL_VERTICALLY; };
@@ -245,6 +248,20 @@ void ImageGridComponent<T>::update(int deltaTime)
 		(*it)->update(deltaTime);
 }
 
+template<typename T>
+bool ImageGridComponent<T>::isAnimating()
+{
+	if (IList<ImageGridData, T>::isAnimating())
+		return true;
+
+	// Tiles are not children : they are updated and rendered by the grid
+	for (auto tile : mTiles)
+		if (tile->isAnimating())
+			return true;
+
+	return false;
+}
+
 template<typename T>
 void ImageGridComponent<T>::topWindow(bool isTop)
 {
@@ -818,12 +835,40 @@ void ImageGridComponent<T>::updateTiles(bool allowAnimation, bool updateSelected
 			TextureResource::cancelAsync(tex);
 	}
 
+	updateLoadPriorities();
+
 	if (updateSelectedState)
 		mLastCursor = mCursor;
 
 	mEntriesDirty = false;
 }
 
+// The EXTRAITEMS rows (or columns) on each side of the grid are off screen : the ones in the scrolling direction are
+// loaded before them, the ones behind only when nothing else is waiting. In each priority, the tiles closest to the
+// scrolling edge are queued last, so they're loaded first.
+template<typename T>
+void ImageGridComponent<T>::updateLoadPriorities()
+{
+	int count = (int)mTiles.size();
+	int bufferTiles = EXTRAITEMS * (isVertical() ? mGridDimension.x() : mGridDimension.y());
+	if (count <= 2 * bufferTiles)
+		return;
+
+	bool forward = mCameraDirection < 0;
+
+	// p walks the tiles from the back to the front of the scrolling direction
+	auto tileAt = [this, count, forward](int p) { return mTiles.at(forward ? p : count - 1 - p); };
+
+	for (int p = 0; p < bufferTiles; p++)
+		tileAt(p)->setLoadPriority(TEXTURE_LOAD_SPECULATIVE);
+
+	for (int p = bufferTiles; p < count - bufferTiles; p++)
+		tileAt(p)->setLoadPriority(TEXTURE_LOAD_VISIBLE);
+
+	for (int p = count - 1; p >= count - bufferTiles; p--)
+		tileAt(p)->setLoadPriority(TEXTURE_LOAD_PREFETCH);
+}
+
 template<typename T>
 void ImageGridComponent<T>::updateTileAtPos(int tilePos, int imgPos, bool allowAnimation, bool updateSelectedState)
 {
@@ -8,7 +8,7 @@
 NinePatchComponent::NinePatchComponent(Window* window, const std::string& path, unsigned int edgeColor, unsigned int centerColor) : GuiComponent(window),
 mCornerSize(16, 16),
 mEdgeColor(edgeColor), mCenterColor(centerColor),
-mVertices(NULL)
+mVertices(NULL), mUVRect(0, 0, 1, 1)
 {
 	mTimer = 0;
 	mAnimateTiming = 0;
@@ -104,6 +104,11 @@ void NinePatchComponent::buildVertices()
 	const float texPosX[3] = { 0,     texSizeX[0],     texSizeX[0] + texSizeX[1] };
 	const float texPosY[3] = { 1, 1 + texSizeY[0], 1 + texSizeY[0] + texSizeY[1] };
 
+	// Packed in an atlas page : the coordinates are mapped to its region
+	mUVRect = mTexture->getUVRect();
+	const Vector2f uvPos = Vector2f(mUVRect.x(), mUVRect.y());
+	const Vector2f uvScale = Vector2f(mUVRect.z() - mUVRect.x(), mUVRect.w() - mUVRect.y());
+
 	int v = 0;
 	for (int slice = 0; slice < 9; slice++)
 	{
@@ -121,7 +126,10 @@ void NinePatchComponent::buildVertices()
 
 		// round vertices
 		for (int i = 1; i < 5; ++i)
+		{
 			mVertices[v + i].pos.round();
+			mVertices[v + i].tex = uvPos + mVertices[v + i].tex * uvScale;
+		}
 
 		// make duplicates of first and last vertex so this can be rendered as a triangle strip
 		mVertices[v + 0] = mVertices[v + 1];
@@ -168,6 +176,14 @@ void NinePatchComponent::render(const Transform4x4f& parentTrans)
 	}
 	else if (mTexture->bind())
 	{
+		// The shared texture was packed again
+		if (mTexture->getUVRect() != mUVRect)
+		{
+			buildVertices();
+			if (mVertices == nullptr)
+				return;
+		}
+
 		if (mAnimateTiming > 0)
 		{
 			float opacity = mOpacity / 255.0;
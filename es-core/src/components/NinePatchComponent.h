@@ -3,6 +3,7 @@
 #ifndef ES_CORE_COMPONENTS_NINE_PATCH_COMPONENT_H
 #define ES_CORE_COMPONENTS_NINE_PATCH_COMPONENT_H
 
+#include "math/Vector4f.h"
 #include "renderers/Renderer.h"
 #include "GuiComponent.h"
 
@@ -27,6 +28,7 @@ public:
 
 	void render(const Transform4x4f& parentTrans) override;
 	void update(int deltaTime) override;
+	bool isAnimating() override { return mAnimateTiming > 0 || GuiComponent::isAnimating(); }
 
 	void onSizeChanged() override;
 
@@ -52,6 +54,7 @@ private:
 	void updateColors();
 
 	Renderer::Vertex* mVertices;
+	Vector4f mUVRect; // texture region mVertices were built for (atlas page)
 
 	std::string mPath;
 	Vector2f mCornerSize;
@@ -437,6 +437,14 @@ public:
 		onSelectedChanged();
 	}
 
+	// Renames the entries holding 'obj' (takes effect the next time the popup is opened)
+	void setEntryName(const T& obj, const std::string& name)
+	{
+		for (auto& entry : mEntries)
+			if (entry.object == obj)
+				entry.name = name;
+	}
+
 	void setSelectedChangedCallback(const std::function<void(const T&)>& callback) 
 	{
 		mSelectedChangedCallback = callback;
@@ -503,7 +511,7 @@ private:
 		}
 
 		if (mSelectedChangedCallback)
-			mSelectedChangedCallback(mEntries.at(getSelectedId()).object);		
+			mSelectedChangedCallback(mMultiSelect ? T() : mEntries.at(getSelectedId()).object);
 	}
 
 	std::vector<HelpPrompt> getHelpPrompts() override
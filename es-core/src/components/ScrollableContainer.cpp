@@ -61,6 +61,18 @@ void ScrollableContainer::setScrollPos(const Vector2f& pos)
 	mScrollPos = pos;
 }
 
+bool ScrollableContainer::isAnimating()
+{
+	if (mAutoScrollSpeed != 0)
+	{
+		// Only moves when the content is taller than the container
+		if (getContentSize().y() > getSize().y())
+			return true;
+	}
+
+	return GuiComponent::isAnimating();
+}
+
 void ScrollableContainer::update(int deltaTime)
 {
 	if(mAutoScrollSpeed != 0)
@@ -394,6 +394,8 @@ void TextComponent::update(int deltaTime)
 			if (mMarqueeOffset > (scrollLength - (limit - returnLength)))
 				mMarqueeOffset2 = (int)(mMarqueeOffset - (scrollLength + returnLength));
 		}
+		else
+			mMarqueeTime = 0;
 	}
 	else
 	{
@@ -50,6 +50,7 @@ public:
 	void setPadding(const Vector4f padding) { mPadding = padding; }
 
 	virtual void update(int deltaTime);
+	bool isAnimating() override { return (mAutoScroll && mMarqueeTime > 0) || GuiComponent::isAnimating(); }
 
 	bool getAutoScroll() { return mAutoScroll; }
 	void setAutoScroll(bool value);
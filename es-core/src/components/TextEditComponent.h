@@ -18,6 +18,7 @@ public:
 	void textInput(const char* text) override;
 	bool input(InputConfig* config, Input input) override;
 	void update(int deltaTime) override;
+	bool isAnimating() override { return mFocused || GuiComponent::isAnimating(); } // blinking cursor
 	void render(const Transform4x4f& parentTrans) override;
 
 	void onFocusGained() override;
@@ -3,6 +3,7 @@
 
 #include "renderers/Renderer.h"
 #include "resources/TextureResource.h"
+#include "utils/PixelUtil.h"
 #include "utils/StringUtil.h"
 #include "PowerSaver.h"
 #include "Settings.h"
@@ -29,11 +30,7 @@ static void *lock(void *data, void **p_pixels)
 {
 	struct VideoContext *c = (struct VideoContext *)data;
 
-	int frame = (c->surfaceId ^ 1);
-
-	c->mutexes[frame].lock();
-	c->hasFrame[frame] = false;
-	*p_pixels = c->surfaces[frame];
+	*p_pixels = c->surfaces[c->writing];
 	return NULL; // Picture identifier, not needed here.
 }
 
@@ -42,11 +39,12 @@ static void unlock(void *data, void* /*id*/, void *const* /*p_pixels*/)
 {
 	struct VideoContext *c = (struct VideoContext *)data;
 
-	int frame = (c->surfaceId ^ 1);
+	// Still on the decoder thread : the render thread only uploads
+	if (c->swapRedBlue)
+		Utils::Pixel::swapRedBlue565(c->surfaces[c->writing], c->pixelCount);
 
-	c->surfaceId = frame;
-	c->hasFrame[frame] = true;
-	c->mutexes[frame].unlock();
+	// Publishes the frame, and takes back the surface nobody uses : the previous frame if it wasn't uploaded, skipped
+	c->writing = c->ready.exchange(c->writing | VIDEO_FRAME_READY) & 3;
 }
 
 // VLC wants to display a video frame.
@@ -244,8 +242,7 @@ void VideoVlcComponent::render(const Transform4x4f& parentTrans)
 	// Build a texture for the video frame
 	if (initFromPixels)
 	{
-		int frame = mContext.surfaceId;
-		if (mContext.hasFrame[frame])
+		if (mContext.ready.load() & VIDEO_FRAME_READY)
 		{
 			if (mTexture == nullptr)
 			{
@@ -259,10 +256,8 @@ void VideoVlcComponent::render(const Transform4x4f& parentTrans)
 			if (!Settings::getInstance()->getBool("OptimizeVideo") || mElapsed >= 40) // 40ms = 25fps, 33.33 = 30 fps
 #endif
 			{
-				mContext.mutexes[frame].lock();
-				mTexture->initFromExternalPixels(mContext.surfaces[frame], mVideoWidth, mVideoHeight);
-				mContext.hasFrame[frame] = false;
-				mContext.mutexes[frame].unlock();
+				mContext.reading = mContext.ready.exchange(mContext.reading) & 3;
+				mTexture->initFromExternalPixels(mContext.surfaces[mContext.reading], mVideoWidth, mVideoHeight, mContext.format);
 
 				mElapsed = 0;
 			}
@@ -390,11 +385,19 @@ void VideoVlcComponent::setupContext()
 	if (mContext.valid)
 		return;
 
-	// Create an RGBA surface to render the video into
-	mContext.surfaces[0] = new unsigned char[mVideoWidth * mVideoHeight * 4];
-	mContext.surfaces[1] = new unsigned char[mVideoWidth * mVideoHeight * 4];
-	mContext.hasFrame[0] = false;
-	mContext.hasFrame[1] = false;
+	// 16 bits frames on 16 bits panels : half the memory to convert, copy and upload, for the same picture
+	mContext.format = Renderer::getDisplayBitsPerPixel() <= 16 ? Renderer::Texture::RGB565 : Renderer::Texture::RGBA;
+	mContext.swapRedBlue = (mContext.format == Renderer::Texture::RGB565);
+	mContext.pixelCount = mVideoWidth * mVideoHeight;
+
+	// Create the surfaces to render the video into
+	size_t size = mContext.pixelCount * (mContext.format == Renderer::Texture::RGB565 ? 2 : 4);
+	for (int i = 0; i < 3; i++)
+		mContext.surfaces[i] = new unsigned char[size];
+
+	mContext.writing = 0;
+	mContext.reading = 1;
+	mContext.ready = 2;
 	mContext.component = this;
 	mContext.valid = true;
 	resize();
@@ -411,12 +414,13 @@ void VideoVlcComponent::freeContext()
 		mTexture = nullptr;
 	}
 
-	delete[] mContext.surfaces[0];
-	delete[] mContext.surfaces[1];
-	mContext.surfaces[0] = nullptr;
-	mContext.surfaces[1] = nullptr;
-	mContext.hasFrame[0] = false;
-	mContext.hasFrame[1] = false;
+	for (int i = 0; i < 3; i++)
+	{
+		delete[] mContext.surfaces[i];
+		mContext.surfaces[i] = nullptr;
+	}
+
+	mContext.ready = 2;
 	mContext.component = NULL;
 	mContext.valid = false;
 }
@@ -599,7 +603,10 @@ void VideoVlcComponent::startVideo()
 
 				libvlc_media_player_play(mMediaPlayer);
 				libvlc_video_set_callbacks(mMediaPlayer, lock, unlock, display, (void*)&mContext);
-				libvlc_video_set_format(mMediaPlayer, "RGBA", (int)mVideoWidth, (int)mVideoHeight, (int)mVideoWidth * 4);
+				if (mContext.format == Renderer::Texture::RGB565)
+					libvlc_video_set_format(mMediaPlayer, "RV16", (int)mVideoWidth, (int)mVideoHeight, (int)mVideoWidth * 2);
+				else
+					libvlc_video_set_format(mMediaPlayer, "RGBA", (int)mVideoWidth, (int)mVideoHeight, (int)mVideoWidth * 4);
 
 				// Update the playing state -> Useless now set by display() & onVideoStarted
 				//mIsPlaying = true;
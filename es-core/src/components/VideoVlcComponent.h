@@ -3,30 +3,42 @@
 #ifndef ES_CORE_COMPONENTS_VIDEO_VLC_COMPONENT_H
 #define ES_CORE_COMPONENTS_VIDEO_VLC_COMPONENT_H
 
+#include "renderers/Renderer.h"
 #include "VideoComponent.h"
-#include <mutex>
+#include <atomic>
 
 struct libvlc_instance_t;
 struct libvlc_media_t;
 struct libvlc_media_player_t;
 
+#define VIDEO_FRAME_READY 4 // flag of VideoContext::ready, set when the surface holds a frame not uploaded yet
+
+// Triple buffer without locks : VLC decodes into 'writing', the renderer uploads 'reading',
+// and the two exchange their surface with 'ready', the last complete frame.
 struct VideoContext
 {
-	VideoContext()
+	VideoContext() : ready(2)
 	{
 		surfaces[0] = nullptr;
 		surfaces[1] = nullptr;
+		surfaces[2] = nullptr;
+		writing = 0;
+		reading = 1;
+		pixelCount = 0;
+		format = Renderer::Texture::RGBA;
+		swapRedBlue = false;
 		component = nullptr;
 		valid = false;
-		hasFrame[0] = false;
-		hasFrame[1] = false;
-		surfaceId = 0;
 	}
 
-	int					surfaceId;
-	unsigned char*		surfaces[2];
-	std::mutex			mutexes[2];
-	bool				hasFrame[2];
+	unsigned char*		surfaces[3];
+	int					writing;	// VLC thread only
+	int					reading;	// render thread only
+	std::atomic<int>	ready;		// surface index | VIDEO_FRAME_READY
+
+	size_t					pixelCount;
+	Renderer::Texture::Type	format;
+	bool					swapRedBlue; // RV16 frames have red in the low bits
 
 	VideoComponent*		component;
 	bool				valid;
@@ -16,6 +16,7 @@ public:
 
 	bool input(InputConfig* config, Input input) override;
 	void update(int deltaTime) override;
+	bool isAnimating() override { return mHoldingConfig != nullptr || GuiComponent::isAnimating(); }
 	void onSizeChanged() override;
 
 private:
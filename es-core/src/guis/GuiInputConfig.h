@@ -17,6 +17,7 @@ public:
 	GuiInputConfig(Window* window, InputConfig* target, bool reconfigureAll, const std::function<void()>& okCallback);
 
 	void update(int deltaTime) override;
+	bool isAnimating() override { return (mConfiguringRow && mHoldingInput) || GuiComponent::isAnimating(); }
 
 	void onSizeChanged() override;
 
@@ -259,3 +259,35 @@ std::string getShOutput(const std::string& mStr)
     pclose(pipe);
     return result;
 }
+
+long long getAvailableMemory()
+{
+#if defined(WIN32)
+	MEMORYSTATUSEX status;
+	status.dwLength = sizeof(status);
+	if (GlobalMemoryStatusEx(&status))
+		return (long long)status.ullAvailPhys;
+
+	return -1;
+#else
+	FILE* file = fopen("/proc/meminfo", "r");
+	if (file == NULL)
+		return -1;
+
+	long long available = -1;
+
+	char line[256];
+	while (fgets(line, sizeof(line), file) != NULL)
+	{
+		long long kb;
+		if (sscanf(line, "MemAvailable: %lld kB", &kb) == 1)
+		{
+			available = kb * 1024;
+			break;
+		}
+	}
+
+	fclose(file);
+	return available;
+#endif
+}
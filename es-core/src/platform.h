@@ -83,4 +83,7 @@ private:
 
 std::string getShOutput(const std::string& mStr);
 
+// Bytes the system can still give without swapping (MemAvailable on Linux), -1 if unknown
+long long getAvailableMemory();
+
 #endif // ES_CORE_PLATFORM_H
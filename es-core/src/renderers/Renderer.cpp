@@ -9,7 +9,9 @@
 #include "Settings.h"
 
 #include <SDL.h>
+#include <algorithm>
 #include <stack>
+#include <vector>
 
 #include <go2/display.h>
 
@@ -35,6 +37,23 @@ namespace Renderer
 
 	static Vector2i			sdlWindowPosition  = Vector2i(SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED);
 
+	// Batch of indexed triangles, in screen space. The arrays keep their capacity from frame to frame.
+	#define BATCH_MAX_VERTICES 65536 // 16 bits indices for GLES 1.0
+
+	enum ModelView { MODELVIEW_UNKNOWN, MODELVIEW_IDENTITY, MODELVIEW_MATRIX };
+
+	static std::vector<Vertex>         batchVertices;
+	static std::vector<unsigned short> batchIndices;
+	static unsigned int                currentTexture      = 0;
+	static unsigned int                batchTexture        = 0;
+	static Blend::Factor               batchSrcBlendFactor = Blend::SRC_ALPHA;
+	static Blend::Factor               batchDstBlendFactor = Blend::ONE_MINUS_SRC_ALPHA;
+	static Transform4x4f               currentMatrix       = Transform4x4f::Identity();
+	static bool                        currentMatrixIs2D   = true;
+	static ModelView                   modelView           = MODELVIEW_UNKNOWN;
+	static Statistics                  frameStatistics;
+	static Statistics                  lastFrameStatistics;
+
 	static void setIcon()
 	{
 #if 0
@@ -269,6 +288,13 @@ namespace Renderer
 			break;
 		}
 
+		// New context : its modelview matrix is not the one we last loaded
+		batchVertices.clear();
+		batchIndices.clear();
+		currentTexture = 0;
+		batchTexture = 0;
+		modelView = MODELVIEW_UNKNOWN;
+
 		setViewport(viewport);
 		setProjection(projection);
 		swapBuffers();
@@ -376,6 +402,171 @@ namespace Renderer
 		return rectOverlap(screen, box);
 	}
 
+	void bindTexture(const unsigned int _texture)
+	{
+		currentTexture = _texture;
+
+	} // bindTexture
+
+	void setMatrix(const Transform4x4f& _matrix)
+	{
+		// Only stored : the batched vertices are transformed on the CPU, the other draws load it with beginImmediateDraw()
+		currentMatrix = _matrix;
+		currentMatrix.round();
+
+		const float* tm = (float*)&currentMatrix;
+		currentMatrixIs2D = (tm[2] == 0 && tm[6] == 0 && tm[14] == 0 && tm[3] == 0 && tm[7] == 0 && tm[15] == 1);
+
+		if (modelView == MODELVIEW_MATRIX)
+			modelView = MODELVIEW_UNKNOWN;
+
+	} // setMatrix
+
+	void flush()
+	{
+		if (batchIndices.empty())
+			return;
+
+		applyTexture(batchTexture);
+
+		if (modelView != MODELVIEW_IDENTITY)
+		{
+			loadMatrix(Transform4x4f::Identity());
+			modelView = MODELVIEW_IDENTITY;
+			frameStatistics.stateChanges++;
+		}
+
+		drawTriangles(batchVertices.data(), batchIndices.data(), (unsigned int)batchIndices.size(), batchSrcBlendFactor, batchDstBlendFactor);
+
+		frameStatistics.drawCalls++;
+		frameStatistics.vertices += (unsigned int)batchVertices.size();
+
+		batchVertices.clear();
+		batchIndices.clear();
+
+	} // flush
+
+	void beginImmediateDraw()
+	{
+		flush();
+		applyTexture(currentTexture);
+
+		if (modelView != MODELVIEW_MATRIX)
+		{
+			loadMatrix(currentMatrix);
+			modelView = MODELVIEW_MATRIX;
+			frameStatistics.stateChanges++;
+		}
+
+	} // beginImmediateDraw
+
+	static void appendTriangleStrips(const Vertex* _vertices, const unsigned int _numVertices, const Vector2f& _offset, const unsigned int* _color, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
+	{
+		if (_numVertices < 3)
+			return;
+
+		// More vertices than 16 bits indices can address : drawn as strips sharing their last two vertices. The step is even, so the winding is kept.
+		if (_numVertices > BATCH_MAX_VERTICES)
+		{
+			const unsigned int step = BATCH_MAX_VERTICES - 2;
+			for (unsigned int start = 0; start + 2 < _numVertices; start += step)
+				appendTriangleStrips(_vertices + start, std::min(_numVertices - start, (unsigned int)BATCH_MAX_VERTICES), _offset, _color, _srcBlendFactor, _dstBlendFactor);
+
+			return;
+		}
+
+		if (currentTexture != batchTexture || _srcBlendFactor != batchSrcBlendFactor || _dstBlendFactor != batchDstBlendFactor || batchVertices.size() + _numVertices > BATCH_MAX_VERTICES)
+		{
+			flush();
+			batchTexture = currentTexture;
+			batchSrcBlendFactor = _srcBlendFactor;
+			batchDstBlendFactor = _dstBlendFactor;
+		}
+
+		// Matrices with a depth or a perspective part (never used by the UI) are not flattened : drawn alone, with the GL matrix
+		const bool transform = currentMatrixIs2D;
+		if (!transform)
+			flush();
+
+		const float*         tm    = (float*)&currentMatrix;
+		const unsigned short first = (unsigned short)batchVertices.size();
+
+		for (unsigned int i = 0; i < _numVertices; ++i)
+		{
+			Vertex vertex = _vertices[i];
+			vertex.pos += _offset;
+			if (_color != nullptr)
+				vertex.col = *_color;
+
+			if (transform)
+			{
+				const float x = vertex.pos.x();
+				const float y = vertex.pos.y();
+				vertex.pos = Vector2f(tm[0] * x + tm[4] * y + tm[12], tm[1] * x + tm[5] * y + tm[13]);
+			}
+
+			batchVertices.push_back(vertex);
+		}
+
+		// Strip -> triangles. The degenerate triangles joining strips (duplicated vertices) are dropped.
+		for (unsigned int i = 0; i + 2 < _numVertices; ++i)
+		{
+			const Vector2f& a = _vertices[i].pos;
+			const Vector2f& b = _vertices[i + 1].pos;
+			const Vector2f& c = _vertices[i + 2].pos;
+			if (a == b || b == c || a == c)
+				continue;
+
+			batchIndices.push_back(first + i);
+			batchIndices.push_back(first + i + 1 + (i & 1));
+			batchIndices.push_back(first + i + 2 - (i & 1));
+		}
+
+		if (!transform)
+		{
+			std::vector<Vertex>         vertices;
+			std::vector<unsigned short> indices;
+			vertices.swap(batchVertices);
+			indices.swap(batchIndices);
+
+			beginImmediateDraw();
+			drawTriangles(vertices.data(), indices.data(), (unsigned int)indices.size(), _srcBlendFactor, _dstBlendFactor);
+			frameStatistics.drawCalls++;
+			frameStatistics.vertices += (unsigned int)vertices.size();
+
+			// Gives the arena back
+			vertices.clear();
+			indices.clear();
+			batchVertices.swap(vertices);
+			batchIndices.swap(indices);
+		}
+
+	} // appendTriangleStrips
+
+	void drawTriangleStrips(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
+	{
+		appendTriangleStrips(_vertices, _numVertices, Vector2f::Zero(), nullptr, _srcBlendFactor, _dstBlendFactor);
+
+	} // drawTriangleStrips
+
+	void drawTriangleStrips(const Vertex* _vertices, const unsigned int _numVertices, const Vector2f& _offset, const unsigned int _color, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
+	{
+		appendTriangleStrips(_vertices, _numVertices, _offset, &_color, _srcBlendFactor, _dstBlendFactor);
+
+	} // drawTriangleStrips
+
+	void endFrame()
+	{
+		flush();
+
+		lastFrameStatistics = frameStatistics;
+		frameStatistics = Statistics();
+
+	} // endFrame
+
+	Statistics&       getStatistics()          { return frameStatistics; }
+	const Statistics& getLastFrameStatistics() { return lastFrameStatistics; }
+
 	void drawRect(const float _x, const float _y, const float _w, const float _h, const unsigned int _color, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
 	{
 		drawRect(_x, _y, _w, _h, _color, _color, true, _srcBlendFactor, _dstBlendFactor);
@@ -4,6 +4,7 @@
 #define ES_CORE_RENDERER_RENDERER_H
 
 #include "math/Vector2f.h"
+#include <functional>
 
 class  Transform4x4f;
 class  Vector2i;
@@ -35,8 +36,9 @@ namespace Renderer
 	{
 		enum Type
 		{
-			RGBA  = 0,
-			ALPHA = 1
+			RGBA   = 0,
+			ALPHA  = 1,
+			RGB565 = 2  // 16 bits, red in the high bits
 
 		}; // Type
 
@@ -64,6 +66,16 @@ namespace Renderer
 
 	}; // Vertex
 
+	struct Statistics
+	{
+		Statistics() : drawCalls(0), stateChanges(0), vertices(0) { }
+
+		unsigned int drawCalls;
+		unsigned int stateChanges; // texture binds, blending and matrix changes that reached GL
+		unsigned int vertices;
+
+	}; // Statistics
+
 	bool        init            ();
 	void        deinit          ();
 	void        pushClipRect    (const Vector2i& _pos, const Vector2i& _size);
@@ -81,20 +93,35 @@ namespace Renderer
 	int         getScreenRotate ();
 	go2_display_t* getDisplay();
 
+	// Draw-call batching : drawTriangleStrips() appends indexed triangles to a batch, transformed by the current matrix on the CPU,
+	// so matrix changes don't break it. The batch is drawn when the texture, the blending or the scissor changes, before any other
+	// kind of drawing, and by swapBuffers(). bindTexture() only selects the texture of the next draws.
+	void        bindTexture       (const unsigned int _texture);
+	void        setMatrix         (const Transform4x4f& _matrix);
+	void        drawTriangleStrips(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor = Blend::SRC_ALPHA, const Blend::Factor _dstBlendFactor = Blend::ONE_MINUS_SRC_ALPHA);
+	void        drawTriangleStrips(const Vertex* _vertices, const unsigned int _numVertices, const Vector2f& _offset, const unsigned int _color, const Blend::Factor _srcBlendFactor = Blend::SRC_ALPHA, const Blend::Factor _dstBlendFactor = Blend::ONE_MINUS_SRC_ALPHA); // shared vertices, drawn moved and with another (converted) color
+	void        flush             ();
+	void        beginImmediateDraw(); // flushes the batch and loads the current matrix, before drawing without the batch
+	void        endFrame          (); // flushes the batch and starts new statistics, called by swapBuffers()
+	Statistics& getStatistics     (); // frame being drawn
+	const Statistics& getLastFrameStatistics();
+
 	// API specific
 	unsigned int convertColor      (const unsigned int _color);
 	unsigned int getWindowFlags    ();
+	unsigned int getDisplayBitsPerPixel(); // color depth of the panel, 16 when textures can be 565 without losing anything
+	void         setStatusChangedCallback(const std::function<void()>& _callback); // called from another thread when an overlay drawn by swapBuffers() is outdated
 	void         setupWindow       ();
 	void         createContext     ();
 	void         destroyContext    ();
 	unsigned int createTexture     (const Texture::Type _type, const bool _linear, const bool _repeat, const unsigned int _width, const unsigned int _height, void* _data);
 	void         destroyTexture    (const unsigned int _texture);
 	void         updateTexture     (const unsigned int _texture, const Texture::Type _type, const unsigned int _x, const unsigned _y, const unsigned int _width, const unsigned int _height, void* _data);
-	void         bindTexture       (const unsigned int _texture);
+	void         applyTexture      (const unsigned int _texture); // binds it in GL now
 	void         drawLines         (const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor = Blend::SRC_ALPHA, const Blend::Factor _dstBlendFactor = Blend::ONE_MINUS_SRC_ALPHA);
-	void         drawTriangleStrips(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor = Blend::SRC_ALPHA, const Blend::Factor _dstBlendFactor = Blend::ONE_MINUS_SRC_ALPHA);
+	void         drawTriangles     (const Vertex* _vertices, const unsigned short* _indices, const unsigned int _numIndices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor);
 	void         setProjection     (const Transform4x4f& _projection);
-	void         setMatrix         (const Transform4x4f& _matrix);
+	void         loadMatrix        (const Transform4x4f& _matrix);
 	void         setViewport       (const Rect& _viewport);
 	void         setScissor        (const Rect& _scissor);
 	void         setSwapInterval   ();
@@ -37,13 +37,68 @@ namespace Renderer
 	{
 		switch(_type)
 		{
-			case Texture::RGBA:  { return GL_RGBA;  } break;
-			case Texture::ALPHA: { return GL_ALPHA; } break;
-			default:             { return GL_ZERO;  }
+			case Texture::RGBA:   { return GL_RGBA;  } break;
+			case Texture::ALPHA:  { return GL_ALPHA; } break;
+			case Texture::RGB565: { return GL_RGB;   } break;
+			default:              { return GL_ZERO;  }
 		}
 
 	} // convertTextureType
 
+	static GLenum convertTextureDataType(const Texture::Type _type)
+	{
+		switch(_type)
+		{
+			case Texture::RGB565: { return GL_UNSIGNED_SHORT_5_6_5; } break;
+			default:              { return GL_UNSIGNED_BYTE;        }
+		}
+
+	} // convertTextureDataType
+
+	// GL state, to skip the redundant changes. Blending and the vertex arrays stay enabled : every draw uses them.
+	#define UNKNOWN_TEXTURE 0xFFFFFFFF
+
+	static unsigned int boundTexture     = UNKNOWN_TEXTURE;
+	static bool         drawStateEnabled = false;
+	static GLenum       srcBlendFactor   = GL_ZERO;
+	static GLenum       dstBlendFactor   = GL_ZERO;
+
+	static void resetState()
+	{
+		boundTexture     = UNKNOWN_TEXTURE;
+		drawStateEnabled = false;
+		srcBlendFactor   = GL_ZERO;
+		dstBlendFactor   = GL_ZERO;
+
+	} // resetState
+
+	static void setDrawState(const Vertex* _vertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
+	{
+		if (!drawStateEnabled)
+		{
+			glEnable(GL_BLEND);
+			glEnableClientState(GL_VERTEX_ARRAY);
+			glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+			glEnableClientState(GL_COLOR_ARRAY);
+			drawStateEnabled = true;
+		}
+
+		const GLenum src = convertBlendFactor(_srcBlendFactor);
+		const GLenum dst = convertBlendFactor(_dstBlendFactor);
+		if (src != srcBlendFactor || dst != dstBlendFactor)
+		{
+			glBlendFunc(src, dst);
+			srcBlendFactor = src;
+			dstBlendFactor = dst;
+			getStatistics().stateChanges++;
+		}
+
+		glVertexPointer(  2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].pos);
+		glTexCoordPointer(2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].tex);
+		glColorPointer(   4, GL_UNSIGNED_BYTE, sizeof(Vertex), &_vertices[0].col);
+
+	} // setDrawState
+
 	unsigned int convertColor(const unsigned int _color)
 	{
 		// convert from rgba to abgr
@@ -62,6 +117,23 @@ namespace Renderer
 
 	} // getWindowFlags
 
+	unsigned int getDisplayBitsPerPixel()
+	{
+		int r = 8, g = 8, b = 8;
+		SDL_GL_GetAttribute(SDL_GL_RED_SIZE,   &r);
+		SDL_GL_GetAttribute(SDL_GL_GREEN_SIZE, &g);
+		SDL_GL_GetAttribute(SDL_GL_BLUE_SIZE,  &b);
+
+		return (unsigned int)(r + g + b);
+
+	} // getDisplayBitsPerPixel
+
+	void setStatusChangedCallback(const std::function<void()>& /*_callback*/)
+	{
+		// Nothing is drawn over the frames
+
+	} // setStatusChangedCallback
+
 	void setupWindow()
 	{
 		SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, 1);
@@ -86,6 +158,7 @@ namespace Renderer
 		SDL_GL_MakeCurrent(getSDLWindow(), sdlContext);
 
 		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+		resetState();
 
 		std::string glExts = (const char*)glGetString(GL_EXTENSIONS);
 		LOG(LogInfo) << "Checking available OpenGL extensions...";
@@ -106,7 +179,7 @@ namespace Renderer
 		unsigned int texture;
 
 		glGenTextures(1, &texture);
-		bindTexture(texture);
+		applyTexture(texture);
 
 		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, _repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE);
 		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, _repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE);
@@ -117,7 +190,7 @@ namespace Renderer
 		glPixelStorei(GL_PACK_ALIGNMENT, 1);
 		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-		glTexImage2D(GL_TEXTURE_2D, 0, type, _width, _height, 0, type, GL_UNSIGNED_BYTE, _data);
+		glTexImage2D(GL_TEXTURE_2D, 0, type, _width, _height, 0, type, convertTextureDataType(_type), _data);
 
 		return texture;
 
@@ -125,99 +198,84 @@ namespace Renderer
 
 	void destroyTexture(const unsigned int _texture)
 	{
+		// The batch may use it
+		flush();
 		glDeleteTextures(1, &_texture);
 
+		if (_texture == boundTexture)
+			boundTexture = UNKNOWN_TEXTURE;
+
 	} // destroyTexture
 
 	void updateTexture(const unsigned int _texture, const Texture::Type _type, const unsigned int _x, const unsigned _y, const unsigned int _width, const unsigned int _height, void* _data)
 	{
-		bindTexture(_texture);
+		// The batch may use the previous content
+		flush();
+		applyTexture(_texture);
 
 		if (_x == -1 && _y == -1)
 		{
 			const GLenum type = convertTextureType(_type);
-			glTexImage2D(GL_TEXTURE_2D, 0, type, _width, _height, 0, type, GL_UNSIGNED_BYTE, _data);
+			glTexImage2D(GL_TEXTURE_2D, 0, type, _width, _height, 0, type, convertTextureDataType(_type), _data);
 		}
 		else
-			glTexSubImage2D(GL_TEXTURE_2D, 0, _x, _y, _width, _height, convertTextureType(_type), GL_UNSIGNED_BYTE, _data);
-
-		bindTexture(0);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, _x, _y, _width, _height, convertTextureType(_type), convertTextureDataType(_type), _data);
 
 	} // updateTexture
 
-	void bindTexture(const unsigned int _texture)
+	void applyTexture(const unsigned int _texture)
 	{
+		if (_texture == boundTexture)
+			return;
+
 		glBindTexture(GL_TEXTURE_2D, _texture);
 
 		if(_texture == 0) glDisable(GL_TEXTURE_2D);
 		else              glEnable(GL_TEXTURE_2D);
 
-	} // bindTexture
+		boundTexture = _texture;
+		getStatistics().stateChanges++;
+
+	} // applyTexture
 
 	void drawLines(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
 	{
-		glEnable(GL_BLEND);
-		glBlendFunc(convertBlendFactor(_srcBlendFactor), convertBlendFactor(_dstBlendFactor));
-
-		glEnableClientState(GL_VERTEX_ARRAY);
-		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-		glEnableClientState(GL_COLOR_ARRAY);
-
-		glVertexPointer(  2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].pos);
-		glTexCoordPointer(2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].tex);
-		glColorPointer(   4, GL_UNSIGNED_BYTE, sizeof(Vertex), &_vertices[0].col);
+		beginImmediateDraw();
+		setDrawState(_vertices, _srcBlendFactor, _dstBlendFactor);
 
 		glDrawArrays(GL_LINES, 0, _numVertices);
-
-		glDisableClientState(GL_COLOR_ARRAY);
-		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-		glDisableClientState(GL_VERTEX_ARRAY);
-
-		glDisable(GL_BLEND);
+		getStatistics().drawCalls++;
 
 	} // drawLines
 
-	void drawTriangleStrips(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
+	void drawTriangles(const Vertex* _vertices, const unsigned short* _indices, const unsigned int _numIndices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
 	{
-		glEnable(GL_BLEND);
-		glBlendFunc(convertBlendFactor(_srcBlendFactor), convertBlendFactor(_dstBlendFactor));
-
-		glEnableClientState(GL_VERTEX_ARRAY);
-		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-		glEnableClientState(GL_COLOR_ARRAY);
+		setDrawState(_vertices, _srcBlendFactor, _dstBlendFactor);
 
-		glVertexPointer(  2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].pos);
-		glTexCoordPointer(2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].tex);
-		glColorPointer(   4, GL_UNSIGNED_BYTE, sizeof(Vertex), &_vertices[0].col);
-
-		glDrawArrays(GL_TRIANGLE_STRIP, 0, _numVertices);
+		glDrawElements(GL_TRIANGLES, _numIndices, GL_UNSIGNED_SHORT, _indices);
 
-		glDisableClientState(GL_COLOR_ARRAY);
-		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-		glDisableClientState(GL_VERTEX_ARRAY);
-
-		glDisable(GL_BLEND);
-
-	} // drawTriangleStrips
+	} // drawTriangles
 
 	void setProjection(const Transform4x4f& _projection)
 	{
+		flush();
+
 		glMatrixMode(GL_PROJECTION);
 		glLoadMatrixf((GLfloat*)&_projection);
 
 	} // setProjection
 
-	void setMatrix(const Transform4x4f& _matrix)
+	void loadMatrix(const Transform4x4f& _matrix)
 	{
-		Transform4x4f matrix = _matrix;
-		matrix.round();
 		glMatrixMode(GL_MODELVIEW);
-		glLoadMatrixf((GLfloat*)&matrix);
+		glLoadMatrixf((GLfloat*)&_matrix);
 
-	} // setMatrix
+	} // loadMatrix
 
 	void setViewport(const Rect& _viewport)
 	{
+		flush();
+
 		// glViewport starts at the bottom left of the window
 		glViewport( _viewport.x, getWindowHeight() - _viewport.y - _viewport.h, _viewport.w, _viewport.h);
 
@@ -225,6 +283,8 @@ namespace Renderer
 
 	void setScissor(const Rect& _scissor)
 	{
+		flush();
+
 		if((_scissor.x == 0) && (_scissor.y == 0) && (_scissor.w == 0) && (_scissor.h == 0))
 		{
 			glDisable(GL_SCISSOR_TEST);
@@ -259,6 +319,8 @@ namespace Renderer
 
 	void swapBuffers()
 	{
+		endFrame();
+
 #ifdef WIN32		
 		glFlush();
 		glFinish();
@@ -321,36 +383,24 @@ namespace Renderer
 			vxs[i] = vertex[i];
 
 		bindTexture(0);
+		beginImmediateDraw();
 
 		glEnable(GL_MULTISAMPLE);
 
-		glEnable(GL_BLEND);
-		glBlendFunc(convertBlendFactor(_srcBlendFactor), convertBlendFactor(_dstBlendFactor));
-
-		glEnableClientState(GL_VERTEX_ARRAY);
-		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-		glEnableClientState(GL_COLOR_ARRAY);
-
-		glVertexPointer(2, GL_FLOAT, sizeof(Vertex), &vxs[0].pos);
-		glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), &vxs[0].tex);
-		glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Vertex), &vxs[0].col);
+		setDrawState(vxs, _srcBlendFactor, _dstBlendFactor);
 
 		glDrawArrays(GL_TRIANGLE_FAN, 0, vertex.size());
-
-		glDisableClientState(GL_COLOR_ARRAY);
-		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-		glDisableClientState(GL_VERTEX_ARRAY);
+		getStatistics().drawCalls++;
 
 		delete[] vxs;
 
-		glDisable(GL_BLEND);
 		glDisable(GL_MULTISAMPLE);
 	}
 
 	void enableRoundCornerStencil(float x, float y, float width, float height, float radius)
 	{
-		bool tx = glIsEnabled(GL_TEXTURE_2D);
-		glDisable(GL_TEXTURE_2D);
+		// What's already batched is not masked. The mask is drawn untextured : the caller binds its texture again.
+		flush();
 
 		glClear(GL_DEPTH_BUFFER_BIT);
 		glEnable(GL_STENCIL_TEST);
@@ -369,13 +419,12 @@ namespace Renderer
 		glStencilMask(0x00);
 		glStencilFunc(GL_EQUAL, 0, 0xFF);
 		glStencilFunc(GL_EQUAL, 1, 0xFF);
-
-		if (tx)
-			glEnable(GL_TEXTURE_2D);
 	}
 
 	void disableStencil()
 	{
+		// What's batched is masked
+		flush();
 		glDisable(GL_STENCIL_TEST);
 	}
 
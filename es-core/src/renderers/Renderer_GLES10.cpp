@@ -12,6 +12,12 @@
 #include <vector>
 #include <unistd.h>
 #include <fcntl.h>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <string.h>
 
 #include <go2/display.h>
 #include <go2/input.h>
@@ -36,6 +42,220 @@ namespace Renderer
 	static go2_context_t* context = nullptr;
 	static go2_presenter_t* presenter = nullptr;
 
+	// Titlebar status, sampled by a background thread. The icon indexes are packed in a single word so the
+	// render thread only does one atomic load per frame and recomposes the titlebar when something changed.
+	enum TitlebarStatusBits
+	{
+		STATUS_BATTERY_SHIFT = 0,
+		STATUS_VOLUME_SHIFT = 8,
+		STATUS_BRIGHTNESS_SHIFT = 16,
+		STATUS_WIFI_SHIFT = 24,
+		STATUS_POWER_SHIFT = 25
+	};
+
+	#define STATUS_SAMPLE_INTERVAL	200 // ms, volume & brightness
+	#define STATUS_SLOW_SAMPLE_TICKS	10 // battery, wifi & power are sampled every 2s
+
+	static std::atomic<unsigned int> titlebarStatus(0);
+	static unsigned int drawnTitlebarStatus = 0xFFFFFFFF; // never a valid status
+
+	static std::thread* statusThread = nullptr;
+	static std::mutex statusLock;
+	static std::condition_variable statusCondition;
+	static bool statusRunning = false;
+	static std::function<void()> statusChanged; // wakes the idle main loop, the titlebar is only redrawn by swapBuffers()
+
+	static int readSysfsInt(const char* path, int defaultValue)
+	{
+		int fd = open(path, O_RDONLY);
+		if (fd <= 0)
+			return defaultValue;
+
+		char buffer[10];
+		memset(buffer, 0, 10);
+
+		int value = defaultValue;
+		if (read(fd, buffer, 9) > 0)
+			value = atoi(buffer);
+
+		close(fd);
+		return value;
+	}
+
+	static bool readSysfsContains(const char* path, const char* text)
+	{
+		int fd = open(path, O_RDONLY);
+		if (fd <= 0)
+			return false;
+
+		char buffer[10];
+		memset(buffer, 0, 10);
+
+		bool ret = read(fd, buffer, 9) > 0 && strstr(buffer, text) != NULL;
+
+		close(fd);
+		return ret;
+	}
+
+	// 0 -> 0, 1..5 -> 1, 6..10 -> 2 ... 96..100 -> 20
+	static int getLevelIconIndex(int value)
+	{
+		if (value <= 0)
+			return 0;
+
+		if (value >= 100)
+			return 20;
+
+		return (value + 4) / 5;
+	}
+
+	static unsigned int sampleTitlebarStatus(unsigned int previous, bool slow)
+	{
+		unsigned int status = previous;
+
+		if (slow)
+		{
+			int capacity = readSysfsInt(Utils::FileSystem::exists("/tmp/battery.percent") ? "/tmp/battery.percent" : "/sys/class/power_supply/battery/capacity", 0);
+			int batteryIndex = (capacity == 1 ? 0 : std::max(1, getLevelIconIndex(capacity)));
+
+			bool wifi = readSysfsContains("/sys/class/net/wlan0/operstate", "up");
+			bool power = readSysfsContains("/sys/class/power_supply/ac/online", "1");
+
+			status &= ~((0xFFu << STATUS_BATTERY_SHIFT) | (1u << STATUS_WIFI_SHIFT) | (1u << STATUS_POWER_SHIFT));
+			status |= (batteryIndex << STATUS_BATTERY_SHIFT);
+			status |= (wifi ? 1u : 0u) << STATUS_WIFI_SHIFT;
+			status |= (power ? 1u : 0u) << STATUS_POWER_SHIFT;
+		}
+
+		uint32_t volume = go2_audio_volume_get(NULL);
+		int brightness = readSysfsInt("/sys/class/backlight/backlight/brightness", 0) * 100 / 255;
+
+		status &= ~((0xFFu << STATUS_VOLUME_SHIFT) | (0xFFu << STATUS_BRIGHTNESS_SHIFT));
+		status |= (getLevelIconIndex((int)std::min(volume, (uint32_t)100)) << STATUS_VOLUME_SHIFT);
+		status |= (getLevelIconIndex(brightness) << STATUS_BRIGHTNESS_SHIFT);
+
+		return status;
+	}
+
+	static void statusSamplerLoop()
+	{
+		unsigned int status = titlebarStatus.load();
+
+		for (int tick = 1; ; tick++)
+		{
+			{
+				std::unique_lock<std::mutex> lock(statusLock);
+				statusCondition.wait_for(lock, std::chrono::milliseconds(STATUS_SAMPLE_INTERVAL), [] { return !statusRunning; });
+				if (!statusRunning)
+					return;
+			}
+
+			unsigned int previous = status;
+			status = sampleTitlebarStatus(status, (tick % STATUS_SLOW_SAMPLE_TICKS) == 0);
+			titlebarStatus.store(status);
+
+			if (status == previous)
+				continue;
+
+			std::function<void()> callback;
+			{
+				std::unique_lock<std::mutex> lock(statusLock);
+				callback = statusChanged;
+			}
+
+			if (callback)
+				callback();
+		}
+	}
+
+	static void startStatusSampler()
+	{
+		// First sample on the calling thread, so the first frame already shows the right icons
+		titlebarStatus.store(sampleTitlebarStatus(0, true));
+		drawnTitlebarStatus = 0xFFFFFFFF;
+
+		statusRunning = true;
+		statusThread = new std::thread(&statusSamplerLoop);
+	}
+
+	static void stopStatusSampler()
+	{
+		if (statusThread == nullptr)
+			return;
+
+		{
+			std::unique_lock<std::mutex> lock(statusLock);
+			statusRunning = false;
+		}
+
+		statusCondition.notify_all();
+		statusThread->join();
+
+		delete statusThread;
+		statusThread = nullptr;
+	}
+
+	// Copies a 16px high icon strip from 'pixels' (RGB565, 'width' px wide) to the titlebar
+	static void drawTitlebarImage(const uint8_t* pixels, int width, int index, int x)
+	{
+		const uint8_t* src = pixels;
+		int src_stride = width * sizeof(short);
+
+		uint8_t* dst = (uint8_t*)go2_surface_map(titlebarSurface);
+		int dst_stride = go2_surface_stride_get(titlebarSurface);
+
+		src += (index * 16 * src_stride);
+		dst += x * sizeof(short);
+
+		for (int y = 0; y < 16; ++y)
+		{
+			memcpy(dst, src, src_stride);
+
+			src += src_stride;
+			dst += dst_stride;
+		}
+	}
+
+	static void updateTitlebar(int w)
+	{
+		unsigned int status = titlebarStatus.load();
+		if (status == drawnTitlebarStatus)
+			return;
+
+		bool full = (drawnTitlebarStatus == 0xFFFFFFFF);
+		unsigned int changed = status ^ drawnTitlebarStatus;
+
+		if (full)
+			drawTitlebarImage(header.pixel_data, header.width, 0, (w / 2) - (header.width / 2));
+
+		if (full || (changed & (0xFFu << STATUS_VOLUME_SHIFT)))
+			drawTitlebarImage(volume_image.pixel_data, 32, (status >> STATUS_VOLUME_SHIFT) & 0xFF, 0);
+
+		if (full || (changed & (0xFFu << STATUS_BRIGHTNESS_SHIFT)))
+			drawTitlebarImage(brightness_image.pixel_data, 32, (status >> STATUS_BRIGHTNESS_SHIFT) & 0xFF, 64);
+
+		if (full || (changed & (1u << STATUS_WIFI_SHIFT)))
+		{
+			if (status & (1u << STATUS_WIFI_SHIFT))
+				drawTitlebarImage(wifi_image.pixel_data, 32, 1, w - 100);
+			else
+				drawTitlebarImage(blank_image.pixel_data, 32, 1, w - 100);
+		}
+
+		if (full || (changed & (1u << STATUS_POWER_SHIFT)))
+		{
+			if (status & (1u << STATUS_POWER_SHIFT))
+				drawTitlebarImage(power_image.pixel_data, 32, 1, w - 65);
+			else
+				drawTitlebarImage(blank_image.pixel_data, 32, 1, w - 65);
+		}
+
+		if (full || (changed & (0xFFu << STATUS_BATTERY_SHIFT)))
+			drawTitlebarImage(battery_image.pixel_data, 32, (status >> STATUS_BATTERY_SHIFT) & 0xFF, w - 32);
+
+		drawnTitlebarStatus = status;
+	}
+
 	static GLenum convertBlendFactor(const Blend::Factor _blendFactor)
 	{
 		switch(_blendFactor)
@@ -59,13 +279,68 @@ namespace Renderer
 	{
 		switch(_type)
 		{
-			case Texture::RGBA:  { return GL_RGBA;  } break;
-			case Texture::ALPHA: { return GL_ALPHA; } break;
-			default:             { return GL_ZERO;  }
+			case Texture::RGBA:   { return GL_RGBA;  } break;
+			case Texture::ALPHA:  { return GL_ALPHA; } break;
+			case Texture::RGB565: { return GL_RGB;   } break;
+			default:              { return GL_ZERO;  }
 		}
 
 	} // convertTextureType
 
+	static GLenum convertTextureDataType(const Texture::Type _type)
+	{
+		switch(_type)
+		{
+			case Texture::RGB565: { return GL_UNSIGNED_SHORT_5_6_5; } break;
+			default:              { return GL_UNSIGNED_BYTE;        }
+		}
+
+	} // convertTextureDataType
+
+	// GL state, to skip the redundant changes. Blending and the vertex arrays stay enabled : every draw uses them.
+	#define UNKNOWN_TEXTURE 0xFFFFFFFF
+
+	static unsigned int boundTexture     = UNKNOWN_TEXTURE;
+	static bool         drawStateEnabled = false;
+	static GLenum       srcBlendFactor   = GL_ZERO;
+	static GLenum       dstBlendFactor   = GL_ZERO;
+
+	static void resetState()
+	{
+		boundTexture     = UNKNOWN_TEXTURE;
+		drawStateEnabled = false;
+		srcBlendFactor   = GL_ZERO;
+		dstBlendFactor   = GL_ZERO;
+
+	} // resetState
+
+	static void setDrawState(const Vertex* _vertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
+	{
+		if (!drawStateEnabled)
+		{
+			glEnable(GL_BLEND);
+			glEnableClientState(GL_VERTEX_ARRAY);
+			glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+			glEnableClientState(GL_COLOR_ARRAY);
+			drawStateEnabled = true;
+		}
+
+		const GLenum src = convertBlendFactor(_srcBlendFactor);
+		const GLenum dst = convertBlendFactor(_dstBlendFactor);
+		if (src != srcBlendFactor || dst != dstBlendFactor)
+		{
+			glBlendFunc(src, dst);
+			srcBlendFactor = src;
+			dstBlendFactor = dst;
+			getStatistics().stateChanges++;
+		}
+
+		glVertexPointer(  2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].pos);
+		glTexCoordPointer(2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].tex);
+		glColorPointer(   4, GL_UNSIGNED_BYTE, sizeof(Vertex), &_vertices[0].col);
+
+	} // setDrawState
+
 	unsigned int convertColor(const unsigned int _color)
 	{
 		// convert from rgba to abgr
@@ -84,6 +359,20 @@ namespace Renderer
 
 	} // getWindowFlags
 
+	unsigned int getDisplayBitsPerPixel()
+	{
+		// The go2 presenter scans out RGB565
+		return 16;
+
+	} // getDisplayBitsPerPixel
+
+	void setStatusChangedCallback(const std::function<void()>& _callback)
+	{
+		std::unique_lock<std::mutex> lock(statusLock);
+		statusChanged = _callback;
+
+	} // setStatusChangedCallback
+
 	void setupWindow()
 	{
 #if 0
@@ -119,6 +408,7 @@ namespace Renderer
 		int h = go2_display_width_get(display);
 
 		titlebarSurface = go2_surface_create(display, w, 16, DRM_FORMAT_RGB565);
+		startStatusSampler();
 
 		context = go2_context_create(display, w, h, &attr);
 		go2_context_make_current(context);
@@ -126,6 +416,7 @@ namespace Renderer
 		presenter = go2_presenter_create(display, DRM_FORMAT_RGB565, 0xff080808);
 
 		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+		resetState();
 
 		std::string glExts = (const char*)glGetString(GL_EXTENSIONS);
 		LOG(LogInfo) << "Checking available OpenGL extensions...";
@@ -137,6 +428,8 @@ namespace Renderer
 	{
 		//SDL_GL_DeleteContext(sdlContext);
 		//sdlContext = nullptr;
+		stopStatusSampler();
+
 		go2_context_destroy(context);
 		context = nullptr;
 
@@ -156,7 +449,7 @@ namespace Renderer
 		unsigned int texture;
 
 		glGenTextures(1, &texture);
-		bindTexture(texture);
+		applyTexture(texture);
 
 		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, _repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE);
 		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, _repeat ? GL_REPEAT : GL_CLAMP_TO_EDGE);
@@ -167,7 +460,7 @@ namespace Renderer
 		glPixelStorei(GL_PACK_ALIGNMENT, 1);
 		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-		glTexImage2D(GL_TEXTURE_2D, 0, type, _width, _height, 0, type, GL_UNSIGNED_BYTE, _data);
+		glTexImage2D(GL_TEXTURE_2D, 0, type, _width, _height, 0, type, convertTextureDataType(_type), _data);
 
 		return texture;
 
@@ -175,99 +468,84 @@ namespace Renderer
 
 	void destroyTexture(const unsigned int _texture)
 	{
+		// The batch may use it
+		flush();
 		glDeleteTextures(1, &_texture);
 
+		if (_texture == boundTexture)
+			boundTexture = UNKNOWN_TEXTURE;
+
 	} // destroyTexture
 
 	void updateTexture(const unsigned int _texture, const Texture::Type _type, const unsigned int _x, const unsigned _y, const unsigned int _width, const unsigned int _height, void* _data)
 	{
-		bindTexture(_texture);
+		// The batch may use the previous content
+		flush();
+		applyTexture(_texture);
 
 		if (_x == -1 && _y == -1)
 		{
 			const GLenum type = convertTextureType(_type);
-			glTexImage2D(GL_TEXTURE_2D, 0, type, _width, _height, 0, type, GL_UNSIGNED_BYTE, _data);
+			glTexImage2D(GL_TEXTURE_2D, 0, type, _width, _height, 0, type, convertTextureDataType(_type), _data);
 		}
 		else
-			glTexSubImage2D(GL_TEXTURE_2D, 0, _x, _y, _width, _height, convertTextureType(_type), GL_UNSIGNED_BYTE, _data);
-
-		bindTexture(0);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, _x, _y, _width, _height, convertTextureType(_type), convertTextureDataType(_type), _data);
 
 	} // updateTexture
 
-	void bindTexture(const unsigned int _texture)
+	void applyTexture(const unsigned int _texture)
 	{
+		if (_texture == boundTexture)
+			return;
+
 		glBindTexture(GL_TEXTURE_2D, _texture);
 
 		if(_texture == 0) glDisable(GL_TEXTURE_2D);
 		else              glEnable(GL_TEXTURE_2D);
 
-	} // bindTexture
+		boundTexture = _texture;
+		getStatistics().stateChanges++;
+
+	} // applyTexture
 
 	void drawLines(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
 	{
-		glEnable(GL_BLEND);
-		glBlendFunc(convertBlendFactor(_srcBlendFactor), convertBlendFactor(_dstBlendFactor));
-
-		glEnableClientState(GL_VERTEX_ARRAY);
-		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-		glEnableClientState(GL_COLOR_ARRAY);
-
-		glVertexPointer(  2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].pos);
-		glTexCoordPointer(2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].tex);
-		glColorPointer(   4, GL_UNSIGNED_BYTE, sizeof(Vertex), &_vertices[0].col);
+		beginImmediateDraw();
+		setDrawState(_vertices, _srcBlendFactor, _dstBlendFactor);
 
 		glDrawArrays(GL_LINES, 0, _numVertices);
-
-		glDisableClientState(GL_COLOR_ARRAY);
-		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-		glDisableClientState(GL_VERTEX_ARRAY);
-
-		glDisable(GL_BLEND);
+		getStatistics().drawCalls++;
 
 	} // drawLines
 
-	void drawTriangleStrips(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
+	void drawTriangles(const Vertex* _vertices, const unsigned short* _indices, const unsigned int _numIndices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
 	{
-		glEnable(GL_BLEND);
-		glBlendFunc(convertBlendFactor(_srcBlendFactor), convertBlendFactor(_dstBlendFactor));
-
-		glEnableClientState(GL_VERTEX_ARRAY);
-		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-		glEnableClientState(GL_COLOR_ARRAY);
-
-		glVertexPointer(  2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].pos);
-		glTexCoordPointer(2, GL_FLOAT,         sizeof(Vertex), &_vertices[0].tex);
-		glColorPointer(   4, GL_UNSIGNED_BYTE, sizeof(Vertex), &_vertices[0].col);
-
-		glDrawArrays(GL_TRIANGLE_STRIP, 0, _numVertices);
+		setDrawState(_vertices, _srcBlendFactor, _dstBlendFactor);
 
-		glDisableClientState(GL_COLOR_ARRAY);
-		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-		glDisableClientState(GL_VERTEX_ARRAY);
+		glDrawElements(GL_TRIANGLES, _numIndices, GL_UNSIGNED_SHORT, _indices);
 
-		glDisable(GL_BLEND);
-
-	} // drawTriangleStrips
+	} // drawTriangles
 
 	void setProjection(const Transform4x4f& _projection)
 	{
+		flush();
+
 		glMatrixMode(GL_PROJECTION);
 		glLoadMatrixf((GLfloat*)&_projection);
 
 	} // setProjection
 
-	void setMatrix(const Transform4x4f& _matrix)
+	void loadMatrix(const Transform4x4f& _matrix)
 	{
-		Transform4x4f matrix = _matrix;
-		matrix.round();
 		glMatrixMode(GL_MODELVIEW);
-		glLoadMatrixf((GLfloat*)&matrix);
+		glLoadMatrixf((GLfloat*)&_matrix);
 
-	} // setMatrix
+	} // loadMatrix
 
 	void setViewport(const Rect& _viewport)
 	{
+		flush();
+
 		// glViewport starts at the bottom left of the window
 		glViewport( _viewport.x, getWindowHeight() - _viewport.y - _viewport.h, _viewport.w, _viewport.h);
 
@@ -275,6 +553,8 @@ namespace Renderer
 
 	void setScissor(const Rect& _scissor)
 	{
+		flush();
+
 		if((_scissor.x == 0) && (_scissor.y == 0) && (_scissor.w == 0) && (_scissor.h == 0))
 		{
 			glDisable(GL_SCISSOR_TEST);
@@ -310,6 +590,8 @@ namespace Renderer
 
 	void swapBuffers()
 	{
+		endFrame();
+
 #ifdef WIN32		
 		glFlush();
 		glFinish();
@@ -324,509 +606,7 @@ namespace Renderer
 			int w = go2_display_height_get(display);
 			int h = go2_display_width_get(display);
 
-			{
-				// Battery level
-				const uint8_t* src = battery_image.pixel_data;
-				int src_stride = 32 * sizeof(short);
-
-				uint8_t* dst = (uint8_t*)go2_surface_map(titlebarSurface);
-				int dst_stride = go2_surface_stride_get(titlebarSurface);
-
-				int batcapacity = 0;
-				int fd;
-				char buffer[10];
-				if ( Utils::FileSystem::exists("/tmp/battery.percent") ) {
-				  fd = open("/tmp/battery.percent", O_RDONLY);
-				} else {
-				  fd = open("/sys/class/power_supply/battery/capacity", O_RDONLY);
-				}
-				if (fd > 0)
-				{
-					memset(buffer, 0, 10);
-					ssize_t count = read(fd, buffer, 10);
-					if( count > 0 )
-					{
-						batcapacity = atoi(buffer);
-					}
-					close(fd);
-				}
-
-				int batteryIndex;
-				if (batcapacity == 1)
-				{
-					batteryIndex = 0;
-				}
-				else if (batcapacity <= 5)
-				{
-					batteryIndex = 1;
-				}
-				else if (batcapacity <= 10)
-				{
-					batteryIndex = 2;
-				}
-				else if (batcapacity <= 15)
-				{
-					batteryIndex = 3;
-				}
-				else if (batcapacity <= 20)
-				{
-					batteryIndex = 4;
-				}
-				else if (batcapacity <= 25)
-				{
-					batteryIndex = 5;
-				}
-				else if (batcapacity <= 30)
-				{
-					batteryIndex = 6;
-				}
-				else if (batcapacity <= 35)
-				{
-					batteryIndex = 7;
-				}
-				else if (batcapacity <= 40)
-				{
-					batteryIndex = 8;
-				}
-				else if (batcapacity <= 45)
-				{
-					batteryIndex = 9;
-				}
-				else if (batcapacity <= 50)
-				{
-					batteryIndex = 10;
-				}
-				else if (batcapacity <= 55)
-				{
-					batteryIndex = 11;
-				}
-				else if (batcapacity <= 60)
-				{
-					batteryIndex = 12;
-				}
-				else if (batcapacity <= 65)
-				{
-					batteryIndex = 13;
-				}
-				else if (batcapacity <= 70)
-				{
-					batteryIndex = 14;
-				}
-				else if (batcapacity <= 75)
-				{
-					batteryIndex = 15;
-				}
-				else if (batcapacity <= 80)
-				{
-					batteryIndex = 16;
-				}
-				else if (batcapacity <= 85)
-				{
-					batteryIndex = 17;
-				}
-				else if (batcapacity <= 90)
-				{
-					batteryIndex = 18;
-				}
-				else if (batcapacity <= 95)
-				{
-					batteryIndex = 19;
-				}
-				else if (batcapacity == 100)
-				{
-					batteryIndex = 20;
-				}				
-				else
-				{
-					batteryIndex = 20;
-				}
-
-				src += (batteryIndex * 16 * src_stride);
-				dst += (w - 32) * sizeof(short);
-
-				for (int y = 0; y < 16; ++y)
-				{
-					memcpy(dst, src, 32 * sizeof(short));
-
-					src += src_stride;
-					dst += dst_stride;
-				}
-			}
-
-			{
-				// Volume level
-				const uint8_t* src = volume_image.pixel_data;
-				int src_stride = 32 * sizeof(short);
-
-				uint8_t* dst = (uint8_t*)go2_surface_map(titlebarSurface);
-				int dst_stride = go2_surface_stride_get(titlebarSurface);
-
-				uint32_t volume = go2_audio_volume_get(NULL);
-
-				int volumeIndex;
-				if (volume == 0)
-				{
-					volumeIndex = 0;
-				}
-				else if (volume <= 5)
-				{
-					volumeIndex = 1;
-				}
-				else if (volume <= 10)
-				{
-					volumeIndex = 2;
-				}
-				else if (volume <= 15)
-				{
-					volumeIndex = 3;
-				}
-				else if (volume <= 20)
-				{
-					volumeIndex = 4;
-				}
-				else if (volume <= 25)
-				{
-					volumeIndex = 5;
-				}
-				else if (volume <= 30)
-				{
-					volumeIndex = 6;
-				}
-				else if (volume <= 35)
-				{
-					volumeIndex = 7;
-				}
-				else if (volume <= 40)
-				{
-					volumeIndex = 8;
-				}
-				else if (volume <= 45)
-				{
-					volumeIndex = 9;
-				}
-				else if (volume <= 50)
-				{
-					volumeIndex = 10;
-				}
-				else if (volume <= 55)
-				{
-					volumeIndex = 11;
-				}
-				else if (volume <= 60)
-				{
-					volumeIndex = 12;
-				}
-				else if (volume <= 65)
-				{
-					volumeIndex = 13;
-				}
-				else if (volume <= 70)
-				{
-					volumeIndex = 14;
-				}
-				else if (volume <= 75)
-				{
-					volumeIndex = 15;
-				}
-				else if (volume <= 80)
-				{
-					volumeIndex = 16;
-				}
-				else if (volume <= 85)
-				{
-					volumeIndex = 17;
-				}
-				else if (volume <= 90)
-				{
-					volumeIndex = 18;
-				}
-				else if (volume <= 95)
-				{
-					volumeIndex = 19;
-				}
-				else if (volume = 100)
-				{
-					volumeIndex = 20;
-				}
-				else
-				{
-					volumeIndex = 20;
-				}
-
-				src += (volumeIndex * 16 * src_stride);
-				//dst += (480 - 32) * sizeof(short);
-
-				for (int y = 0; y < 16; ++y)
-				{
-					memcpy(dst, src, 32 * sizeof(short));
-
-					src += src_stride;
-					dst += dst_stride;
-				}
-			}
-			{
-				// Title
-				const uint8_t* src = header.pixel_data;
-				int src_stride = header.width * sizeof(short);
-
-				uint8_t* dst = (uint8_t*)go2_surface_map(titlebarSurface);
-				int dst_stride = go2_surface_stride_get(titlebarSurface);
-
-				dst += ((w / 2) - (header.width / 2)) * sizeof(short);
-
-				for (int y = 0; y < 16; ++y)
-				{
-					memcpy(dst, src, src_stride);
-
-					src += src_stride;
-					dst += dst_stride;
-				}
-			}
-			{
-				// Brightness level
-				const uint8_t* src = brightness_image.pixel_data;
-				int src_stride = 32 * sizeof(short);
-
-				uint8_t* dst = (uint8_t*)go2_surface_map(titlebarSurface);
-				int dst_stride = go2_surface_stride_get(titlebarSurface);
-
-				int brightnessIndex = 0;
-				int brightness = 0;
-				int fd;
-				char buffer[10];
-				fd = open("/sys/class/backlight/backlight/brightness", O_RDONLY);
-				if (fd > 0)
-				{
-					memset(buffer, 0, 10);
-					ssize_t count = read(fd, buffer, 10);
-					if( count > 0 )
-					{
-						brightness = atoi(buffer);
-						brightness = brightness*100/255;
-					}
-					close(fd);
-				}
-
-
-				if (brightness == 0)
-				{
-					brightnessIndex = 0;
-				}
-				else if (brightness <= 5)
-				{
-					brightnessIndex = 1;
-				}
-				else if (brightness <= 10)
-				{
-					brightnessIndex = 2;
-				}
-				else if (brightness <= 15)
-				{
-					brightnessIndex = 3;
-				}
-				else if (brightness <= 20)
-				{
-					brightnessIndex = 4;
-				}
-				else if (brightness <= 25)
-				{
-					brightnessIndex = 5;
-				}
-				else if (brightness <= 30)
-				{
-					brightnessIndex = 6;
-				}
-				else if (brightness <= 35)
-				{
-					brightnessIndex = 7;
-				}
-				else if (brightness <= 40)
-				{
-					brightnessIndex = 8;
-				}
-				else if (brightness <= 45)
-				{
-					brightnessIndex = 9;
-				}
-				else if (brightness <= 50)
-				{
-					brightnessIndex = 10;
-				}
-				else if (brightness <= 55)
-				{
-					brightnessIndex = 11;
-				}
-				else if (brightness <= 60)
-				{
-					brightnessIndex = 12;
-				}
-				else if (brightness <= 65)
-				{
-					brightnessIndex = 13;
-				}
-				else if (brightness <= 70)
-				{
-					brightnessIndex = 14;
-				}
-				else if (brightness <= 75)
-				{
-					brightnessIndex = 15;
-				}
-				else if (brightness <= 80)
-				{
-					brightnessIndex = 16;
-				}
-				else if (brightness <= 85)
-				{
-					brightnessIndex = 17;
-				}
-				else if (brightness <= 90)
-				{
-					brightnessIndex = 18;
-				}
-				else if (brightness <= 95)
-				{
-					brightnessIndex = 19;
-				}
-				else if (brightness = 100)
-				{
-					brightnessIndex = 20;
-				}
-				else
-				{
-					brightnessIndex = 20;
-				}
-				
-				src += (brightnessIndex * 16 * src_stride);
-				dst += (64) * sizeof(short);
-
-				for (int y = 0; y < 16; ++y)
-				{
-					memcpy(dst, src, 32 * sizeof(short));
-
-					src += src_stride;
-					dst += dst_stride;
-				}
-			}
-
-			{
-				
-				// WIFI ICONS
-				const uint8_t* src = wifi_image.pixel_data;
-				int src_stride = 32 * sizeof(short);
-
-				uint8_t* dst = (uint8_t*)go2_surface_map(titlebarSurface);
-				int dst_stride = go2_surface_stride_get(titlebarSurface);
-
-				int wifiIndex = 0;
-
-				// Wifi
-				int fd;
-				char buffer[10];
-				fd = open("/sys/class/net/wlan0/operstate", O_RDONLY);
-				if (fd > 0)
-				{
-					memset(buffer, 0, 10);
-					ssize_t count = read(fd, buffer, 10);
-					if( count > 0 )
-					{
-						if( strstr( buffer, "up") != NULL )
-							wifiIndex = 1;
-						else
-							wifiIndex = 0;
-					}
-					close(fd);
-				}
-				if( wifiIndex == 1 )
-				{
-					src += (wifiIndex* 16 * src_stride);
-					dst += (w - 100) * sizeof(short);
-
-					for (int y = 0; y < 16; ++y)
-					{
-						memcpy(dst, src, 32 * sizeof(short));
-
-						src += src_stride;
-						dst += dst_stride;
-					}
-
-				}
-				else
-				{
-					const uint8_t* src = blank_image.pixel_data;
-					src += (1 * 16 * src_stride);
-					dst += (w - 100) * sizeof(short);
-
-					for (int y = 0; y < 16; ++y)
-					{
-						memcpy(dst, src, 32 * sizeof(short));
-
-						src += src_stride;
-						dst += dst_stride;
-					}
-
-				}
-			}
-
-			{
-				
-				// POWER ICON
-				const uint8_t* src = power_image.pixel_data;
-				int src_stride = 32 * sizeof(short);
-
-				uint8_t* dst = (uint8_t*)go2_surface_map(titlebarSurface);
-				int dst_stride = go2_surface_stride_get(titlebarSurface);
-
-				int powerIndex = 0;
-
-				// Power
-				int fd;
-				char buffer[10];
-				fd = open("/sys/class/power_supply/ac/online", O_RDONLY);
-				if (fd > 0)
-				{
-					memset(buffer, 0, 10);
-					ssize_t count = read(fd, buffer, 10);
-					if( count > 0 )
-					{
-						if( strstr( buffer, "1") != 0 )
-							powerIndex = 1;
-						else
-							powerIndex = 0;
-					}
-					close(fd);
-				}
-				if( powerIndex == 1 )
-				{
-					src += (powerIndex * 16 * src_stride);
-					dst += (w - 65) * sizeof(short);
-
-					for (int y = 0; y < 16; ++y)
-					{
-						memcpy(dst, src, 32 * sizeof(short));
-
-						src += src_stride;
-						dst += dst_stride;
-					}
-
-				}
-				else
-				{
-					const uint8_t* src = blank_image.pixel_data;
-					src += (1 * 16 * src_stride);
-					dst += (w - 65) * sizeof(short);
-
-					for (int y = 0; y < 16; ++y)
-					{
-						memcpy(dst, src, 32 * sizeof(short));
-
-						src += src_stride;
-						dst += dst_stride;
-					}
-
-				}
-
-			}
+			updateTitlebar(w);
 
 			go2_context_swap_buffers(context);
 			go2_surface_t* surface = go2_context_surface_lock(context);
@@ -897,32 +677,20 @@ namespace Renderer
 			vxs[i] = vertex[i];
 
 		bindTexture(0);
+		beginImmediateDraw();
 
-		glEnable(GL_BLEND);
-		glBlendFunc(convertBlendFactor(_srcBlendFactor), convertBlendFactor(_dstBlendFactor));
-
-		glEnableClientState(GL_VERTEX_ARRAY);
-		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-		glEnableClientState(GL_COLOR_ARRAY);
-
-		glVertexPointer(2, GL_FLOAT, sizeof(Vertex), &vxs[0].pos);
-		glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), &vxs[0].tex);
-		glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Vertex), &vxs[0].col);
+		setDrawState(vxs, _srcBlendFactor, _dstBlendFactor);
 
 		glDrawArrays(GL_TRIANGLE_FAN, 0, vertex.size());
-
-		glDisableClientState(GL_COLOR_ARRAY);
-		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-		glDisableClientState(GL_VERTEX_ARRAY);
-		glDisable(GL_BLEND);
+		getStatistics().drawCalls++;
 
 		delete[] vxs;	
 	}
 
 	void enableRoundCornerStencil(float x, float y, float width, float height, float radius)
 	{
-		bool tx = glIsEnabled(GL_TEXTURE_2D);
-		glDisable(GL_TEXTURE_2D);
+		// What's already batched is not masked. The mask is drawn untextured : the caller binds its texture again.
+		flush();
 
 		glClear(GL_DEPTH_BUFFER_BIT);
 		glEnable(GL_STENCIL_TEST);
@@ -941,13 +709,12 @@ namespace Renderer
 		glStencilMask(0x00);
 		glStencilFunc(GL_EQUAL, 0, 0xFF);
 		glStencilFunc(GL_EQUAL, 1, 0xFF);
-
-		if (tx)
-			glEnable(GL_TEXTURE_2D);
 	}
 
 	void disableStencil()
 	{
+		// What's batched is masked
+		flush();
 		glDisable(GL_STENCIL_TEST);
 	}
 } // Renderer::
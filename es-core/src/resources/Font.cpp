@@ -5,6 +5,11 @@
 #include "utils/FileSystemUtil.h"
 #include "utils/StringUtil.h"
 #include "Log.h"
+#include <algorithm>
+#include <condition_variable>
+#include <iterator>
+#include <string.h>
+#include <thread>
 
 #ifdef WIN32
 #include <Windows.h>
@@ -16,9 +21,130 @@ int Font::getSize() const { return mSize; }
 
 std::map< std::pair<std::string, int>, std::weak_ptr<Font> > Font::sFontMap;
 
-Font::FontFace::FontFace(ResourceData&& d, int size) : data(d)
+std::atomic<unsigned int> Font::sTextLayoutHits(0);
+std::atomic<unsigned int> Font::sTextLayoutMisses(0);
+
+#define TEXT_LAYOUT_CACHE_SIZE				(256 * 1024)	// bytes of vertices memoized per font
+#define MAX_CACHED_TEXT_LAYOUT_SIZE			(TEXT_LAYOUT_CACHE_SIZE / 8) // long texts (game descriptions) are built for themselves
+
+#define PRERENDER_BATCH						64	// glyphs handed to the font at once
+#define MAX_PRERENDERED_GLYPHS_PER_FRAME	128	// glyphs packed and uploaded by Font::update()
+
+// Background rasterization of the "FontPrerenderRanges" glyphs. Only the render thread touches the fonts :
+// the thread gets a copy of what it needs, and the glyphs it completes wait in sPrerenderedGlyphs.
+struct PrerenderJob
+{
+	Font*								font;
+	std::shared_ptr<std::atomic<bool>>	cancel; // set when the font is deleted
+	std::string							path;
+	int									size;
+	int									maxGlyphHeight;
+	std::vector<std::pair<unsigned int, unsigned int>> ranges;
+	std::vector<unsigned int>			knownGlyphs; // sorted
+};
+
+static std::mutex								sPrerenderLock;
+static std::condition_variable					sPrerenderEvent;
+static std::list<PrerenderJob>					sPrerenderJobs;
+static std::map<Font*, std::vector<GlyphBitmap>>	sPrerenderedGlyphs;
+static std::atomic<bool>						sPrerenderExit(false);
+static bool										sShutdown = false;
+
+static void stopPrerender(std::thread& thread)
+{
+	{
+		std::unique_lock<std::mutex> lock(sPrerenderLock);
+		sPrerenderExit = true;
+		sPrerenderJobs.clear();
+		sPrerenderedGlyphs.clear();
+	}
+
+	sPrerenderEvent.notify_all();
+
+	if (thread.joinable())
+		thread.join();
+}
+
+// Joined on exit, even when Font::shutdown() is not called
+static struct PrerenderThread
+{
+	~PrerenderThread() { stopPrerender(thread); }
+	std::thread thread;
+} sPrerenderThread;
+
+// Font files are shared by all the sizes, and by the background rasterization
+static std::mutex sFontDataLock;
+static std::map<std::string, std::pair<std::weak_ptr<unsigned char>, size_t>> sFontData;
+
+ResourceData Font::getFontData(const std::string& path)
+{
+	std::unique_lock<std::mutex> lock(sFontDataLock);
+
+	auto it = sFontData.find(path);
+	if (it != sFontData.cend())
+	{
+		std::shared_ptr<unsigned char> ptr = it->second.first.lock();
+		if (ptr != nullptr)
+		{
+			ResourceData data = { ptr, it->second.second };
+			return data;
+		}
+	}
+
+	ResourceData data = ResourceManager::getInstance()->getFileData(path);
+	sFontData[path] = std::make_pair(std::weak_ptr<unsigned char>(data.ptr), data.length);
+	return data;
+}
+
+Font::GlyphTable::GlyphTable() : mCount(0), mShift(32 - 6)
 {
-	int err = FT_New_Memory_Face(sLibrary, data.ptr.get(), (FT_Long)data.length, 0, &face);
+	mSlots.resize(64, nullptr);
+}
+
+Font::Glyph* Font::GlyphTable::find(unsigned int id) const
+{
+	const size_t mask = mSlots.size() - 1;
+
+	for (size_t slot = getSlot(id); ; slot = (slot + 1) & mask)
+	{
+		Glyph* glyph = mSlots[slot];
+		if (glyph == nullptr || glyph->id == id)
+			return glyph;
+	}
+}
+
+void Font::GlyphTable::insert(Glyph* glyph)
+{
+	if ((mCount + 1) * 2 > mSlots.size())
+		grow();
+
+	const size_t mask = mSlots.size() - 1;
+
+	size_t slot = getSlot(glyph->id);
+	while (mSlots[slot] != nullptr && mSlots[slot]->id != glyph->id)
+		slot = (slot + 1) & mask;
+
+	if (mSlots[slot] == nullptr)
+		mCount++;
+
+	mSlots[slot] = glyph;
+}
+
+void Font::GlyphTable::grow()
+{
+	std::vector<Glyph*> slots(mSlots.size() * 2, nullptr);
+	mSlots.swap(slots);
+	mShift--;
+	mCount = 0;
+
+	for (auto glyph : slots)
+		if (glyph != nullptr)
+			insert(glyph);
+}
+
+Font::FontFace::FontFace(ResourceData&& d, int size, FT_Library library) : data(d)
+{
+	int err = FT_New_Memory_Face(library, data.ptr.get(), (FT_Long)data.length, 0, &face);
 	assert(!err);
 	
 	if(!err)
@@ -97,21 +223,33 @@ Font::Font(int size, const std::string& path) : mSize(size), mPath(path)
 	for (unsigned int i = 0; i < 255; i++)
 		mGlyphCacheArray[i] = NULL;
 
+	mGlyphCacheDirty = false;
+	mTextLayoutBytes = 0;
+	mPrerenderCancel = std::make_shared<std::atomic<bool>>(false);
+
+	loadGlyphCache();
+
 	// always initialize ASCII characters
 	for (unsigned int i = 32; i < 128; i++)
 		getGlyph(i);
 
 	// getGlyph(61446);
-	
-	clearFaceCache();
+
+	startPrerender();
 }
 
 Font::~Font()
 {
-	for (auto it = mGlyphMap.cbegin(); it != mGlyphMap.cend(); it++)
-		delete it->second;
+	{
+		std::unique_lock<std::mutex> lock(sPrerenderLock);
+		*mPrerenderCancel = true;
+		sPrerenderedGlyphs.erase(this);
+		sPrerenderJobs.remove_if([this](const PrerenderJob& job) { return job.font == this; });
+	}
 
 	unload();
+
+	mGlyphTable.forEach([](Glyph* glyph) { delete glyph; });
 }
 
 void Font::reload()
@@ -127,6 +265,7 @@ bool Font::unload()
 {
 	if (mLoaded)
 	{
+		saveGlyphCache();
 		unloadTextures();
 		mLoaded = false;
 		return true;
@@ -245,7 +384,7 @@ void Font::getTextureForNewGlyph(const Vector2i& glyphSize, FontTexture*& tex_ou
 	}
 }
 
-std::vector<std::string> getFallbackFontPaths()
+static std::vector<std::string> getFallbackFontPaths()
 {
 #ifdef WIN32
 	// Windows
@@ -301,22 +440,36 @@ std::vector<std::string> getFallbackFontPaths()
 #endif
 }
 
-FT_Face Font::getFaceForChar(unsigned int id)
+static const std::vector<std::string>& getFallbackFonts()
 {
 	static const std::vector<std::string> fallbackFonts = getFallbackFontPaths();
+	return fallbackFonts;
+}
+
+std::vector<std::string> Font::getFontPaths()
+{
+	std::vector<std::string> paths = { mPath };
+	for (auto path : getFallbackFonts())
+		paths.push_back(path);
+
+	return paths;
+}
+
+FT_Face Font::findFaceForChar(FaceCache& faceCache, FT_Library library, const std::string& path, int size, int maxGlyphHeight, unsigned int id)
+{
+	const std::vector<std::string>& fallbackFonts = getFallbackFonts();
 
 	// look through our current font + fallback fonts to see if any have the glyph we're looking for
 	for(unsigned int i = 0; i < fallbackFonts.size() + 1; i++)
 	{
-		auto fit = mFaceCache.find(i);
-		if (fit == mFaceCache.cend()) // doesn't exist yet
+		auto fit = faceCache.find(i);
+		if (fit == faceCache.cend()) // doesn't exist yet
 		{		
-			// i == 0 -> mPath
+			// i == 0 -> path
 			// otherwise, take from fallbackFonts
-			const std::string& path = (i == 0 ? mPath : fallbackFonts.at(i - 1));
-			ResourceData data = ResourceManager::getInstance()->getFileData(path);			
-			mFaceCache[i] = std::unique_ptr<FontFace>(new FontFace(std::move(data), i == 1 && mMaxGlyphHeight > 0 ? mMaxGlyphHeight : mSize)); // Reduce size of gyphs ????
-			fit = mFaceCache.find(i);
+			ResourceData data = getFontData(i == 0 ? path : fallbackFonts.at(i - 1));
+			faceCache[i] = std::unique_ptr<FontFace>(new FontFace(std::move(data), i == 1 && maxGlyphHeight > 0 ? maxGlyphHeight : size, library)); // Reduce size of gyphs ????
+			fit = faceCache.find(i);
 		}
 
 		// i == 2 -> DroidSansFallbackFull
@@ -329,7 +482,12 @@ FT_Face Font::getFaceForChar(unsigned int id)
 	}
 
 	// nothing has a valid glyph - return the "real" face so we get a "missing" character
-	return mFaceCache.cbegin()->second->face;
+	return faceCache.cbegin()->second->face;
+}
+
+FT_Face Font::getFaceForChar(unsigned int id)
+{
+	return findFaceForChar(mFaceCache, sLibrary, mPath, mSize, mMaxGlyphHeight, id);
 }
 
 void Font::clearFaceCache()
@@ -337,6 +495,71 @@ void Font::clearFaceCache()
 	mFaceCache.clear();
 }
 
+bool Font::rasterizeGlyph(FT_Face face, unsigned int id, GlyphBitmap& glyph)
+{
+	if (FT_Load_Char(face, id, FT_LOAD_RENDER))
+		return false;
+
+	FT_GlyphSlot g = face->glyph;
+
+	glyph.id = id;
+	glyph.width = g->bitmap.width;
+	glyph.height = g->bitmap.rows;
+	glyph.advance = Vector2f((float)g->metrics.horiAdvance / 64.0f, (float)g->metrics.vertAdvance / 64.0f);
+	glyph.bearing = Vector2f((float)g->metrics.horiBearingX / 64.0f, (float)g->metrics.horiBearingY / 64.0f);
+	glyph.pixels.resize((size_t)glyph.width * glyph.height);
+
+	// FreeType rows can be padded
+	for (int row = 0; row < glyph.height; row++)
+		memcpy(glyph.pixels.data() + row * glyph.width, g->bitmap.buffer + row * g->bitmap.pitch, glyph.width);
+
+	return true;
+}
+
+Font::Glyph* Font::addGlyph(GlyphBitmap& bitmap)
+{
+	Vector2i glyphSize(bitmap.width, bitmap.height);
+
+	FontTexture* tex = NULL;
+	Vector2i cursor;
+	getTextureForNewGlyph(glyphSize, tex, cursor);
+
+	// getTextureForNewGlyph can fail if the glyph is bigger than the max texture size (absurdly large font size)
+	if(tex == NULL)
+	{
+		LOG(LogError) << "Could not create glyph for character " << bitmap.id << " for font " << mPath << ", size " << mSize << " (no suitable texture found)!";
+		return NULL;
+	}
+
+	// create glyph
+	Glyph* pGlyph = new Glyph();
+	
+	pGlyph->id = bitmap.id;
+	pGlyph->texture = tex;
+	pGlyph->texPos = Vector2f(cursor.x() / (float)tex->textureSize.x(), cursor.y() / (float)tex->textureSize.y());
+	pGlyph->texSize = Vector2f(glyphSize.x() / (float)tex->textureSize.x(), glyphSize.y() / (float)tex->textureSize.y());	
+	pGlyph->advance = bitmap.advance;
+	pGlyph->bearing = bitmap.bearing;
+	pGlyph->bitmapPos = cursor;
+	pGlyph->bitmapSize = glyphSize;
+	pGlyph->pixels = std::move(bitmap.pixels);
+
+	// upload glyph bitmap to texture
+	if (!pGlyph->pixels.empty())
+		Renderer::updateTexture(tex->textureId, Renderer::Texture::ALPHA, cursor.x(), cursor.y(), glyphSize.x(), glyphSize.y(), pGlyph->pixels.data());
+
+	// update max glyph height
+	if (pGlyph->id != 61446 && glyphSize.y() > mMaxGlyphHeight)
+		mMaxGlyphHeight = glyphSize.y();
+
+	mGlyphTable.insert(pGlyph);
+
+	if (pGlyph->id < 255)
+		mGlyphCacheArray[pGlyph->id] = pGlyph;
+
+	return pGlyph;
+}
+
 Font::Glyph* Font::getGlyph(unsigned int id)
 {
 	if (id < 255)
@@ -350,9 +573,9 @@ Font::Glyph* Font::getGlyph(unsigned int id)
 	else
 	{
 		// is it already loaded?
-		auto it = mGlyphMap.find(id);
-		if (it != mGlyphMap.cend())
-			return it->second;
+		Glyph* glyph = mGlyphTable.find(id);
+		if (glyph != NULL)
+			return glyph;
 	}
 
 	// nope, need to make a glyph
@@ -363,76 +586,231 @@ Font::Glyph* Font::getGlyph(unsigned int id)
 		return NULL;
 	}
 
-	FT_GlyphSlot g = face->glyph;
-
-	if (FT_Load_Char(face, id, FT_LOAD_RENDER))
+	GlyphBitmap bitmap;
+	if (!rasterizeGlyph(face, id, bitmap))
 	{
 		LOG(LogError) << "Could not find glyph for character " << id << " for font " << mPath << ", size " << mSize << "!";
 		return NULL;
 	}
 
-	Vector2i glyphSize(g->bitmap.width, g->bitmap.rows);
+	Glyph* glyph = addGlyph(bitmap);
+	if (glyph != NULL)
+		mGlyphCacheDirty = true;
 
-	FontTexture* tex = NULL;
-	Vector2i cursor;
-	getTextureForNewGlyph(glyphSize, tex, cursor);
+	return glyph;
+}
 
-	// getTextureForNewGlyph can fail if the glyph is bigger than the max texture size (absurdly large font size)
-	if(tex == NULL)
+// completely recreate the texture data for all textures based on mGlyphs information
+void Font::rebuildTextures()
+{
+	// recreate OpenGL textures
+	for(auto it = mTextures.begin(); it != mTextures.end(); it++)
+		it->initTexture();
+
+	// reupload the texture data, glyphs keep their bitmap
+	mGlyphTable.forEach([](Glyph* glyph)
 	{
-		LOG(LogError) << "Could not create glyph for character " << id << " for font " << mPath << ", size " << mSize << " (no suitable texture found)!";
-		return NULL;
+		if (!glyph->pixels.empty())
+			Renderer::updateTexture(glyph->texture->textureId, Renderer::Texture::ALPHA, glyph->bitmapPos.x(), glyph->bitmapPos.y(), glyph->bitmapSize.x(), glyph->bitmapSize.y(), glyph->pixels.data());
+	});
+}
+
+void Font::loadGlyphCache()
+{
+	std::vector<GlyphBitmap> glyphs;
+	if (!GlyphCache::getInstance()->load(getFontPaths(), mSize, glyphs))
+		return;
+
+	for (auto& glyph : glyphs)
+		if (mGlyphTable.find(glyph.id) == NULL)
+			addGlyph(glyph);
+}
+
+void Font::saveGlyphCache()
+{
+	if (!mGlyphCacheDirty || sShutdown)
+		return;
+
+	mGlyphCacheDirty = false;
+
+	std::vector<GlyphBitmap> glyphs;
+	glyphs.reserve(mGlyphTable.size());
+
+	mGlyphTable.forEach([&glyphs](Glyph* glyph)
+	{
+		GlyphBitmap bitmap;
+		bitmap.id = glyph->id;
+		bitmap.width = glyph->bitmapSize.x();
+		bitmap.height = glyph->bitmapSize.y();
+		bitmap.advance = glyph->advance;
+		bitmap.bearing = glyph->bearing;
+		bitmap.pixels = glyph->pixels;
+		glyphs.push_back(std::move(bitmap));
+	});
+
+	GlyphCache::getInstance()->save(getFontPaths(), mSize, glyphs);
+}
+
+void Font::startPrerender()
+{
+	if (sShutdown)
+		return;
+
+	PrerenderJob job;
+	job.ranges = GlyphCache::getPrerenderRanges();
+	if (job.ranges.empty())
+		return;
+
+	job.font = this;
+	job.cancel = mPrerenderCancel;
+	job.path = mPath;
+	job.size = mSize;
+	job.maxGlyphHeight = mMaxGlyphHeight;
+
+	job.knownGlyphs.reserve(mGlyphTable.size());
+	mGlyphTable.forEach([&job](Glyph* glyph) { job.knownGlyphs.push_back(glyph->id); });
+	std::sort(job.knownGlyphs.begin(), job.knownGlyphs.end());
+
+	{
+		std::unique_lock<std::mutex> lock(sPrerenderLock);
+		sPrerenderJobs.push_back(std::move(job));
+
+		if (!sPrerenderThread.thread.joinable())
+			sPrerenderThread.thread = std::thread(&Font::prerenderProc);
 	}
 
-	// create glyph
-	Glyph* pGlyph = new Glyph();
-	
-	pGlyph->texture = tex;
-	pGlyph->texPos = Vector2f(cursor.x() / (float)tex->textureSize.x(), cursor.y() / (float)tex->textureSize.y());
-	pGlyph->texSize = Vector2f(glyphSize.x() / (float)tex->textureSize.x(), glyphSize.y() / (float)tex->textureSize.y());	
-	pGlyph->advance = Vector2f((float)g->metrics.horiAdvance / 64.0f, (float)g->metrics.vertAdvance / 64.0f);
-	pGlyph->bearing = Vector2f((float)g->metrics.horiBearingX / 64.0f, (float)g->metrics.horiBearingY / 64.0f);
+	sPrerenderEvent.notify_one();
+}
 
-	// upload glyph bitmap to texture
-	Renderer::updateTexture(tex->textureId, Renderer::Texture::ALPHA, cursor.x(), cursor.y(), glyphSize.x(), glyphSize.y(), g->bitmap.buffer);
+static bool pushPrerenderedGlyphs(const PrerenderJob& job, std::vector<GlyphBitmap>& glyphs)
+{
+	std::unique_lock<std::mutex> lock(sPrerenderLock);
 
-	// update max glyph height
-	if (id != 61446 && glyphSize.y() > mMaxGlyphHeight)
-		mMaxGlyphHeight = glyphSize.y();
+	// Checked under the lock : the font can't be deleted before its glyphs are queued
+	if (*job.cancel || sPrerenderExit)
+		return false;
 
-	mGlyphMap[id] = pGlyph;
+	if (!glyphs.empty())
+	{
+		std::vector<GlyphBitmap>& pending = sPrerenderedGlyphs[job.font];
+		for (auto& glyph : glyphs)
+			pending.push_back(std::move(glyph));
+	}
 
-	if (id < 255)
-		mGlyphCacheArray[id] = pGlyph;
+	glyphs.clear();
+	return true;
+}
 
-	return pGlyph;
+void Font::prerenderProc()
+{
+	// FreeType libraries are not thread safe, this thread has its own
+	FT_Library library = NULL;
+	if (FT_Init_FreeType(&library))
+	{
+		LOG(LogError) << "Error initializing FreeType for the glyph prerendering!";
+		return;
+	}
+
+	while (true)
+	{
+		PrerenderJob job;
+
+		{
+			std::unique_lock<std::mutex> lock(sPrerenderLock);
+			sPrerenderEvent.wait(lock, [] { return sPrerenderExit || !sPrerenderJobs.empty(); });
+
+			if (sPrerenderExit)
+				break;
+
+			job = std::move(sPrerenderJobs.front());
+			sPrerenderJobs.pop_front();
+		}
+
+		int count = 0;
+		bool cancelled = false;
+
+		std::vector<GlyphBitmap> glyphs;
+
+		{
+			FaceCache faceCache;
+
+			for (auto range : job.ranges)
+			{
+				for (unsigned int id = range.first; id <= range.second && !cancelled; id++)
+				{
+					if (*job.cancel || sPrerenderExit)
+						cancelled = true;
+					else if (!std::binary_search(job.knownGlyphs.cbegin(), job.knownGlyphs.cend(), id))
+					{
+						// Characters none of the fonts have would only give "missing" glyphs
+						FT_Face face = findFaceForChar(faceCache, library, job.path, job.size, job.maxGlyphHeight, id);
+						if (face == NULL || FT_Get_Char_Index(face, id) == 0)
+							continue;
+
+						GlyphBitmap glyph;
+						if (!rasterizeGlyph(face, id, glyph))
+							continue;
+
+						glyphs.push_back(std::move(glyph));
+						count++;
+
+						if (glyphs.size() >= PRERENDER_BATCH)
+							cancelled = !pushPrerenderedGlyphs(job, glyphs);
+					}
+				}
+			}
+		}
+
+		if (!cancelled)
+			pushPrerenderedGlyphs(job, glyphs);
+
+		LOG(LogDebug) << "Font : " << count << " glyphs prerendered for " << job.path << ", size " << job.size;
+	}
+
+	FT_Done_FreeType(library);
 }
 
-// completely recreate the texture data for all textures based on mGlyphs information
-void Font::rebuildTextures()
+void Font::update()
 {
-	// recreate OpenGL textures
-	for(auto it = mTextures.begin(); it != mTextures.end(); it++)
-		it->initTexture();
+	Font* font = nullptr;
+	std::vector<GlyphBitmap> glyphs;
 
-	// reupload the texture data
-	for(auto it = mGlyphMap.cbegin(); it != mGlyphMap.cend(); it++)
 	{
-		FT_Face face = getFaceForChar(it->first);
-		FT_GlyphSlot glyphSlot = face->glyph;
+		std::unique_lock<std::mutex> lock(sPrerenderLock);
+		if (sPrerenderedGlyphs.empty())
+			return;
 
-		// load the glyph bitmap through FT
-		FT_Load_Char(face, it->first, FT_LOAD_RENDER);
+		// A few glyphs per frame : packing and uploading them is not free
+		auto it = sPrerenderedGlyphs.begin();
+		font = it->first;
 
-		FontTexture* tex = it->second->texture;
-		
-		// find the position/size
-		Vector2i cursor((int)(it->second->texPos.x() * tex->textureSize.x()), (int)(it->second->texPos.y() * tex->textureSize.y()));
-		Vector2i glyphSize((int)(it->second->texSize.x() * tex->textureSize.x()), (int)(it->second->texSize.y() * tex->textureSize.y()));
-		
-		// upload to texture
-		Renderer::updateTexture(tex->textureId, Renderer::Texture::ALPHA, cursor.x(), cursor.y(), glyphSize.x(), glyphSize.y(), glyphSlot->bitmap.buffer);
+		std::vector<GlyphBitmap>& pending = it->second;
+		size_t count = std::min(pending.size(), (size_t)MAX_PRERENDERED_GLYPHS_PER_FRAME);
+
+		glyphs.assign(std::make_move_iterator(pending.end() - count), std::make_move_iterator(pending.end()));
+		pending.resize(pending.size() - count);
+
+		if (pending.empty())
+			sPrerenderedGlyphs.erase(it);
 	}
+
+	for (auto& glyph : glyphs)
+		if (font->mGlyphTable.find(glyph.id) == NULL && font->addGlyph(glyph) != NULL)
+			font->mGlyphCacheDirty = true;
+}
+
+void Font::shutdown()
+{
+	stopPrerender(sPrerenderThread.thread);
+
+	for (auto it = sFontMap.cbegin(); it != sFontMap.cend(); it++)
+	{
+		std::shared_ptr<Font> font = it->second.lock();
+		if (font != nullptr)
+			font->saveGlyphCache();
+	}
+
+	sShutdown = true;
 }
 
 void Font::renderTextCache(TextCache* cache)
@@ -443,12 +821,15 @@ void Font::renderTextCache(TextCache* cache)
 		return;
 	}
 
-	for(auto it = cache->vertexLists.cbegin(); it != cache->vertexLists.cend(); it++)
+	if (cache->layout == nullptr)
+		return;
+
+	for(auto it = cache->layout->vertexLists.cbegin(); it != cache->layout->vertexLists.cend(); it++)
 	{
 		assert(*it->textureIdPtr != 0);
 
 		Renderer::bindTexture(*it->textureIdPtr);
-		Renderer::drawTriangleStrips(&it->verts[0], it->verts.size());
+		Renderer::drawTriangleStrips(&it->verts[0], it->verts.size(), cache->offset, cache->color);
 	}
 }
 
@@ -460,23 +841,27 @@ void Font::renderGradientTextCache(TextCache* cache, unsigned int colorTop, unsi
 		return;
 	}
 
-	for (auto it = cache->vertexLists.cbegin(); it != cache->vertexLists.cend(); it++)
+	if (cache->layout == nullptr)
+		return;
+
+	for (auto it = cache->layout->vertexLists.cbegin(); it != cache->layout->vertexLists.cend(); it++)
 	{
 		assert(*it->textureIdPtr != 0);
 
-		std::vector<Renderer::Vertex> vxs;
-		vxs.resize(it->verts.size());
+		std::vector<Renderer::Vertex> vxs(it->verts);
+		for (auto& vertex : vxs)
+			vertex.pos += cache->offset;
 
 		float maxY = -1;
 
-		for (int i = 0; i < it->verts.size(); i += 6)
-			if (maxY == -1 || maxY < it->verts[i + 2].pos.y())
-				maxY = it->verts[i + 2].pos.y();
+		for (int i = 0; i < vxs.size(); i += 6)
+			if (maxY == -1 || maxY < vxs[i + 2].pos.y())
+				maxY = vxs[i + 2].pos.y();
 
-		for (int i = 0; i < it->verts.size(); i += 6)
+		for (int i = 0; i < vxs.size(); i += 6)
 		{
-			float topOffset = it->verts[i + 1].pos.y();
-			float bottomOffset = it->verts[i + 2].pos.y();
+			float topOffset = vxs[i + 1].pos.y();
+			float bottomOffset = vxs[i + 2].pos.y();
 			
 			float topPercent = (maxY == 0 ? 1.0 : topOffset / maxY);
 			float bottomPercent = (maxY == 0 ? 1.0 : bottomOffset / maxY);
@@ -484,16 +869,9 @@ void Font::renderGradientTextCache(TextCache* cache, unsigned int colorTop, unsi
 			const unsigned int colorT = Renderer::mixColors(colorTop, colorBottom, topPercent);
 			const unsigned int colorB = Renderer::mixColors(colorTop, colorBottom, bottomPercent);
 		
-			vxs[i + 1] = it->verts[i + 1];
 			vxs[i + 1].col = colorT;
-
-			vxs[i + 2] = it->verts[i + 2];
 			vxs[i + 2].col = colorB;
-
-			vxs[i + 3] = it->verts[i + 3];
 			vxs[i + 3].col = colorT;
-
-			vxs[i + 4] = it->verts[i + 4];
 			vxs[i + 4].col = colorB;
 
 			// make duplicates of first and last vertex so this can be rendered as a triangle strip
@@ -667,13 +1045,76 @@ float Font::getNewlineStartOffset(const std::string& text, const unsigned int& c
 	}
 }
 
+size_t Font::TextLayoutKeyHash::operator()(const TextLayoutKey& key) const
+{
+	size_t hash = std::hash<std::string>()(key.text);
+	hash ^= std::hash<float>()(key.xLen) + 0x9E3779B9 + (hash << 6) + (hash >> 2);
+	hash ^= std::hash<float>()(key.lineSpacing) + 0x9E3779B9 + (hash << 6) + (hash >> 2);
+	return hash ^ (size_t)key.alignment;
+}
+
+void Font::getTextLayoutCacheStats(unsigned int& hits, unsigned int& misses)
+{
+	hits = sTextLayoutHits;
+	misses = sTextLayoutMisses;
+}
+
+std::shared_ptr<const TextLayout> Font::getTextLayout(const std::string& text, float xLen, Alignment alignment, float lineSpacing)
+{
+	TextLayoutKey key = { text, xLen, alignment, lineSpacing };
+
+	auto it = mTextLayoutIndex.find(key);
+	if (it != mTextLayoutIndex.cend())
+	{
+		sTextLayoutHits++;
+		mTextLayouts.splice(mTextLayouts.begin(), mTextLayouts, it->second);
+		return it->second->layout;
+	}
+
+	sTextLayoutMisses++;
+
+	std::shared_ptr<TextLayout> layout = buildTextLayout(text, xLen, alignment, lineSpacing);
+
+	size_t bytes = text.size() + sizeof(TextLayoutEntry);
+	for (auto& vertList : layout->vertexLists)
+		bytes += vertList.verts.size() * sizeof(Renderer::Vertex);
+
+	if (bytes > MAX_CACHED_TEXT_LAYOUT_SIZE)
+		return layout;
+
+	TextLayoutEntry entry = { key, layout, bytes };
+	mTextLayouts.push_front(entry);
+	mTextLayoutIndex[key] = mTextLayouts.begin();
+	mTextLayoutBytes += bytes;
+
+	// TextCaches still showing a dropped layout keep it
+	while (mTextLayoutBytes > TEXT_LAYOUT_CACHE_SIZE && mTextLayouts.size() > 1)
+	{
+		mTextLayoutBytes -= mTextLayouts.back().bytes;
+		mTextLayoutIndex.erase(mTextLayouts.back().key);
+		mTextLayouts.pop_back();
+	}
+
+	return layout;
+}
+
 TextCache* Font::buildTextCache(const std::string& text, Vector2f offset, unsigned int color, float xLen, Alignment alignment, float lineSpacing)
 {
-	float x = offset[0] + (xLen != 0 ? getNewlineStartOffset(text, 0, xLen, alignment) : 0);
+	TextCache* cache = new TextCache();
+	cache->layout = getTextLayout(text, xLen, alignment, lineSpacing);
+	cache->metrics = { cache->layout->size };
+	cache->offset = Vector2f(Math::round(offset.x()), Math::round(offset.y())); // the layout vertices are rounded
+	cache->setColor(color);
+	return cache;
+}
+
+std::shared_ptr<TextLayout> Font::buildTextLayout(const std::string& text, float xLen, Alignment alignment, float lineSpacing)
+{
+	float x = (xLen != 0 ? getNewlineStartOffset(text, 0, xLen, alignment) : 0);
 	
 	float yTop = getGlyph('S')->bearing.y();
 	float yBot = getHeight(lineSpacing);
-	float y = offset[1] + (yBot + yTop)/2.0f;
+	float y = (yBot + yTop)/2.0f;
 
 	// vertices by texture
 	std::map< FontTexture*, std::vector<Renderer::Vertex> > vertMap;
@@ -691,7 +1132,7 @@ TextCache* Font::buildTextCache(const std::string& text, Vector2f offset, unsign
 		if(character == '\n')
 		{
 			y += getHeight(lineSpacing);
-			x = offset[0] + (xLen != 0 ? getNewlineStartOffset(text, (const unsigned int)cursor /* cursor is already advanced */, xLen, alignment) : 0);
+			x = (xLen != 0 ? getNewlineStartOffset(text, (const unsigned int)cursor /* cursor is already advanced */, xLen, alignment) : 0);
 			continue;
 		}
 
@@ -706,7 +1147,7 @@ TextCache* Font::buildTextCache(const std::string& text, Vector2f offset, unsign
 
 		const float        glyphStartX = x + glyph->bearing.x();
 		const Vector2i&    textureSize = glyph->texture->textureSize;
-		const unsigned int convertedColor = Renderer::convertColor(color);
+		const unsigned int convertedColor = 0xFFFFFFFF; // the color of each TextCache replaces it
 
 		vertices[1] = { { glyphStartX                                       , y - glyph->bearing.y()                                          }, { glyph->texPos.x(),                      glyph->texPos.y()                      }, convertedColor };
 		vertices[2] = { { glyphStartX                                       , y - glyph->bearing.y() + (glyph->texSize.y() * textureSize.y()) }, { glyph->texPos.x(),                      glyph->texPos.y() + glyph->texSize.y() }, convertedColor };
@@ -725,24 +1166,21 @@ TextCache* Font::buildTextCache(const std::string& text, Vector2f offset, unsign
 		x += glyph->advance.x();
 	}
 
-	//TextCache::CacheMetrics metrics = { sizeText(text, lineSpacing) };
-
-	TextCache* cache = new TextCache();
-	cache->vertexLists.resize(vertMap.size());
-	cache->metrics = { sizeText(text, lineSpacing) };
+	std::shared_ptr<TextLayout> layout = std::make_shared<TextLayout>();
+	layout->vertexLists.resize(vertMap.size());
+	layout->size = sizeText(text, lineSpacing);
 
 	unsigned int i = 0;
-	for(auto it = vertMap.cbegin(); it != vertMap.cend(); it++)
+	for(auto it = vertMap.begin(); it != vertMap.end(); it++)
 	{
-		TextCache::VertexList& vertList = cache->vertexLists.at(i);
+		TextLayout::VertexList& vertList = layout->vertexLists.at(i);
 
 		vertList.textureIdPtr = &it->first->textureId;
-		vertList.verts = it->second;
+		vertList.verts.swap(it->second);
+		i++;
 	}
 
-	clearFaceCache();
-
-	return cache;
+	return layout;
 }
 
 TextCache* Font::buildTextCache(const std::string& text, float offsetX, float offsetY, unsigned int color)
@@ -752,11 +1190,7 @@ TextCache* Font::buildTextCache(const std::string& text, float offsetX, float of
 
 void TextCache::setColor(unsigned int color)
 {
-	const unsigned int convertedColor = Renderer::convertColor(color);
-
-	for (auto it = vertexLists.begin(); it != vertexLists.end(); it++)
-		for (auto it2 = it->verts.begin(); it2 != it->verts.end(); it2++)
-			it2->col = convertedColor;
+	this->color = Renderer::convertColor(color);
 }
 
 std::shared_ptr<Font> Font::getFromTheme(const ThemeData::ThemeElement* elem, unsigned int properties, const std::shared_ptr<Font>& orig)
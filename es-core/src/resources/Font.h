@@ -6,10 +6,14 @@
 #include "math/Vector2f.h"
 #include "math/Vector2i.h"
 #include "renderers/Renderer.h"
+#include "resources/GlyphCache.h"
 #include "resources/ResourceManager.h"
 #include "ThemeData.h"
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#include <atomic>
+#include <list>
+#include <unordered_map>
 #include <vector>
 
 class TextCache;
@@ -31,6 +35,20 @@ enum Alignment
 	ALIGN_BOTTOM
 };
 
+// Glyph quads of a string, built once per (font, text, alignment, wrap width, line spacing) and shared by the TextCaches showing it.
+// Never modified once built : the color and the offset belong to each TextCache.
+struct TextLayout
+{
+	struct VertexList
+	{
+		std::vector<Renderer::Vertex> verts;
+		unsigned int* textureIdPtr; // this is a pointer because the texture ID can change during deinit/reinit (when launching a game)
+	};
+
+	std::vector<VertexList> vertexLists;
+	Vector2f size;
+};
+
 //A TrueType Font renderer that uses FreeType and OpenGL.
 //The library is automatically initialized when it's needed.
 class Font : public IReloadable
@@ -69,6 +87,14 @@ public:
 	size_t getMemUsage() const; // returns an approximation of VRAM used by this font's texture (in bytes)
 	static size_t getTotalMemUsage(); // returns an approximation of total VRAM used by font textures (in bytes)
 
+	// Adds the glyphs rasterized in the background to their fonts. Called every frame, on the render thread.
+	static void update();
+	// Stops the background rasterization and saves the glyph caches
+	static void shutdown();
+
+	// Text layouts reused by buildTextCache(), and built, since the launch
+	static void getTextLayoutCacheStats(unsigned int& hits, unsigned int& misses);
+
 private:
 	static FT_Library sLibrary;
 	static std::map< std::pair<std::string, int>, std::weak_ptr<Font> > sFontMap;
@@ -97,21 +123,28 @@ private:
 		const ResourceData data;
 		FT_Face face;
 
-		FontFace(ResourceData&& d, int size);
+		FontFace(ResourceData&& d, int size, FT_Library library = sLibrary);
 		virtual ~FontFace();
 	};
 
+	typedef std::map< unsigned int, std::unique_ptr<FontFace> > FaceCache;
+
 	void rebuildTextures();
 	void unloadTextures();
 
-	std::vector<FontTexture> mTextures;
+	std::list<FontTexture> mTextures; // not a vector : glyphs and text caches point to them
 
 	void getTextureForNewGlyph(const Vector2i& glyphSize, FontTexture*& tex_out, Vector2i& cursor_out);
 
-	std::map< unsigned int, std::unique_ptr<FontFace> > mFaceCache;
+	FaceCache mFaceCache;
 	FT_Face getFaceForChar(unsigned int id);
 	void clearFaceCache();
 
+	// Looks through the font and its fallback fonts. Shared with the background rasterization, which has its own faces and FreeType library.
+	static FT_Face findFaceForChar(FaceCache& faceCache, FT_Library library, const std::string& path, int size, int maxGlyphHeight, unsigned int id);
+	static ResourceData getFontData(const std::string& path);
+	static bool rasterizeGlyph(FT_Face face, unsigned int id, GlyphBitmap& glyph);
+
 	struct Glyph
 	{
 		FontTexture* texture;
@@ -121,15 +154,58 @@ private:
 
 		Vector2f advance;
 		Vector2f bearing;
+
+		unsigned int id;
+		Vector2i bitmapPos; // in texels
+		Vector2i bitmapSize;
+		std::vector<unsigned char> pixels; // kept to upload the textures again and to save the glyph cache
+	};
+
+	// Open addressing hash table (linear probing) of the glyphs by codepoint
+	class GlyphTable
+	{
+	public:
+		GlyphTable();
+
+		Glyph* find(unsigned int id) const;
+		void insert(Glyph* glyph);
+
+		template<typename F> void forEach(const F& func) const
+		{
+			for (auto glyph : mSlots)
+				if (glyph != nullptr)
+					func(glyph);
+		}
+
+		size_t size() const { return mCount; }
+
+	private:
+		size_t getSlot(unsigned int id) const { return (size_t)((id * 2654435761u) >> mShift) & (mSlots.size() - 1); }
+		void grow();
+
+		std::vector<Glyph*>	mSlots; // power of two, at most half full
+		size_t				mCount;
+		int					mShift;
 	};
 
 	// used to cache 255 first chars
 	Glyph* mGlyphCacheArray[255];
 	
 	// used to cache every char
-	std::map<unsigned int, Glyph*> mGlyphMap;
+	GlyphTable mGlyphTable;
 
 	Glyph* getGlyph(unsigned int id);
+	Glyph* addGlyph(GlyphBitmap& bitmap);
+
+	std::vector<std::string> getFontPaths(); // the font, then its fallbacks
+	void loadGlyphCache();
+	void saveGlyphCache();
+	bool mGlyphCacheDirty;
+
+	// Background rasterization of the "FontPrerenderRanges" glyphs
+	void startPrerender();
+	static void prerenderProc();
+	std::shared_ptr<std::atomic<bool>> mPrerenderCancel;
 
 	int mMaxGlyphHeight;
 
@@ -138,6 +214,39 @@ private:
 
 	float getNewlineStartOffset(const std::string& text, const unsigned int& charStart, const float& xLen, const Alignment& alignment);
 
+	// Memoized layouts of the font, least recently used ones are dropped past TEXT_LAYOUT_CACHE_SIZE bytes
+	struct TextLayoutKey
+	{
+		std::string text;
+		float xLen;
+		Alignment alignment;
+		float lineSpacing;
+
+		bool operator==(const TextLayoutKey& other) const { return xLen == other.xLen && alignment == other.alignment && lineSpacing == other.lineSpacing && text == other.text; }
+	};
+
+	struct TextLayoutKeyHash
+	{
+		size_t operator()(const TextLayoutKey& key) const;
+	};
+
+	struct TextLayoutEntry
+	{
+		TextLayoutKey key;
+		std::shared_ptr<const TextLayout> layout;
+		size_t bytes;
+	};
+
+	std::shared_ptr<const TextLayout> getTextLayout(const std::string& text, float xLen, Alignment alignment, float lineSpacing);
+	std::shared_ptr<TextLayout> buildTextLayout(const std::string& text, float xLen, Alignment alignment, float lineSpacing);
+
+	std::list<TextLayoutEntry> mTextLayouts; // most recently used first
+	std::unordered_map<TextLayoutKey, std::list<TextLayoutEntry>::iterator, TextLayoutKeyHash> mTextLayoutIndex;
+	size_t mTextLayoutBytes;
+
+	static std::atomic<unsigned int> sTextLayoutHits;
+	static std::atomic<unsigned int> sTextLayoutMisses;
+
 
 	bool mLoaded;
 
@@ -148,19 +257,17 @@ private:
 // When a TextCache is constructed (Font::buildTextCache()), the vertices and texture coordinates of the string are calculated and stored in the TextCache object.
 // Rendering a previously constructed TextCache (Font::renderTextCache) every frame is MUCH faster than rebuilding one every frame.
 // Keep in mind you still need the Font object to render a TextCache (as the Font holds the OpenGL texture), and if a Font changes your TextCache may become invalid.
+// TextCaches of the same string share their vertices (TextLayout), only the color and the offset are their own.
 class TextCache
 {
 protected:
-
-	struct VertexList
-	{
-		std::vector<Renderer::Vertex> verts;
-		unsigned int* textureIdPtr; // this is a pointer because the texture ID can change during deinit/reinit (when launching a game)
-	};
-
-	std::vector<VertexList> vertexLists;
+	std::shared_ptr<const TextLayout> layout;
+	unsigned int color; // converted by Renderer::convertColor
+	Vector2f offset;
 
 public:
+	TextCache() : color(0xFFFFFFFF), offset(Vector2f::Zero()) { }
+
 	struct CacheMetrics
 	{
 		Vector2f size;
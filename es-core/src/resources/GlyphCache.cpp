@@ -0,0 +1,247 @@
+#include <string>
+#include "resources/GlyphCache.h"
+
+#include "resources/ResourceManager.h"
+#include "utils/FileSystemUtil.h"
+#include "utils/StringUtil.h"
+#include "Log.h"
+#include "Settings.h"
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+
+#define GLYPH_CACHE_MAGIC	0x4C475345 // "ESGL"
+#define GLYPH_CACHE_VERSION	1
+#define MAX_GLYPH_SIZE		1024
+
+struct GlyphCacheHeader
+{
+	unsigned int magic;
+	unsigned int version;
+	unsigned int keyLength;
+	unsigned int count;
+};
+
+struct GlyphCacheEntry
+{
+	unsigned int id;
+	int width;
+	int height;
+	float advanceX;
+	float advanceY;
+	float bearingX;
+	float bearingY;
+};
+
+GlyphCache* GlyphCache::getInstance()
+{
+	static GlyphCache instance;
+	return &instance;
+}
+
+GlyphCache::GlyphCache()
+{
+}
+
+bool GlyphCache::isEnabled()
+{
+	return Settings::getInstance()->getBool("GlyphCache");
+}
+
+std::string GlyphCache::getCachePath()
+{
+	return Utils::FileSystem::getHomePath() + "/.emulationstation/glyphs";
+}
+
+std::string GlyphCache::getKey(const std::vector<std::string>& fontPaths, int size)
+{
+	std::string key = std::to_string(size);
+
+	for (auto path : fontPaths)
+	{
+		// Embedded resources can be overridden by files of the home or exe folders
+		std::string realPath = ResourceManager::getInstance()->getResourcePath(path);
+
+		key += "|" + realPath + "|" + std::to_string(Utils::FileSystem::getFileSize(realPath)) + "|" +
+			std::to_string((long long)Utils::FileSystem::getFileModificationTime(realPath));
+	}
+
+	return key;
+}
+
+std::string GlyphCache::getFileName(const std::vector<std::string>& fontPaths, int size)
+{
+	// Only the font and its size : an outdated entry is replaced by the next save
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%016llx.glyphs", (unsigned long long) std::hash<std::string>()(fontPaths.front() + "|" + std::to_string(size)));
+	return buffer;
+}
+
+bool GlyphCache::load(const std::vector<std::string>& fontPaths, int size, std::vector<GlyphBitmap>& glyphs)
+{
+	if (fontPaths.empty() || !isEnabled())
+		return false;
+
+	std::string fullPath = getCachePath() + "/" + getFileName(fontPaths, size);
+	std::string key = getKey(fontPaths, size);
+
+	std::unique_lock<std::mutex> lock(mLock);
+
+	FILE* file = fopen(fullPath.c_str(), "rb");
+	if (file == nullptr)
+		return false;
+
+	bool ok = false;
+
+	GlyphCacheHeader header;
+	if (fread(&header, sizeof(header), 1, file) == 1 && header.magic == GLYPH_CACHE_MAGIC && header.version == GLYPH_CACHE_VERSION && header.keyLength == key.size())
+	{
+		std::string storedKey(header.keyLength, '\0');
+		if (fread(&storedKey[0], 1, header.keyLength, file) == header.keyLength && storedKey == key)
+		{
+			glyphs.reserve(header.count);
+			ok = true;
+
+			for (unsigned int i = 0; i < header.count && ok; i++)
+			{
+				GlyphCacheEntry entry;
+				if (fread(&entry, sizeof(entry), 1, file) != 1 || entry.width < 0 || entry.height < 0 || entry.width > MAX_GLYPH_SIZE || entry.height > MAX_GLYPH_SIZE)
+				{
+					ok = false;
+					break;
+				}
+
+				GlyphBitmap glyph;
+				glyph.id = entry.id;
+				glyph.width = entry.width;
+				glyph.height = entry.height;
+				glyph.advance = Vector2f(entry.advanceX, entry.advanceY);
+				glyph.bearing = Vector2f(entry.bearingX, entry.bearingY);
+				glyph.pixels.resize((size_t)entry.width * entry.height);
+
+				if (glyph.pixels.size() > 0 && fread(glyph.pixels.data(), 1, glyph.pixels.size(), file) != glyph.pixels.size())
+					ok = false;
+				else
+					glyphs.push_back(std::move(glyph));
+			}
+		}
+	}
+
+	fclose(file);
+
+	if (!ok)
+	{
+		// Truncated or outdated : the next save replaces it
+		glyphs.clear();
+		Utils::FileSystem::removeFile(fullPath);
+		return false;
+	}
+
+	LOG(LogDebug) << "GlyphCache : " << glyphs.size() << " glyphs loaded for " << fontPaths.front() << ", size " << size;
+	return true;
+}
+
+void GlyphCache::save(const std::vector<std::string>& fontPaths, int size, const std::vector<GlyphBitmap>& glyphs)
+{
+	if (fontPaths.empty() || glyphs.empty() || !isEnabled())
+		return;
+
+	std::string cachePath = getCachePath();
+	std::string fullPath = cachePath + "/" + getFileName(fontPaths, size);
+	std::string key = getKey(fontPaths, size);
+
+	std::unique_lock<std::mutex> lock(mLock);
+
+	if (!Utils::FileSystem::isDirectory(cachePath))
+		Utils::FileSystem::createDirectory(cachePath);
+
+	GlyphCacheHeader header;
+	header.magic = GLYPH_CACHE_MAGIC;
+	header.version = GLYPH_CACHE_VERSION;
+	header.keyLength = (unsigned int)key.size();
+	header.count = (unsigned int)glyphs.size();
+
+	// Written aside then renamed, a crash never leaves a truncated file behind
+	std::string tmpPath = fullPath + ".tmp";
+
+	FILE* file = fopen(tmpPath.c_str(), "wb");
+	if (file == nullptr)
+		return;
+
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(key.c_str(), 1, key.size(), file) == key.size();
+
+	for (auto& glyph : glyphs)
+	{
+		if (!written)
+			break;
+
+		GlyphCacheEntry entry;
+		entry.id = glyph.id;
+		entry.width = glyph.width;
+		entry.height = glyph.height;
+		entry.advanceX = glyph.advance.x();
+		entry.advanceY = glyph.advance.y();
+		entry.bearingX = glyph.bearing.x();
+		entry.bearingY = glyph.bearing.y();
+
+		written = fwrite(&entry, sizeof(entry), 1, file) == 1 && (glyph.pixels.empty() || fwrite(glyph.pixels.data(), 1, glyph.pixels.size(), file) == glyph.pixels.size());
+	}
+
+	fclose(file);
+
+#if WIN32
+	if (written)
+		Utils::FileSystem::removeFile(fullPath);
+#endif
+
+	if (!written || rename(tmpPath.c_str(), fullPath.c_str()) != 0)
+	{
+		Utils::FileSystem::removeFile(tmpPath);
+		return;
+	}
+
+	LOG(LogDebug) << "GlyphCache : " << glyphs.size() << " glyphs saved for " << fontPaths.front() << ", size " << size;
+}
+
+std::vector<std::pair<unsigned int, unsigned int>> GlyphCache::getPrerenderRanges()
+{
+	std::string value = Settings::getInstance()->getString("FontPrerenderRanges");
+
+	if (value == "auto")
+	{
+		// Accented latin letters, and the small sets of the language. The large ones (Hangul syllables AC00-D7A3,
+		// CJK ideographs 4E00-9FA5 as in utils/han.h) take several textures per font size : they have to be asked for.
+		value = "00A0-017F";
+
+		std::string language = Settings::getInstance()->getString("Language").substr(0, 2);
+		if (language == "ru" || language == "uk" || language == "bg" || language == "be" || language == "sr")
+			value += ",0400-04FF";
+		else if (language == "el")
+			value += ",0370-03FF";
+		else if (language == "ja")
+			value += ",3000-30FF,FF00-FFEF";
+		else if (language == "zh")
+			value += ",3000-303F,FF00-FFEF";
+		else if (language == "ko")
+			value += ",3000-303F,3130-318F";
+	}
+
+	std::vector<std::pair<unsigned int, unsigned int>> ranges;
+
+	for (auto range : Utils::String::split(value, ','))
+	{
+		range = Utils::String::trim(range);
+		if (range.empty())
+			continue;
+
+		size_t separator = range.find('-');
+
+		unsigned int first = (unsigned int)strtoul(range.substr(0, separator).c_str(), nullptr, 16);
+		unsigned int last = separator == std::string::npos ? first : (unsigned int)strtoul(range.substr(separator + 1).c_str(), nullptr, 16);
+
+		if (first > 0 && last >= first && last <= 0x10FFFF)
+			ranges.push_back(std::pair<unsigned int, unsigned int>(first, last));
+	}
+
+	return ranges;
+}
@@ -0,0 +1,54 @@
+#include <string>
+#pragma once
+#ifndef ES_CORE_RESOURCES_GLYPH_CACHE_H
+#define ES_CORE_RESOURCES_GLYPH_CACHE_H
+
+#include "math/Vector2f.h"
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// A rasterized glyph, before it's packed into a font texture
+struct GlyphBitmap
+{
+	GlyphBitmap() : id(0), width(0), height(0) { }
+
+	unsigned int				id;
+	int							width;
+	int							height;
+	Vector2f					advance;
+	Vector2f					bearing;
+	std::vector<unsigned char>	pixels; // 8 bits alpha, width * height
+};
+
+//
+// On-disk store of the glyphs each font size has rasterized, so they're not rasterized again (and the fallback fonts not loaded) on every launch.
+// There's one file per font path and size in ~/.emulationstation/glyphs, it's discarded when the font or one of its fallbacks changes.
+// Disabled by the "GlyphCache" setting.
+//
+class GlyphCache
+{
+public:
+	static GlyphCache* getInstance();
+
+	bool isEnabled();
+
+	// fontPaths : the font, then its fallbacks. Returns false if there's no valid entry
+	bool load(const std::vector<std::string>& fontPaths, int size, std::vector<GlyphBitmap>& glyphs);
+	void save(const std::vector<std::string>& fontPaths, int size, const std::vector<GlyphBitmap>& glyphs);
+
+	// Codepoint ranges (first, last) the fonts rasterize in the background, from the "FontPrerenderRanges" setting :
+	// comma separated hexadecimal ranges ("0400-04FF,AC00-D7A3"), or "auto" for the usual characters of the current language.
+	static std::vector<std::pair<unsigned int, unsigned int>> getPrerenderRanges();
+
+private:
+	GlyphCache();
+
+	std::string getCachePath();
+	std::string getKey(const std::vector<std::string>& fontPaths, int size);
+	std::string getFileName(const std::vector<std::string>& fontPaths, int size);
+
+	std::mutex	mLock;
+};
+
+#endif // ES_CORE_RESOURCES_GLYPH_CACHE_H
@@ -0,0 +1,224 @@
+#include <string>
+#include "resources/TextureAtlas.h"
+
+#include "renderers/Renderer.h"
+#include "FrameProfiler.h"
+#include "Log.h"
+#include <string.h>
+
+#define PADDING 1
+
+std::shared_ptr<TextureAtlas>& TextureAtlas::getInstance()
+{
+	// Function static : textures are also created by the theme loading threads
+	static std::shared_ptr<TextureAtlas> instance = []
+	{
+		std::shared_ptr<TextureAtlas> atlas(new TextureAtlas());
+		ResourceManager::getInstance()->addReloadable(atlas);
+		return atlas;
+	}();
+
+	return instance;
+}
+
+TextureAtlas::TextureAtlas()
+{
+
+}
+bool TextureAtlas::allocate(Page& page, int width, int height, int& x, int& y)
+{
+	// Best fitting shelf : the least height wasted
+	Shelf* best = nullptr;
+	for (auto& shelf : page.shelves)
+		if (shelf.height >= height && shelf.x + width <= PAGE_SIZE && (best == nullptr || shelf.height < best->height))
+			best = &shelf;
+
+	// Opens a new shelf rather than wasting more than half of an existing one
+	if ((best == nullptr || best->height > height * 2) && page.nextShelfY + height <= PAGE_SIZE)
+	{
+		Shelf shelf;
+		shelf.y = page.nextShelfY;
+		shelf.height = height;
+		shelf.x = 0;
+
+		page.shelves.push_back(shelf);
+		page.nextShelfY += height;
+		best = &page.shelves.back();
+	}
+
+	if (best == nullptr)
+		return false;
+
+	x = best->x;
+	y = best->y;
+	best->x += width;
+	return true;
+}
+
+int TextureAtlas::add(const unsigned char* dataRGBA, size_t width, size_t height, bool linear, Vector4f& uv)
+{
+	if (dataRGBA == nullptr || !isEligible(width, height))
+		return -1;
+
+	const int w = (int)width;
+	const int h = (int)height;
+	const int paddedWidth = w + PADDING * 2;
+	const int paddedHeight = h + PADDING * 2;
+
+	std::unique_lock<std::mutex> lock(mLock);
+
+	int index = -1;
+	int x = 0;
+	int y = 0;
+
+	for (int i = 0; i < (int)mPages.size() && index < 0; i++)
+		if (mPages[i].linear == linear && allocate(mPages[i], paddedWidth, paddedHeight, x, y))
+			index = i;
+
+	if (index < 0)
+	{
+		mPages.push_back(Page(linear));
+		if (!allocate(mPages.back(), paddedWidth, paddedHeight, x, y))
+		{
+			mPages.pop_back();
+			return -1;
+		}
+
+		index = (int)mPages.size() - 1;
+		LOG(LogDebug) << "TextureAtlas : page " << index << " created (" << (linear ? "linear" : "nearest") << ")";
+	}
+
+	Page& page = mPages[index];
+	if (page.pixels == nullptr)
+		page.pixels.reset(new unsigned char[PAGE_SIZE * PAGE_SIZE * 4]());
+
+	const size_t rowSize = width * 4;
+	const size_t pageRowSize = PAGE_SIZE * 4;
+
+	for (int row = 0; row < h; row++)
+	{
+		const unsigned char* src = dataRGBA + row * rowSize;
+		unsigned char* dst = page.pixels.get() + (y + PADDING + row) * pageRowSize + x * 4;
+
+		// Left and right borders repeat the edge pixels
+		memcpy(dst, src, 4);
+		memcpy(dst + 4, src, rowSize);
+		memcpy(dst + 4 + rowSize, src + rowSize - 4, 4);
+	}
+
+	// Top and bottom borders repeat the edge rows
+	unsigned char* pixels = page.pixels.get();
+	memcpy(pixels + y * pageRowSize + x * 4, pixels + (y + 1) * pageRowSize + x * 4, paddedWidth * 4);
+	memcpy(pixels + (y + paddedHeight - 1) * pageRowSize + x * 4, pixels + (y + paddedHeight - 2) * pageRowSize + x * 4, paddedWidth * 4);
+
+	if (y < page.dirtyMinY)
+		page.dirtyMinY = y;
+
+	if (y + paddedHeight > page.dirtyMaxY)
+		page.dirtyMaxY = y + paddedHeight;
+
+	page.regions++;
+
+	uv = Vector4f(
+		(float)(x + PADDING) / PAGE_SIZE,
+		(float)(y + PADDING) / PAGE_SIZE,
+		(float)(x + PADDING + w) / PAGE_SIZE,
+		(float)(y + PADDING + h) / PAGE_SIZE);
+
+	return index;
+}
+
+void TextureAtlas::remove(int index)
+{
+	std::unique_lock<std::mutex> lock(mLock);
+	if (index < 0 || index >= (int)mPages.size())
+		return;
+
+	Page& page = mPages[index];
+	if (--page.regions > 0)
+		return;
+
+	// Empty : the page is packed again from scratch. Its texture is kept, the next upload replaces it.
+	page.pixels.reset();
+	page.shelves.clear();
+	page.nextShelfY = 0;
+	page.dirtyMinY = PAGE_SIZE;
+	page.dirtyMaxY = 0;
+}
+
+bool TextureAtlas::bind(int index)
+{
+	std::unique_lock<std::mutex> lock(mLock);
+	if (index < 0 || index >= (int)mPages.size())
+		return false;
+
+	Page& page = mPages[index];
+	if (page.pixels == nullptr)
+		return false;
+
+	if (page.textureID == 0)
+	{
+		FrameProfiler::PhaseScope profile(FrameProfiler::TEXTURE_UPLOAD);
+		page.textureID = Renderer::createTexture(Renderer::Texture::RGBA, page.linear, false, PAGE_SIZE, PAGE_SIZE, page.pixels.get());
+		page.dirtyMinY = PAGE_SIZE;
+		page.dirtyMaxY = 0;
+	}
+	else if (page.dirtyMinY < page.dirtyMaxY)
+	{
+		// Only the rows of the regions added since the last upload
+		FrameProfiler::PhaseScope profile(FrameProfiler::TEXTURE_UPLOAD);
+		Renderer::updateTexture(page.textureID, Renderer::Texture::RGBA, 0, page.dirtyMinY, PAGE_SIZE, page.dirtyMaxY - page.dirtyMinY, page.pixels.get() + page.dirtyMinY * PAGE_SIZE * 4);
+		page.dirtyMinY = PAGE_SIZE;
+		page.dirtyMaxY = 0;
+	}
+
+	if (page.textureID == 0)
+		return false;
+
+	Renderer::bindTexture(page.textureID);
+	return true;
+}
+
+int TextureAtlas::getPageCount()
+{
+	std::unique_lock<std::mutex> lock(mLock);
+
+	int count = 0;
+	for (auto& page : mPages)
+		if (page.pixels != nullptr)
+			count++;
+
+	return count;
+}
+
+int TextureAtlas::getRegionCount()
+{
+	std::unique_lock<std::mutex> lock(mLock);
+
+	int count = 0;
+	for (auto& page : mPages)
+		count += page.regions;
+
+	return count;
+}
+
+bool TextureAtlas::unload()
+{
+	// The pixels stay in RAM : the pages are uploaded again on their next bind
+	std::unique_lock<std::mutex> lock(mLock);
+	for (auto& page : mPages)
+	{
+		if (page.textureID != 0)
+		{
+			Renderer::destroyTexture(page.textureID);
+			page.textureID = 0;
+		}
+	}
+
+	return false;
+}
+
+void TextureAtlas::reload()
+{
+
+}
@@ -0,0 +1,73 @@
+#include <string>
+#pragma once
+#ifndef ES_CORE_RESOURCES_TEXTURE_ATLAS_H
+#define ES_CORE_RESOURCES_TEXTURE_ATLAS_H
+
+#include "math/Vector4f.h"
+#include "resources/ResourceManager.h"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+//
+// Shared OpenGL pages the small static textures (theme icons, embedded resources, rasterized SVG logos) are packed into,
+// so drawing them doesn't need a texture of their own : consecutive quads of the same page share one bind.
+//
+// Pixels are copied to a CPU side page (shelf packing, with a 1 pixel border repeating the edges against filtering bleed),
+// the page is uploaded on its next bind, on the render thread. add() can then be called from any thread.
+// Regions are not reused one by one : a page is recycled when all its regions are removed.
+//
+class TextureAtlas : public IReloadable
+{
+public:
+	static const int PAGE_SIZE = 1024;
+	static const int MAX_TEXTURE_SIZE = 256; // larger textures keep their own texture
+
+	static std::shared_ptr<TextureAtlas>& getInstance();
+
+	static bool isEligible(size_t width, size_t height) { return width > 0 && height > 0 && width <= MAX_TEXTURE_SIZE && height <= MAX_TEXTURE_SIZE; }
+
+	// Copies the pixels to a page with the same filtering. Returns the page, or -1 if it doesn't fit. uv gets the (u0, v0, u1, v1) texture coordinates of the region in the page.
+	int add(const unsigned char* dataRGBA, size_t width, size_t height, bool linear, Vector4f& uv);
+	void remove(int page);
+
+	// Uploads the page if it changed, and binds it
+	bool bind(int page);
+
+	int getPageCount();
+	int getRegionCount();
+
+	virtual bool unload();
+	virtual void reload();
+
+private:
+	TextureAtlas();
+
+	struct Shelf
+	{
+		int y;
+		int height;
+		int x; // next free column
+	};
+
+	struct Page
+	{
+		Page(bool _linear) : linear(_linear), textureID(0), nextShelfY(0), regions(0), dirtyMinY(PAGE_SIZE), dirtyMaxY(0) { }
+
+		bool				linear;
+		std::unique_ptr<unsigned char[]> pixels; // PAGE_SIZE * PAGE_SIZE RGBA, nullptr while the page is empty
+		unsigned int		textureID;
+		std::vector<Shelf>	shelves;
+		int					nextShelfY;
+		int					regions;
+		int					dirtyMinY; // rows to upload on the next bind
+		int					dirtyMaxY;
+	};
+
+	bool allocate(Page& page, int width, int height, int& x, int& y);
+
+	std::mutex			mLock;
+	std::vector<Page>	mPages;
+};
+
+#endif // ES_CORE_RESOURCES_TEXTURE_ATLAS_H
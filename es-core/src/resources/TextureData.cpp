@@ -2,10 +2,14 @@
 #include "resources/TextureData.h"
 
 #include "math/Misc.h"
+#include "FrameProfiler.h"
 #include "renderers/Renderer.h" 
 #include "resources/ResourceManager.h"
+#include "resources/TextureAtlas.h"
+#include "resources/ThumbnailCache.h"
 #include "ImageIO.h"
 #include "Log.h"
+#include "utils/FileSystemUtil.h"
 #include <nanosvg/nanosvg.h>
 #include <nanosvg/nanosvgrast.h>
 #include <assert.h>
@@ -15,10 +19,24 @@
 
 bool TextureData::OPTIMIZEVRAM = false;
 
+std::atomic<size_t> TextureData::sTotalRAMUsage(0);
+std::atomic<size_t> TextureData::sTotalVRAMUsage(0);
+
 TextureData::TextureData(bool tile, bool linear) : mTile(tile), mLinear(linear), mTextureID(0), mDataRGBA(nullptr), mScalable(false),
 									  mWidth(0), mHeight(0), mSourceWidth(0.0f), mSourceHeight(0.0f), mMaxSize(MaxSizeInfo()), mPackedSize(Vector2i(0,0)), mBaseSize(Vector2i(0, 0))
 {
 	mIsExternalDataRGBA = false;
+	mFormat = Renderer::Texture::RGBA;
+	mLoadQueue = -1;
+	mLoading = false;
+	mLoadQueueSize = 0;
+	mResident = false;
+	mPinned = false;
+	mAtlasable = false;
+	mAtlasPage = -1;
+	mAtlasUV = Vector4f(0, 0, 1, 1);
+	mRAMUsage = 0;
+	mVRAMUsage = 0;
 }
 
 TextureData::~TextureData()
@@ -33,6 +51,29 @@ void TextureData::initFromPath(const std::string& path)
 	mPath = path;
 	// Only textures with paths are reloadable
 	mReloadable = true;
+
+	mPinned = (path.size() > 1 && path[0] == ':' && path[1] == '/') || path.find("/themes/") != std::string::npos;
+}
+
+void TextureData::updateMemoryUsage()
+{
+	size_t size = mWidth * mHeight * (mFormat == Renderer::Texture::RGB565 ? 2 : 4);
+
+	size_t ram = (mDataRGBA != nullptr && !mIsExternalDataRGBA) ? size : 0;
+	if (ram != mRAMUsage)
+	{
+		sTotalRAMUsage -= mRAMUsage;
+		sTotalRAMUsage += ram;
+		mRAMUsage = ram;
+	}
+
+	size_t vram = (mTextureID != 0 || mAtlasPage >= 0) ? size : 0;
+	if (vram != mVRAMUsage)
+	{
+		sTotalVRAMUsage -= mVRAMUsage;
+		sTotalVRAMUsage += vram;
+		mVRAMUsage = vram;
+	}
 }
 
 bool TextureData::initSVGFromMemory(const unsigned char* fileData, size_t length)
@@ -117,6 +158,7 @@ bool TextureData::initSVGFromMemory(const unsigned char* fileData, size_t length
 	ImageIO::flipPixelsVert(dataRGBA, mWidth, mHeight);
 
 	mDataRGBA = dataRGBA;
+	updateMemoryUsage();
 
 	return true;
 }
@@ -156,6 +198,36 @@ bool TextureData::initImageFromMemory(const unsigned char* fileData, size_t leng
 	}
 	
 
+	Vector2i target = getTargetSize();
+
+	unsigned char* imageRGBA = ImageIO::loadFromMemoryRGBA32Ex((const unsigned char*)(fileData), length, width, height, target.x(), target.y(), mMaxSize.externalZoom(), mBaseSize, mPackedSize);
+	if (imageRGBA == NULL)
+	{
+		LOG(LogError) << "Could not initialize texture from memory, invalid data!  (file path: " << mPath << ", data ptr: " << (size_t)fileData << ", reported size: " << length << ")";
+		return false;
+	}
+
+	if (isThumbnailCacheable() && mPackedSize != Vector2i(0, 0))
+	{
+		ThumbnailCache::Image image;
+		image.data = imageRGBA;
+		image.width = width;
+		image.height = height;
+		image.baseSize = mBaseSize;
+		image.packedSize = mPackedSize;
+
+		ThumbnailCache::getInstance()->save(mPath, target.x(), target.y(), mMaxSize.externalZoom(), image);
+	}
+
+	mSourceWidth = (float) width;
+	mSourceHeight = (float) height;
+	mScalable = false;
+
+	return initFromRGBAEx(imageRGBA, width, height);
+}
+
+Vector2i TextureData::getTargetSize()
+{
 	auto x = OPTIMIZEVRAM ? mMaxSize.x() : Renderer::getScreenWidth();
 	if (x > Renderer::getScreenWidth())
 		x = Renderer::getScreenWidth();
@@ -164,18 +236,36 @@ bool TextureData::initImageFromMemory(const unsigned char* fileData, size_t leng
 	if (y > Renderer::getScreenHeight())
 		y = Renderer::getScreenHeight();
 
-	unsigned char* imageRGBA = ImageIO::loadFromMemoryRGBA32Ex((const unsigned char*)(fileData), length, width, height, x, y, mMaxSize.externalZoom(), mBaseSize, mPackedSize);
-	if (imageRGBA == NULL)
+	return Vector2i(x, y);
+}
+
+// Only pictures displayed smaller than the screen go to the thumbnail cache : the others are rarely downscaled
+bool TextureData::isThumbnailCacheable()
+{
+	return OPTIMIZEVRAM && !mPath.empty() && !mMaxSize.empty() && ThumbnailCache::getInstance()->isEnabled();
+}
+
+bool TextureData::initImageFromThumbnailCache()
+{
 	{
-		LOG(LogError) << "Could not initialize texture from memory, invalid data!  (file path: " << mPath << ", data ptr: " << (size_t)fileData << ", reported size: " << length << ")";
-		return false;
+		std::unique_lock<std::mutex> lock(mMutex);
+		if (mDataRGBA)
+			return true;
 	}
 
-	mSourceWidth = (float) width;
-	mSourceHeight = (float) height;
+	Vector2i target = getTargetSize();
+
+	ThumbnailCache::Image image;
+	if (!ThumbnailCache::getInstance()->load(mPath, target.x(), target.y(), mMaxSize.externalZoom(), image))
+		return false;
+
+	mBaseSize = image.baseSize;
+	mPackedSize = image.packedSize;
+	mSourceWidth = (float) image.width;
+	mSourceHeight = (float) image.height;
 	mScalable = false;
 
-	return initFromRGBAEx(imageRGBA, width, height);
+	return initFromRGBAEx(image.data, image.width, image.height);
 }
 
 
@@ -215,6 +305,7 @@ bool TextureData::initFromRGBA(const unsigned char* dataRGBA, size_t width, size
 	memcpy(mDataRGBA, dataRGBA, width * height * 4);
 	mWidth = width;
 	mHeight = height;
+	updateMemoryUsage();
 	return true;
 }
 
@@ -236,11 +327,12 @@ bool TextureData::initFromRGBAEx(unsigned char* dataRGBA, size_t width, size_t h
 	mDataRGBA = dataRGBA;
 	mWidth = width;
 	mHeight = height;
+	updateMemoryUsage();
 
 	return true;
 }
 
-bool TextureData::initFromExternalRGBA(unsigned char* dataRGBA, size_t width, size_t height)
+bool TextureData::initFromExternalPixels(unsigned char* data, size_t width, size_t height, Renderer::Texture::Type format)
 {
 	// If already initialised then don't read again
 	std::unique_lock<std::mutex> lock(mMutex);
@@ -248,14 +340,29 @@ bool TextureData::initFromExternalRGBA(unsigned char* dataRGBA, size_t width, si
 	if (!mIsExternalDataRGBA && mDataRGBA != nullptr)
 		delete[] mDataRGBA;
 
+	bool sameLayout = (mWidth == width && mHeight == height && mFormat == format);
+
 	mIsExternalDataRGBA = true;
-	mDataRGBA = dataRGBA;
+	mDataRGBA = data;
 	mWidth = width;
 	mHeight = height;
+	mFormat = format;
 
 	if (mTextureID != 0)
-		Renderer::updateTexture(mTextureID, Renderer::Texture::RGBA, -1, -1, mWidth, mHeight, mDataRGBA);
+	{
+		FrameProfiler::PhaseScope profile(FrameProfiler::TEXTURE_UPLOAD);
 
+		// Same storage : the texture is only rewritten, not specified again
+		if (sameLayout)
+			Renderer::updateTexture(mTextureID, mFormat, 0, 0, mWidth, mHeight, mDataRGBA);
+		else
+			Renderer::updateTexture(mTextureID, mFormat, -1, -1, mWidth, mHeight, mDataRGBA);
+
+		// The caller reuses its buffer : the texture holds the frame now
+		mDataRGBA = nullptr;
+	}
+
+	updateMemoryUsage();
 	return true;
 }
 
@@ -266,11 +373,23 @@ bool TextureData::load(bool updateCache)
 	// Need to load. See if there is a file
 	if (!mPath.empty())
 	{
+		bool isSvg = mPath.substr(mPath.size() - 4, std::string::npos) == ".svg";
+
+		// Already downscaled pictures don't need the source file at all
+		if (!isSvg && isThumbnailCacheable() && initImageFromThumbnailCache())
+		{
+			if (updateCache)
+				ImageIO::updateImageCache(mPath, Utils::FileSystem::getFileSize(mPath), mBaseSize.x(), mBaseSize.y());
+
+			packIntoAtlas();
+			return true;
+		}
+
 		std::shared_ptr<ResourceManager>& rm = ResourceManager::getInstance();
 
 		const ResourceData& data = rm->getFileData(mPath);
 		// is it an SVG?
-		if (mPath.substr(mPath.size() - 4, std::string::npos) == ".svg")
+		if (isSvg)
 		{
 			mScalable = true; // ??? interest ?
 			retval = initSVGFromMemory((const unsigned char*)data.ptr.get(), data.length);
@@ -280,15 +399,44 @@ bool TextureData::load(bool updateCache)
 
 		if (updateCache && retval)
 			ImageIO::updateImageCache(mPath, data.length, mBaseSize.x(), mBaseSize.y());
+
+		if (retval)
+			packIntoAtlas();
 	}
 
 	return retval;
 }
 
+void TextureData::packIntoAtlas()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	if (!mAtlasable || mTile || mAtlasPage >= 0 || mTextureID != 0 || mDataRGBA == nullptr || mIsExternalDataRGBA || !TextureAtlas::isEligible(mWidth, mHeight))
+		return;
+
+	Vector4f uv;
+	int page = TextureAtlas::getInstance()->add(mDataRGBA, mWidth, mHeight, mLinear, uv);
+	if (page < 0)
+		return;
+
+	// The page keeps the pixels
+	delete[] mDataRGBA;
+	mDataRGBA = nullptr;
+
+	mAtlasPage = page;
+	mAtlasUV = uv;
+	updateMemoryUsage();
+}
+
+Vector4f TextureData::getUVRect()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	return mAtlasUV;
+}
+
 bool TextureData::isLoaded()
 {
 	std::unique_lock<std::mutex> lock(mMutex);
-	if (mDataRGBA || (mTextureID != 0))
+	if (mDataRGBA || (mTextureID != 0) || mAtlasPage >= 0)
 		return true;
 
 	return false;
@@ -298,7 +446,11 @@ bool TextureData::uploadAndBind()
 {
 	// See if it's already been uploaded
 	std::unique_lock<std::mutex> lock(mMutex);
-	if (mTextureID != 0)
+	if (mAtlasPage >= 0)
+	{
+		return TextureAtlas::getInstance()->bind(mAtlasPage);
+	}
+	else if (mTextureID != 0)
 	{
 		Renderer::bindTexture(mTextureID);
 	}
@@ -313,7 +465,11 @@ bool TextureData::uploadAndBind()
 		if ((mWidth == 0) || (mHeight == 0) || (mDataRGBA == nullptr))
 			return false;
 
-		mTextureID = Renderer::createTexture(Renderer::Texture::RGBA, mLinear, mTile, mWidth, mHeight, mDataRGBA);
+		{
+			FrameProfiler::PhaseScope profile(FrameProfiler::TEXTURE_UPLOAD);
+			mTextureID = Renderer::createTexture(mFormat, mLinear, mTile, mWidth, mHeight, mDataRGBA);
+		}
+
 		if (mTextureID)
 		{
 			if (mDataRGBA != nullptr && !mIsExternalDataRGBA)
@@ -321,6 +477,8 @@ bool TextureData::uploadAndBind()
 
 			mDataRGBA = nullptr;
 		}
+
+		updateMemoryUsage();
 	}
 
 	return true;
@@ -333,6 +491,15 @@ void TextureData::releaseVRAM()
 	{
 		Renderer::destroyTexture(mTextureID);
 		mTextureID = 0;
+		updateMemoryUsage();
+	}
+
+	if (mAtlasPage >= 0)
+	{
+		TextureAtlas::getInstance()->remove(mAtlasPage);
+		mAtlasPage = -1;
+		mAtlasUV = Vector4f(0, 0, 1, 1);
+		updateMemoryUsage();
 	}
 }
 
@@ -344,6 +511,7 @@ void TextureData::releaseRAM()
 		delete[] mDataRGBA;
 
 	mDataRGBA = 0;
+	updateMemoryUsage();
 }
 
 size_t TextureData::width()
@@ -400,8 +568,8 @@ void TextureData::setSourceSize(float width, float height)
 
 size_t TextureData::getVRAMUsage()
 {
-	if ((mTextureID != 0) || (mDataRGBA != nullptr))
-		return mWidth * mHeight * 4;
+	if ((mTextureID != 0) || (mDataRGBA != nullptr) || mAtlasPage >= 0)
+		return mWidth * mHeight * (mFormat == Renderer::Texture::RGB565 ? 2 : 4);
 	else
 		return 0;
 }
@@ -2,11 +2,16 @@
 #ifndef ES_CORE_RESOURCES_TEXTURE_DATA_H
 #define ES_CORE_RESOURCES_TEXTURE_DATA_H
 
+#include <atomic>
+#include <list>
+#include <memory>
 #include <mutex>
 #include <string>
 
 #include "math/Vector2f.h"
 #include "math/Vector2i.h"
+#include "math/Vector4f.h"
+#include "renderers/Renderer.h"
 #include "resources/TextureResource.h"
 
 // class TextureResource;
@@ -27,7 +32,8 @@ public:
 	bool initImageFromMemory(const unsigned char* fileData, size_t length);
 	bool initFromRGBA(const unsigned char* dataRGBA, size_t width, size_t height);
 	bool initFromRGBAEx(unsigned char* dataRGBA, size_t width, size_t height);
-	bool initFromExternalRGBA(unsigned char* dataRGBA, size_t width, size_t height);
+	// Pixels owned by the caller (video frames), uploaded in place while the size and format don't change
+	bool initFromExternalPixels(unsigned char* data, size_t width, size_t height, Renderer::Texture::Type format = Renderer::Texture::RGBA);
 
 	// Read the data into memory if necessary
 	bool load(bool updateCache = false);
@@ -49,6 +55,13 @@ public:
 	// Get the amount of VRAM currenty used by this texture
 	size_t getVRAMUsage();
 
+	// Running totals of all the textures : uploaded to VRAM, and decoded in RAM waiting for upload
+	static size_t getTotalVRAMUsage() { return sTotalVRAMUsage; }
+	static size_t getTotalRAMUsage() { return sTotalRAMUsage; }
+
+	// Theme and embedded resource textures are never evicted by the VRAM budget
+	bool isPinned() { return mPinned; }
+
 	size_t width();
 	size_t height();
 	float sourceWidth();
@@ -59,6 +72,12 @@ public:
 
 	bool tiled() { return mTile; }
 
+	// Small textures can be packed into a shared TextureAtlas page when they're loaded. Set before load().
+	void setAtlasable(bool atlasable) { mAtlasable = atlasable; }
+	bool isAtlased() { return mAtlasPage >= 0; }
+	// Texture coordinates of the picture in the bound texture : (0, 0, 1, 1) unless it's in an atlas page
+	Vector4f getUVRect();
+
 	bool isRequiredTextureSizeOk();
 
 	std::string		mPath;
@@ -69,6 +88,16 @@ public:
 	}
 
 private:
+	friend class TextureLoader;
+	friend class TextureDataManager;
+
+	void updateMemoryUsage(); // with mMutex locked
+
+	Vector2i getTargetSize();
+	bool isThumbnailCacheable();
+	bool initImageFromThumbnailCache();
+	void packIntoAtlas();
+
 	std::mutex		mMutex;
 	bool			mTile;
 	bool			mLinear;
@@ -85,6 +114,28 @@ private:
 	MaxSizeInfo		mMaxSize;
 
 	bool			mIsExternalDataRGBA;
+	Renderer::Texture::Type mFormat; // RGB565 only for external pixels
+
+	// TextureLoader queue handle, guarded by the loader lock : O(1) dedup, reprioritization and cancel
+	int				mLoadQueue; // priority queue holding this texture, -1 if not queued
+	bool			mLoading;
+	std::list<std::shared_ptr<TextureData>>::iterator mLoadQueuePosition;
+	size_t			mLoadQueueSize;
+
+	// TextureDataManager LRU handle, guarded by the manager lock
+	bool			mResident;
+	std::list<std::shared_ptr<TextureData>>::iterator mResidentPosition;
+
+	bool			mPinned;
+
+	bool			mAtlasable;
+	int				mAtlasPage; // -1 if the texture has its own
+	Vector4f		mAtlasUV;
+	size_t			mRAMUsage;
+	size_t			mVRAMUsage;
+
+	static std::atomic<size_t> sTotalRAMUsage;
+	static std::atomic<size_t> sTotalVRAMUsage;
 };
 
 #endif // ES_CORE_RESOURCES_TEXTURE_DATA_H
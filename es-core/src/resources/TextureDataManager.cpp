@@ -3,12 +3,13 @@
 
 #include "resources/TextureData.h"
 #include "resources/TextureResource.h"
+#include "Log.h"
 #include "Settings.h"
 #include "utils/StringUtil.h"
 #include "utils/FileSystemUtil.h"
 #include <SDL_timer.h>
 
-TextureDataManager::TextureDataManager()
+TextureDataManager::TextureDataManager() : mEvictionCount(0)
 {
 	unsigned char data[5 * 5 * 4];
 	mBlank = std::shared_ptr<TextureData>(new TextureData(false, false));
@@ -53,6 +54,7 @@ std::shared_ptr<TextureData> TextureDataManager::add(const TextureResource* key,
 	auto it = mTextureLookup.find(key);
 	if (it != mTextureLookup.cend())
 	{
+		unlinkResident(*(*it).second);
 		// Remove the list entry
 		mTextures.erase((*it).second);
 		// And the lookup
@@ -74,6 +76,9 @@ void TextureDataManager::remove(const TextureResource* key)
 	auto it = mTextureLookup.find(key);
 	if (it != mTextureLookup.cend())
 	{
+		// Nobody will display it anymore : don't load it
+		mLoader->remove(*(*it).second);
+		unlinkResident(*(*it).second);
 		// Remove the list entry
 		mTextures.erase((*it).second);
 		// And the lookup
@@ -90,6 +95,15 @@ void TextureDataManager::cancelAsync(const TextureResource* key)
 		mLoader->remove(*(*it).second);
 }
 
+void TextureDataManager::setLoadPriority(const TextureResource* key, TextureLoadPriority priority)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	auto it = mTextureLookup.find(key);
+	if (it != mTextureLookup.cend())
+		mLoader->prioritize(*(*it).second, priority);
+}
+
 std::shared_ptr<TextureData> TextureDataManager::get(const TextureResource* key, bool enableLoading)
 {
 	std::unique_lock<std::mutex> lock(mMutex);
@@ -112,8 +126,12 @@ std::shared_ptr<TextureData> TextureDataManager::get(const TextureResource* key,
 			mTextureLookup[key] = mTextures.cbegin();
 		}
 
+		bool loaded = tex->isLoaded();
+		if (loaded && enableLoading)
+			touch(tex);
+
 		// Make sure it's loaded or queued for loading
-		if (enableLoading && !tex->isLoaded()) // FCATMP
+		if (enableLoading && !loaded) // FCATMP
 		{
 			lock.unlock();
 			load(tex);
@@ -160,14 +178,78 @@ size_t TextureDataManager::getQueueSize()
 	return mLoader->getQueueSize();
 }
 
-bool compareTextures(const std::shared_ptr<TextureData>& first, const std::shared_ptr<TextureData>& second)
-{	
-	bool isResource = first->mPath.rfind(":/") == 0;
-	bool secondIsResource = second->mPath.rfind(":/") == 0;
-	if (isResource && !secondIsResource)
-		return true;
+int TextureDataManager::getPendingLoadCount()
+{
+	return mLoader->getPendingCount();
+}
+
+unsigned int TextureDataManager::getLoadedCount()
+{
+	return mLoader->getLoadedCount();
+}
+
+size_t TextureDataManager::getMemoryUsage()
+{
+	return TextureData::getTotalVRAMUsage() + TextureData::getTotalRAMUsage() + mLoader->getQueueSize();
+}
+
+void TextureDataManager::touch(const std::shared_ptr<TextureData>& tex)
+{
+	if (tex->isPinned())
+		return;
+
+	if (tex->mResident)
+	{
+		if (tex->mResidentPosition != mResident.begin())
+			mResident.splice(mResident.begin(), mResident, tex->mResidentPosition);
+	}
+	else
+	{
+		mResident.push_front(tex);
+		tex->mResident = true;
+	}
+
+	tex->mResidentPosition = mResident.begin();
+}
+
+void TextureDataManager::unlinkResident(const std::shared_ptr<TextureData>& tex)
+{
+	if (!tex->mResident)
+		return;
+
+	tex->mResident = false;
+	mResident.erase(tex->mResidentPosition);
+}
+
+void TextureDataManager::evict(size_t maxSize)
+{
+	// Requests that may never be displayed go first : nothing is decoded yet
+	int dropped = mLoader->clearQueue(TEXTURE_LOAD_SPECULATIVE);
+
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	int count = 0;
+
+	// Entries of textures released elsewhere (or being reloaded) are just unlinked
+	while (!mResident.empty() && getMemoryUsage() >= maxSize)
+	{
+		std::shared_ptr<TextureData> tex = mResident.back();
+		unlinkResident(tex);
+
+		if (tex->isLoaded())
+		{
+			tex->releaseVRAM();
+			tex->releaseRAM();
+			count++;
+		}
+	}
+
+	mEvictionCount += count;
 
-	return false;
+	if (count > 0 || dropped > 0)
+	{
+		LOG(LogDebug) << "TextureDataManager::evict - released " << count << " textures, dropped " << dropped << " speculative loads";
+	}
 }
 
 void TextureDataManager::load(std::shared_ptr<TextureData> tex, bool block)
@@ -186,47 +268,9 @@ void TextureDataManager::load(std::shared_ptr<TextureData> tex, bool block)
 	}
 
 	// Not loaded. Make sure there is room
-	size_t size = TextureResource::getTotalMemUsage();
 	size_t max_texture = (size_t)Settings::getInstance()->getInt("MaxVRAM") * 1024 * 1024;
-
-	if (size >= max_texture)
-	{
-		std::unique_lock<std::mutex> lock(mMutex);
-
-		std::list<std::shared_ptr<TextureData>> orderedTextures(mTextures);
-		orderedTextures.sort(compareTextures);
-
-		for (auto it = orderedTextures.crbegin(); it != orderedTextures.crend(); ++it)
-		{
-			if (size < max_texture)
-				break;
-
-			if ((*it) == tex)
-				continue;
-
-			bool changed = false;
-
-			if ((*it)->isLoaded())
-			{
-				(*it)->releaseVRAM();
-				(*it)->releaseRAM();
-
-				changed = true;
-			}
-
-			// It may be already in the loader queue. In this case it wouldn't have been using
-			// any VRAM yet but it will be. Remove it from the loader queue
-			if (mLoader->remove(*it))
-				changed = true;
-
-			if (changed)
-			{
-				lock.unlock();
-				size = TextureResource::getTotalMemUsage();
-				lock.lock();
-			}
-		}
-	}
+	if (getMemoryUsage() >= max_texture)
+		evict(max_texture);
 
 	if (!block)
 	{
@@ -239,7 +283,7 @@ void TextureDataManager::load(std::shared_ptr<TextureData> tex, bool block)
 	}
 }
 
-TextureLoader::TextureLoader(TextureDataManager* mgr) : mExit(false)
+TextureLoader::TextureLoader(TextureDataManager* mgr) : mQueueSize(0), mLoadingCount(0), mLoadedCount(0), mExit(false)
 {
 	mManager = mgr;
 
@@ -270,72 +314,122 @@ void TextureLoader::threadProc()
 	{
 		// Wait for an event to say there is something in the queue
 		std::unique_lock<std::mutex> lock(mLoaderLock);
-		mEvent.wait(lock, [this]() { return mExit || !mTextureDataQ.empty(); });
+		mEvent.wait(lock, [this]() { return mExit || !mTextureDataQ[TEXTURE_LOAD_VISIBLE].empty() || !mTextureDataQ[TEXTURE_LOAD_PREFETCH].empty() || !mTextureDataQ[TEXTURE_LOAD_SPECULATIVE].empty(); });
 
 		if (mExit)
 			break;
 
-		if (!mTextureDataQ.empty())
-		{
-			std::shared_ptr<TextureData> textureData = mTextureDataQ.front();
-			mTextureDataQ.pop_front();
+		std::shared_ptr<TextureData> textureData;
 
-			mProcessingTextureDataQ.push_back(textureData);
+		for (auto& queue : mTextureDataQ)
+		{
+			if (queue.empty())
+				continue;
 
-			lock.unlock();
+			textureData = queue.front();
+			queue.pop_front();
+			break;
+		}
 
-			if (textureData && !textureData->isLoaded())
-			{
-				std::this_thread::yield();
+		if (textureData == nullptr)
+			continue;
 
-				textureData->load(true);
-				// mManager->onTextureLoaded(textureData);
+		unqueue(textureData);
+		textureData->mLoading = true;
+		mLoadingCount++;
 
-				lock.lock();
-				mProcessingTextureDataQ.remove(textureData);
-				lock.unlock();
-			}
+		lock.unlock();
 
+		if (!textureData->isLoaded())
+		{
 			std::this_thread::yield();
+			textureData->load(true);
+			// mManager->onTextureLoaded(textureData);
 		}
+
+		lock.lock();
+		textureData->mLoading = false;
+		mLoadingCount--;
+		mLoadedCount++;
+		lock.unlock();
+
+		std::this_thread::yield();
 	}
 }
 
-void TextureLoader::load(std::shared_ptr<TextureData> textureData)
+void TextureLoader::load(std::shared_ptr<TextureData> textureData, TextureLoadPriority priority)
 {
 	std::unique_lock<std::mutex> lock(mLoaderLock);
 
-	// Make sure it's not already loaded
-	if (textureData->isLoaded())
+	// If is is currently loading, don't add again
+	if (textureData->mLoading)
 		return;
 
-	// If is is currently loading, don't add again
-	if (std::find(mProcessingTextureDataQ.cbegin(), mProcessingTextureDataQ.cend(), textureData) != mProcessingTextureDataQ.cend())
+	// Already queued : requested again, so it goes back to the start of its queue. Its priority is kept.
+	if (textureData->mLoadQueue >= 0)
+	{
+		auto& queue = mTextureDataQ[textureData->mLoadQueue];
+		if (textureData->mLoadQueuePosition != queue.begin())
+		{
+			queue.splice(queue.begin(), queue, textureData->mLoadQueuePosition);
+			textureData->mLoadQueuePosition = queue.begin();
+		}
+
 		return;
+	}
 
-	// Remove it from the queue if it is already there
-	auto tx = std::find(mTextureDataQ.cbegin(), mTextureDataQ.cend(), textureData);
-	if (tx != mTextureDataQ.cend())
-		mTextureDataQ.erase(tx);
+	// Make sure it's not already loaded
+	if (textureData->isLoaded())
+		return;
 
 	// Put it on the start of the queue as we want the newly requested textures to load first
-	mTextureDataQ.push_front(textureData);
+	auto& queue = mTextureDataQ[priority];
+	queue.push_front(textureData);
+
+	textureData->mLoadQueue = priority;
+	textureData->mLoadQueuePosition = queue.begin();
+
+	// Known when the source size was read before queuing (see TextureResource)
+	textureData->mLoadQueueSize = textureData->mWidth * textureData->mHeight * 4;
+	mQueueSize += textureData->mLoadQueueSize;
+
 	mEvent.notify_one();
 }
 
+bool TextureLoader::prioritize(std::shared_ptr<TextureData> textureData, TextureLoadPriority priority)
+{
+	std::unique_lock<std::mutex> lock(mLoaderLock);
+
+	if (textureData->mLoadQueue < 0)
+		return false;
+
+	// Move it to the start of the queue of its new priority
+	auto& queue = mTextureDataQ[priority];
+	queue.splice(queue.begin(), mTextureDataQ[textureData->mLoadQueue], textureData->mLoadQueuePosition);
+
+	textureData->mLoadQueue = priority;
+	textureData->mLoadQueuePosition = queue.begin();
+	return true;
+}
+
 bool TextureLoader::remove(std::shared_ptr<TextureData> textureData)
 {
 	// Just remove it from the queue so we don't attempt to load it
 	std::unique_lock<std::mutex> lock(mLoaderLock);
 
-	auto tx = std::find(mTextureDataQ.cbegin(), mTextureDataQ.cend(), textureData);
-	if (tx != mTextureDataQ.cend())
-	{
-		mTextureDataQ.erase(tx);
-		return true;
-	}
+	if (textureData->mLoadQueue < 0)
+		return false;
 
-	return false;
+	mTextureDataQ[textureData->mLoadQueue].erase(textureData->mLoadQueuePosition);
+	unqueue(textureData);
+	return true;
+}
+
+void TextureLoader::unqueue(const std::shared_ptr<TextureData>& textureData)
+{
+	mQueueSize -= textureData->mLoadQueueSize;
+	textureData->mLoadQueueSize = 0;
+	textureData->mLoadQueue = -1;
 }
 
 size_t TextureLoader::getQueueSize()
@@ -344,11 +438,18 @@ size_t TextureLoader::getQueueSize()
 
 	// Gets the amount of video memory that will be used once all textures in
 	// the queue are loaded
-	size_t mem = 0;
-	for (auto tex : mTextureDataQ)	
-		mem += tex->width() * tex->height() * 4;
+	return mQueueSize;
+}
 
-	return mem;
+int TextureLoader::getPendingCount()
+{
+	std::unique_lock<std::mutex> lock(mLoaderLock);
+
+	int count = mLoadingCount;
+	for (auto& queue : mTextureDataQ)
+		count += (int)queue.size();
+
+	return count;
 }
 
 void TextureLoader::clearQueue()
@@ -356,7 +457,27 @@ void TextureLoader::clearQueue()
 	std::unique_lock<std::mutex> lock(mLoaderLock);
 
 	// Just abort any waiting texture
-	mTextureDataQ.clear();
+	for (auto& queue : mTextureDataQ)
+	{
+		for (auto tex : queue)
+			unqueue(tex);
+
+		queue.clear();
+	}
+}
+
+int TextureLoader::clearQueue(TextureLoadPriority priority)
+{
+	std::unique_lock<std::mutex> lock(mLoaderLock);
+
+	auto& queue = mTextureDataQ[priority];
+	int count = (int)queue.size();
+
+	for (auto tex : queue)
+		unqueue(tex);
+
+	queue.clear();
+	return count;
 }
 
 void TextureDataManager::clearQueue()
@@ -3,6 +3,7 @@
 #ifndef ES_CORE_RESOURCES_TEXTURE_DATA_MANAGER_H
 #define ES_CORE_RESOURCES_TEXTURE_DATA_MANAGER_H
 
+#include <atomic>
 #include <condition_variable>
 #include <list>
 #include <map>
@@ -16,25 +17,46 @@ class TextureData;
 class TextureResource;
 class TextureDataManager;
 
+enum TextureLoadPriority
+{
+	TEXTURE_LOAD_VISIBLE = 0,		// on screen
+	TEXTURE_LOAD_PREFETCH = 1,		// next items in the scrolling direction
+	TEXTURE_LOAD_SPECULATIVE = 2,	// may be displayed (items behind the cursor...)
+
+	TEXTURE_LOAD_PRIORITY_COUNT
+};
+
+// Loads textures in background threads. Higher priorities are always served first, and in each priority the latest request first.
 class TextureLoader
 {
 public:
 	TextureLoader(TextureDataManager* mgr);
 	~TextureLoader();
 
-	void load(std::shared_ptr<TextureData> textureData);
+	// A texture already queued keeps its priority (only prioritize() changes it) and moves to the start of its queue
+	void load(std::shared_ptr<TextureData> textureData, TextureLoadPriority priority = TEXTURE_LOAD_VISIBLE);
+	bool prioritize(std::shared_ptr<TextureData> textureData, TextureLoadPriority priority);
 	bool remove(std::shared_ptr<TextureData> textureData);
 	void clearQueue();
+	int clearQueue(TextureLoadPriority priority);
 
+	// Estimated size of the queued textures, from their source sizes when they're known. O(1).
 	size_t getQueueSize();
 
+	// Textures queued or being loaded
+	int getPendingCount();
+	// Incremented each time a background load completes, the UI knows something new can be drawn
+	unsigned int getLoadedCount() { return mLoadedCount; }
+
 private:	
 	void threadProc();
 
-	std::list<std::shared_ptr<TextureData>> 										mProcessingTextureDataQ;
+	void unqueue(const std::shared_ptr<TextureData>& textureData); // with mLoaderLock locked
 
-	std::list<std::shared_ptr<TextureData>> 										mTextureDataQ;
-	std::map<TextureData*, std::list<std::shared_ptr<TextureData> >::const_iterator > 	mTextureDataLookup;
+	std::list<std::shared_ptr<TextureData>>		mTextureDataQ[TEXTURE_LOAD_PRIORITY_COUNT];
+	size_t						mQueueSize;
+	int							mLoadingCount;
+	std::atomic<unsigned int>	mLoadedCount;
 
 	std::vector<std::thread>	mThreads;	
 	std::mutex					mLoaderLock;
@@ -58,6 +80,10 @@ private:
 // to releaseRAM() which frees the memory buffer if the texture can be reloaded from
 // disk if needed again
 //
+// Memory is accounted with running counters (see TextureData::getTotalVRAMUsage). When a load
+// goes over the MaxVRAM budget, the speculative loads are dropped, then the least recently bound
+// textures are released, each in O(1). Pinned textures (theme, resources) are never released.
+//
 class TextureDataManager
 {
 public:
@@ -71,6 +97,7 @@ public:
 	// will be deleted when the other thread has finished with it
 	void remove(const TextureResource* key);
 	void cancelAsync(const TextureResource* key);
+	void setLoadPriority(const TextureResource* key, TextureLoadPriority priority);
 
 	std::shared_ptr<TextureData> get(const TextureResource* key, bool enableLoading = true);
 	bool bind(const TextureResource* key);
@@ -82,6 +109,8 @@ public:
 	// Get the total size of all load-pending textures in the queue - these will
 	// be committed to VRAM as the queue is processed
 	size_t  getQueueSize();
+	int		getPendingLoadCount();
+	unsigned int getLoadedCount();
 	// Load a texture, freeing resources as necessary to make space
 	void load(std::shared_ptr<TextureData> tex, bool block = false);
 
@@ -89,9 +118,21 @@ public:
 
 	void onTextureLoaded(std::shared_ptr<TextureData> tex);
 
+	// Textures + load queue, O(1)
+	size_t	getMemoryUsage();
+	unsigned int getEvictionCount() { return mEvictionCount; }
+
 private:
+	void evict(size_t maxSize);
+	void touch(const std::shared_ptr<TextureData>& tex); // with mMutex locked
+	void unlinkResident(const std::shared_ptr<TextureData>& tex); // with mMutex locked
+
 	std::mutex					mMutex;
 
+	// Loaded textures that may be released, most recently bound first
+	std::list<std::shared_ptr<TextureData>>	mResident;
+	std::atomic<unsigned int>				mEvictionCount;
+
 	std::list<std::shared_ptr<TextureData> >												mTextures;
 	std::map<const TextureResource*, std::list<std::shared_ptr<TextureData> >::const_iterator > 	mTextureLookup;
 	std::shared_ptr<TextureData>															mBlank;
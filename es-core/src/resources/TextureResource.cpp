@@ -7,6 +7,7 @@
 #include "utils/AsyncUtil.h"
 #include <cstring>
 #include "Log.h"
+#include "Settings.h"
 
 TextureDataManager		TextureResource::sTextureDataManager;
 
@@ -66,6 +67,8 @@ TextureResource::TextureResource(const std::string& path, bool tile, bool linear
 			data = mTextureData;
 			data->setMaxSize(maxSize);
 			data->initFromPath(path);
+			// Static textures are never unloaded : the small ones can share an atlas page
+			data->setAtlasable(!tile && Settings::getInstance()->getBool("TextureAtlas"));
 			// Load it so we can read the width/height
 			data->load();
 
@@ -102,9 +105,9 @@ void TextureResource::onTextureLoaded(std::shared_ptr<TextureData> tex)
 	mSourceSize = Vector2f(tex->sourceWidth(), tex->sourceHeight());
 }
 
-void TextureResource::initFromExternalPixels(unsigned char* dataRGBA, size_t width, size_t height)
+void TextureResource::initFromExternalPixels(unsigned char* data, size_t width, size_t height, Renderer::Texture::Type format)
 {
-	mTextureData->initFromExternalRGBA(dataRGBA, width, height);
+	mTextureData->initFromExternalPixels(data, width, height, format);
 
 	// Cache the image dimensions
 	mSize = Vector2i((int)width, (int)height);
@@ -157,6 +160,14 @@ bool TextureResource::isTiled() const
 	return data->tiled();
 }
 
+Vector4f TextureResource::getUVRect() const
+{
+	if (mTextureData != nullptr)
+		return mTextureData->getUVRect();
+
+	return Vector4f(0, 0, 1, 1);
+}
+
 bool TextureResource::bind()
 {
 	if (mTextureData != nullptr)
@@ -181,6 +192,12 @@ void TextureResource::cancelAsync(std::shared_ptr<TextureResource> texture)
 		sTextureDataManager.cancelAsync(texture.get());
 }
 
+void TextureResource::setLoadPriority(std::shared_ptr<TextureResource> texture, TextureLoadPriority priority)
+{
+	if (texture != nullptr && texture->mTextureData == nullptr)
+		sTextureDataManager.setLoadPriority(texture.get(), priority);
+}
+
 std::shared_ptr<TextureResource> TextureResource::get(const std::string& path, bool tile, bool linear, bool forceLoad, bool dynamic, bool asReloadable, MaxSizeInfo maxSize)
 {
 	std::shared_ptr<ResourceManager>& rm = ResourceManager::getInstance();
@@ -292,18 +309,28 @@ bool TextureResource::isLoaded() const
 
 size_t TextureResource::getTotalMemUsage()
 {
-	size_t total = 0;
-	// Count up all textures that manage their own texture data
-	for (auto tex : sAllTextures)
-	{
-		if (tex->mTextureData != nullptr)
-			total += tex->mTextureData->getVRAMUsage();
-	}
-	// Now get the committed memory from the manager
-	total += sTextureDataManager.getCommittedSize();
-	// And the size of the loading queue
-	total += sTextureDataManager.getQueueSize();
-	return total;
+	// Running counters of all the texture data (managed or not) + the size of the loading queue
+	return sTextureDataManager.getMemoryUsage();
+}
+
+size_t TextureResource::getLoadQueueSize()
+{
+	return sTextureDataManager.getQueueSize();
+}
+
+unsigned int TextureResource::getEvictionCount()
+{
+	return sTextureDataManager.getEvictionCount();
+}
+
+int TextureResource::getPendingLoadCount()
+{
+	return sTextureDataManager.getPendingLoadCount();
+}
+
+unsigned int TextureResource::getAsyncLoadCount()
+{
+	return sTextureDataManager.getLoadedCount();
 }
 
 size_t TextureResource::getTotalTextureSize()
@@ -329,6 +356,10 @@ bool TextureResource::unload()
 	else
 		data = mTextureData;
 
+	// The atlas uploads its pages again by itself : keeping the region keeps the texture coordinates valid
+	if (data != nullptr && data->isAtlased())
+		return false;
+
 	if (data != nullptr && data->isLoaded())
 	{
 		data->releaseVRAM();
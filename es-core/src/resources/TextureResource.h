@@ -4,6 +4,8 @@
 
 #include "math/Vector2i.h"
 #include "math/Vector2f.h"
+#include "math/Vector4f.h"
+#include "renderers/Renderer.h"
 #include "resources/ResourceManager.h"
 #include "resources/TextureDataManager.h"
 #include <set>
@@ -53,9 +55,10 @@ protected:
 public:
 	static std::shared_ptr<TextureResource> get(const std::string& path, bool tile = false, bool linear = false, bool forceLoad = false, bool dynamic = true, bool asReloadable = true, MaxSizeInfo maxSize = MaxSizeInfo());
 	static void cancelAsync(std::shared_ptr<TextureResource> texture);
+	static void setLoadPriority(std::shared_ptr<TextureResource> texture, TextureLoadPriority priority);
 
 	void initFromPixels(const unsigned char* dataRGBA, size_t width, size_t height);
-	void initFromExternalPixels(unsigned char* dataRGBA, size_t width, size_t height);
+	void initFromExternalPixels(unsigned char* data, size_t width, size_t height, Renderer::Texture::Type format = Renderer::Texture::RGBA);
 	virtual void initFromMemory(const char* file, size_t length);
 
 	// For scalable source images in textures we want to set the resolution to rasterize at
@@ -70,7 +73,15 @@ public:
 	const Vector2i getSize() const;
 	bool bind();
 
+	// Texture coordinates of the picture in the texture bound by bind() : (u0, v0, u1, v1), not (0, 0, 1, 1) when it's packed in a TextureAtlas page.
+	// Can change when the texture is rasterized again.
+	Vector4f getUVRect() const;
+
 	static size_t getTotalMemUsage(); // returns an approximation of total VRAM used by textures (in bytes)
+	static size_t getLoadQueueSize(); // estimated bytes of the textures waiting to be loaded
+	static unsigned int getEvictionCount(); // textures released to stay in the MaxVRAM budget
+	static int getPendingLoadCount(); // textures queued or being loaded in the background
+	static unsigned int getAsyncLoadCount(); // changes each time a background load completes
 	static size_t getTotalTextureSize(); // returns the number of bytes that would be used if all textures were in memory
 	static void resetCache();
 
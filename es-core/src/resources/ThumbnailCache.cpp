@@ -0,0 +1,485 @@
+#include <string>
+#include "resources/ThumbnailCache.h"
+
+#include "resources/ResourceManager.h"
+#include "utils/FileSystemUtil.h"
+#include "utils/StringUtil.h"
+#include "ImageIO.h"
+#include "Log.h"
+#include "Settings.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <string.h>
+
+#if WIN32
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
+
+#define THUMBNAIL_MAGIC		0x43545345 // "ESTC"
+#define THUMBNAIL_VERSION	1
+#define MAX_TARGETS_PER_FOLDER	3
+#define TOUCH_DELAY			3600 // seconds. Entries used more recently keep their file date, to spare writes on SD cards.
+
+struct ThumbnailHeader
+{
+	unsigned int magic;
+	unsigned int version;
+	unsigned int width;
+	unsigned int height;
+	unsigned int baseWidth;
+	unsigned int baseHeight;
+	unsigned int packedWidth;
+	unsigned int packedHeight;
+	unsigned int keyLength;
+};
+
+ThumbnailCache* ThumbnailCache::getInstance()
+{
+	static ThumbnailCache instance;
+	return &instance;
+}
+
+ThumbnailCache::ThumbnailCache() : mLoaded(false), mTotalSize(0), mTargetsDirty(false), mPrewarmCancel(false)
+{
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+	cancelPrewarm();
+}
+
+bool ThumbnailCache::isEnabled()
+{
+	return Settings::getInstance()->getInt("ThumbnailCacheSize") > 0;
+}
+
+std::string ThumbnailCache::getCachePath()
+{
+	return Utils::FileSystem::getHomePath() + "/.emulationstation/thumbnails";
+}
+
+std::string ThumbnailCache::getKey(const std::string& path, const Target& target)
+{
+	// Embedded resources and SVGs are never decoded this way
+	if (path.empty() || path[0] == ':' || Utils::String::toLower(Utils::FileSystem::getExtension(path)) == ".svg")
+		return "";
+
+	size_t size = Utils::FileSystem::getFileSize(path);
+	if (size == 0)
+		return "";
+
+	return path + "|" + std::to_string(size) + "|" + std::to_string((long long)Utils::FileSystem::getFileModificationTime(path)) + "|" +
+		std::to_string(target.width) + "x" + std::to_string(target.height) + (target.externalZoom ? "z" : "");
+}
+
+std::string ThumbnailCache::getFileName(const std::string& key)
+{
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%016llx.rgba", (unsigned long long) std::hash<std::string>()(key));
+	return buffer;
+}
+
+void ThumbnailCache::ensureLoaded()
+{
+	if (mLoaded)
+		return;
+
+	mLoaded = true;
+
+	std::string cachePath = getCachePath();
+	if (!Utils::FileSystem::isDirectory(cachePath))
+	{
+		Utils::FileSystem::createDirectory(cachePath);
+		return;
+	}
+
+	for (auto file : Utils::FileSystem::getDirInfo(cachePath))
+	{
+		if (file.directory)
+			continue;
+
+		std::string ext = Utils::FileSystem::getExtension(file.path);
+		if (ext == ".tmp")
+		{
+			Utils::FileSystem::removeFile(file.path); // interrupted save
+			continue;
+		}
+
+		if (ext != ".rgba")
+			continue;
+
+		Entry entry;
+		entry.size = Utils::FileSystem::getFileSize(file.path);
+		entry.lastUse = Utils::FileSystem::getFileModificationTime(file.path);
+		entry.touched = false;
+
+		mEntries[Utils::FileSystem::getFileName(file.path)] = entry;
+		mTotalSize += entry.size;
+	}
+
+	loadTargets();
+
+	LOG(LogDebug) << "ThumbnailCache : " << mEntries.size() << " entries, " << (mTotalSize / 1024) << " KB";
+}
+
+bool ThumbnailCache::load(const std::string& path, int maxWidth, int maxHeight, bool externalZoom, Image& image)
+{
+	if (!isEnabled())
+		return false;
+
+	Target target(maxWidth, maxHeight, externalZoom);
+
+	std::string key = getKey(path, target);
+	if (key.empty())
+		return false;
+
+	addTarget(path, target);
+
+	std::string fileName = getFileName(key);
+	std::string fullPath = getCachePath() + "/" + fileName;
+
+	bool touch = false;
+
+	{
+		std::unique_lock<std::mutex> lock(mLock);
+		ensureLoaded();
+
+		auto it = mEntries.find(fileName);
+		if (it == mEntries.cend())
+			return false;
+
+		time_t now = time(NULL);
+		touch = !it->second.touched && now - it->second.lastUse > TOUCH_DELAY;
+
+		it->second.lastUse = now;
+		it->second.touched = true;
+	}
+
+	bool ok = false;
+
+	FILE* file = fopen(fullPath.c_str(), "rb");
+	if (file != nullptr)
+	{
+		ThumbnailHeader header;
+		if (fread(&header, sizeof(header), 1, file) == 1 && header.magic == THUMBNAIL_MAGIC && header.version == THUMBNAIL_VERSION &&
+			header.keyLength == key.size() && header.width > 0 && header.height > 0)
+		{
+			std::string storedKey(header.keyLength, '\0');
+			if (fread(&storedKey[0], 1, header.keyLength, file) == header.keyLength && storedKey == key)
+			{
+				size_t length = (size_t)header.width * header.height * 4;
+
+				// The pixels are the rest of the file : a corrupt size is a miss, not a huge allocation
+				long pixelsStart = ftell(file);
+				long fileSize = (pixelsStart >= 0 && fseek(file, 0, SEEK_END) == 0) ? ftell(file) : -1;
+				bool sizeMatches = fileSize >= 0 && (size_t)(fileSize - pixelsStart) == length && fseek(file, pixelsStart, SEEK_SET) == 0;
+
+				unsigned char* data = sizeMatches ? new unsigned char[length] : nullptr;
+				if (data != nullptr && fread(data, 1, length, file) == length)
+				{
+					image.data = data;
+					image.width = header.width;
+					image.height = header.height;
+					image.baseSize = Vector2i(header.baseWidth, header.baseHeight);
+					image.packedSize = Vector2i(header.packedWidth, header.packedHeight);
+					ok = true;
+				}
+				else
+					delete[] data;
+			}
+		}
+
+		fclose(file);
+	}
+
+	if (!ok)
+	{
+		// Truncated, outdated or hash collision : the next save replaces it
+		std::unique_lock<std::mutex> lock(mLock);
+
+		auto it = mEntries.find(fileName);
+		if (it != mEntries.cend())
+		{
+			mTotalSize -= it->second.size;
+			mEntries.erase(it);
+		}
+
+		Utils::FileSystem::removeFile(fullPath);
+		return false;
+	}
+
+	if (touch)
+		utime(fullPath.c_str(), NULL);
+
+	return true;
+}
+
+void ThumbnailCache::save(const std::string& path, int maxWidth, int maxHeight, bool externalZoom, const Image& image)
+{
+	if (image.data == nullptr || image.width == 0 || image.height == 0 || image.packedSize == Vector2i(0, 0))
+		return;
+
+	size_t maxSize = (size_t)Settings::getInstance()->getInt("ThumbnailCacheSize") * 1024 * 1024;
+	if (maxSize == 0)
+		return;
+
+	std::string key = getKey(path, Target(maxWidth, maxHeight, externalZoom));
+	if (key.empty())
+		return;
+
+	std::string fileName = getFileName(key);
+	std::string fullPath = getCachePath() + "/" + fileName;
+
+	{
+		std::unique_lock<std::mutex> lock(mLock);
+		ensureLoaded();
+
+		if (mEntries.find(fileName) != mEntries.cend())
+			return;
+	}
+
+	ThumbnailHeader header;
+	header.magic = THUMBNAIL_MAGIC;
+	header.version = THUMBNAIL_VERSION;
+	header.width = (unsigned int)image.width;
+	header.height = (unsigned int)image.height;
+	header.baseWidth = image.baseSize.x();
+	header.baseHeight = image.baseSize.y();
+	header.packedWidth = image.packedSize.x();
+	header.packedHeight = image.packedSize.y();
+	header.keyLength = (unsigned int)key.size();
+
+	size_t length = image.width * image.height * 4;
+
+	// Written aside then renamed : the loader threads and the prewarm pass can save the same entry
+	std::string tmpPath = fullPath + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+
+	FILE* file = fopen(tmpPath.c_str(), "wb");
+	if (file == nullptr)
+		return;
+
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(key.c_str(), 1, key.size(), file) == key.size() && fwrite(image.data, 1, length, file) == length;
+	fclose(file);
+
+#if WIN32
+	if (written)
+		Utils::FileSystem::removeFile(fullPath);
+#endif
+
+	if (!written || rename(tmpPath.c_str(), fullPath.c_str()) != 0)
+	{
+		Utils::FileSystem::removeFile(tmpPath);
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(mLock);
+
+	Entry entry;
+	entry.size = sizeof(header) + key.size() + length;
+	entry.lastUse = time(NULL);
+	entry.touched = true;
+
+	auto it = mEntries.find(fileName);
+	if (it != mEntries.cend())
+		mTotalSize -= it->second.size;
+
+	mEntries[fileName] = entry;
+	mTotalSize += entry.size;
+
+	if (mTotalSize > maxSize)
+		evict(maxSize - maxSize / 10); // some headroom, so the next saves don't evict again
+}
+
+void ThumbnailCache::evict(size_t maxSize)
+{
+	std::vector<std::map<std::string, Entry>::iterator> entries;
+	entries.reserve(mEntries.size());
+
+	for (auto it = mEntries.begin(); it != mEntries.end(); ++it)
+		entries.push_back(it);
+
+	std::sort(entries.begin(), entries.end(), [](const std::map<std::string, Entry>::iterator& a, const std::map<std::string, Entry>::iterator& b) { return a->second.lastUse < b->second.lastUse; });
+
+	std::string cachePath = getCachePath();
+
+	int count = 0;
+	for (auto it : entries)
+	{
+		if (mTotalSize <= maxSize)
+			break;
+
+		Utils::FileSystem::removeFile(cachePath + "/" + it->first);
+		mTotalSize -= it->second.size;
+		mEntries.erase(it);
+		count++;
+	}
+
+	LOG(LogDebug) << "ThumbnailCache : evicted " << count << " entries";
+}
+
+void ThumbnailCache::addTarget(const std::string& path, const Target& target)
+{
+	std::string folder = Utils::FileSystem::getParent(path);
+
+	std::unique_lock<std::mutex> lock(mLock);
+
+	auto& targets = mTargets[folder];
+	if (!targets.empty() && targets.front() == target)
+		return;
+
+	auto it = std::find(targets.begin(), targets.end(), target);
+	if (it != targets.end())
+		targets.erase(it);
+
+	targets.insert(targets.begin(), target);
+	if (targets.size() > MAX_TARGETS_PER_FOLDER)
+		targets.resize(MAX_TARGETS_PER_FOLDER);
+
+	mTargetsDirty = true;
+}
+
+void ThumbnailCache::loadTargets()
+{
+	std::ifstream f((getCachePath() + "/targets.cfg").c_str());
+	if (f.fail())
+		return;
+
+	std::string line;
+	while (std::getline(f, line))
+	{
+		auto splits = Utils::String::split(line, '|');
+		if (splits.size() != 4)
+			continue;
+
+		auto& targets = mTargets[splits[0]];
+		if (targets.size() < MAX_TARGETS_PER_FOLDER)
+			targets.push_back(Target(atoi(splits[1].c_str()), atoi(splits[2].c_str()), splits[3] == "1"));
+	}
+
+	f.close();
+}
+
+void ThumbnailCache::saveTargets()
+{
+	std::unique_lock<std::mutex> lock(mLock);
+	if (!mTargetsDirty)
+		return;
+
+	std::ofstream f((getCachePath() + "/targets.cfg").c_str(), std::ios::binary);
+	if (f.fail())
+		return;
+
+	for (auto it : mTargets)
+		for (auto target : it.second)
+			f << it.first << "|" << target.width << "|" << target.height << "|" << (target.externalZoom ? "1" : "0") << "\n";
+
+	f.close();
+	mTargetsDirty = false;
+}
+
+void ThumbnailCache::prewarm(const std::vector<std::string>& paths)
+{
+	cancelPrewarm();
+
+	if (!isEnabled() || paths.empty())
+		return;
+
+	mPrewarmCancel = false;
+	mPrewarmThread = std::thread(&ThumbnailCache::prewarmProc, this, paths);
+}
+
+void ThumbnailCache::cancelPrewarm()
+{
+	mPrewarmCancel = true;
+
+	if (mPrewarmThread.joinable())
+		mPrewarmThread.join();
+}
+
+void ThumbnailCache::prewarmProc(std::vector<std::string> paths)
+{
+	{
+		std::unique_lock<std::mutex> lock(mLock);
+		ensureLoaded();
+	}
+
+	int count = 0;
+
+	for (auto path : paths)
+	{
+		if (mPrewarmCancel)
+			break;
+
+		std::vector<Target> targets;
+
+		{
+			std::unique_lock<std::mutex> lock(mLock);
+
+			auto it = mTargets.find(Utils::FileSystem::getParent(path));
+			if (it == mTargets.cend())
+				continue;
+
+			targets = it->second;
+		}
+
+		std::shared_ptr<unsigned char> data; // read once for all the targets
+		size_t length = 0;
+
+		for (auto target : targets)
+		{
+			if (mPrewarmCancel)
+				break;
+
+			std::string key = getKey(path, target);
+			if (key.empty())
+				break;
+
+			{
+				std::unique_lock<std::mutex> lock(mLock);
+				if (mEntries.find(getFileName(key)) != mEntries.cend())
+					continue;
+			}
+
+			// Pictures that already fit are never rescaled, so they have no entry
+			unsigned int width, height;
+			if (ImageIO::getImageSize(path.c_str(), &width, &height) && (int)width <= target.width && (int)height <= target.height)
+				continue;
+
+			if (data == nullptr)
+			{
+				const ResourceData& fileData = ResourceManager::getInstance()->getFileData(path);
+				if (fileData.ptr == nullptr)
+					break;
+
+				data = fileData.ptr;
+				length = fileData.length;
+			}
+
+			Image image;
+			image.data = ImageIO::loadFromMemoryRGBA32Ex((const unsigned char*)data.get(), length, image.width, image.height,
+				target.width, target.height, target.externalZoom, image.baseSize, image.packedSize);
+
+			if (image.data == nullptr)
+				break;
+
+			save(path, target.width, target.height, target.externalZoom, image);
+			delete[] image.data;
+			count++;
+		}
+	}
+
+	if (count > 0)
+	{
+		LOG(LogInfo) << "ThumbnailCache : prewarmed " << count << " pictures";
+	}
+}
+
+void ThumbnailCache::shutdown()
+{
+	cancelPrewarm();
+	saveTargets();
+}
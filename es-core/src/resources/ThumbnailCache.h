@@ -0,0 +1,99 @@
+#include <string>
+#pragma once
+#ifndef ES_CORE_RESOURCES_THUMBNAIL_CACHE_H
+#define ES_CORE_RESOURCES_THUMBNAIL_CACHE_H
+
+#include "math/Vector2i.h"
+#include <atomic>
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//
+// On-disk store of the downscaled RGBA pixels of pictures that are displayed smaller than they are (OptimizeVRAM).
+// Entries are keyed by source path, source size, source modification time and target size, so reading one replaces
+// the full resolution decode + rescale of TextureData::load.
+//
+// The cache lives in ~/.emulationstation/thumbnails, its total size is bounded by the "ThumbnailCacheSize" setting (MB, 0 disables it)
+// and the least recently used entries are evicted first.
+// The target sizes requested for each media folder are remembered, so prewarm() can build the missing entries of a whole system in the background.
+//
+class ThumbnailCache
+{
+public:
+	struct Image
+	{
+		Image() : data(nullptr), width(0), height(0) { }
+
+		unsigned char*	data; // allocated with new[], owned by the caller
+		size_t			width;
+		size_t			height;
+		Vector2i		baseSize;
+		Vector2i		packedSize;
+	};
+
+	static ThumbnailCache* getInstance();
+
+	bool isEnabled();
+
+	// Returns false if there's no valid entry for this source and target size
+	bool load(const std::string& path, int maxWidth, int maxHeight, bool externalZoom, Image& image);
+	void save(const std::string& path, int maxWidth, int maxHeight, bool externalZoom, const Image& image);
+
+	// Builds the missing entries of 'paths' with the target sizes their folders were last displayed with. Replaces a running pass.
+	void prewarm(const std::vector<std::string>& paths);
+	void cancelPrewarm();
+
+	// Waits for the prewarm pass and saves the known target sizes
+	void shutdown();
+
+private:
+	ThumbnailCache();
+	~ThumbnailCache();
+
+	struct Target
+	{
+		Target() : width(0), height(0), externalZoom(false) { }
+		Target(int w, int h, bool zoom) : width(w), height(h), externalZoom(zoom) { }
+
+		bool operator==(const Target& other) const { return width == other.width && height == other.height && externalZoom == other.externalZoom; }
+
+		int		width;
+		int		height;
+		bool	externalZoom;
+	};
+
+	struct Entry
+	{
+		size_t	size;
+		time_t	lastUse;
+		bool	touched;
+	};
+
+	std::string getCachePath();
+	std::string getKey(const std::string& path, const Target& target);
+	std::string getFileName(const std::string& key);
+
+	void ensureLoaded();
+	void loadTargets();
+	void saveTargets();
+	void addTarget(const std::string& path, const Target& target);
+
+	void evict(size_t maxSize);
+	void prewarmProc(std::vector<std::string> paths);
+
+	std::mutex	mLock;
+	bool		mLoaded;
+	size_t		mTotalSize;
+
+	std::map<std::string, Entry>				mEntries; // by file name
+	std::map<std::string, std::vector<Target>>	mTargets; // by source folder, most recent first
+	bool										mTargetsDirty;
+
+	std::thread			mPrewarmThread;
+	std::atomic<bool>	mPrewarmCancel;
+};
+
+#endif // ES_CORE_RESOURCES_THUMBNAIL_CACHE_H
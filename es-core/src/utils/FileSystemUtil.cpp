@@ -4,6 +4,7 @@
 #include "utils/FileSystemUtil.h"
 #include "utils/StringUtil.h"
 
+#include "Log.h"
 #include "Settings.h"
 #include <sys/stat.h>
 #include <string.h>
@@ -26,6 +27,14 @@
 #include <unistd.h>
 #include <mutex>
 #endif // _WIN32
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <fstream>
 #include <sstream>
 
@@ -35,7 +44,11 @@ namespace Utils
 	{
 		static std::string homePath;
 		static std::string exePath;
-		
+
+		#define FILE_CACHE_SHARDS 32
+
+		struct FileCacheShard;
+
 		struct FileCache
 		{
 			FileCache() {}
@@ -93,8 +106,6 @@ namespace Utils
 			{
 				int ret = stat64(key.c_str(), info);
 
-				std::unique_lock<std::mutex> lock(mFileCacheMutex);
-
 				FileCache cache(ret == 0, false);
 				if (cache.exists)
 				{
@@ -104,82 +115,330 @@ namespace Utils
 #endif
 				}
 
-				mFileCache[key] = cache;
+				add(key, cache);
 
 				return ret;
 			}
 
-			static void add(const std::string& key, FileCache cache)
+			static void add(const std::string& key, FileCache cache);
+			// Copies the entry, another thread can remove it as soon as the shard is unlocked
+			static bool get(const std::string& key, FileCache& cache);
+			static void remove(const std::string& key);
+			static void resetCache();
+			static size_t size();
+
+			static void setEnabled(bool value) { mEnabled = value; }
+
+			static std::atomic<size_t> mHits;
+			static std::atomic<size_t> mMisses;
+			static std::atomic<size_t> mContentions;
+
+		private:
+			static FileCacheShard& getShard(const std::string& key);
+			static std::unique_lock<std::mutex> lockShard(FileCacheShard& shard);
+
+			static bool watchParent(const std::string& key);
+
+			static FileCacheShard mShards[FILE_CACHE_SHARDS];
+			static std::atomic<bool> mEnabled;
+		};
+
+		// The loader threads hit different shards most of the time, and hold a shard only for one hash lookup
+		struct FileCacheShard
+		{
+			std::mutex lock;
+			std::unordered_map<std::string, FileCache> entries;
+		};
+
+		FileCacheShard FileCache::mShards[FILE_CACHE_SHARDS];
+		std::atomic<bool> FileCache::mEnabled(false);
+		std::atomic<size_t> FileCache::mHits(0);
+		std::atomic<size_t> FileCache::mMisses(0);
+		std::atomic<size_t> FileCache::mContentions(0);
+
+		FileCacheShard& FileCache::getShard(const std::string& key)
+		{
+			return mShards[std::hash<std::string>()(key) % FILE_CACHE_SHARDS];
+		}
+
+		std::unique_lock<std::mutex> FileCache::lockShard(FileCacheShard& shard)
+		{
+			std::unique_lock<std::mutex> lock(shard.lock, std::try_to_lock);
+			if (!lock.owns_lock())
+			{
+				mContentions++;
+				lock.lock();
+			}
+
+			return lock;
+		}
+
+		void FileCache::add(const std::string& key, FileCache cache)
+		{
+			if (!mEnabled)
+				return;
+
+			// Watched : an entry is only kept if the changes of its folder are reported
+			if (!watchParent(key))
+				return;
+
+			FileCacheShard& shard = getShard(key);
+			std::unique_lock<std::mutex> lock = lockShard(shard);
+			shard.entries[key] = cache;
+		}
+
+		bool FileCache::get(const std::string& key, FileCache& cache)
+		{
+			if (!mEnabled)
+				return false;
+
+			{
+				FileCacheShard& shard = getShard(key);
+				std::unique_lock<std::mutex> lock = lockShard(shard);
+
+				auto it = shard.entries.find(key);
+				if (it != shard.entries.cend())
+				{
+					mHits++;
+					cache = it->second;
+					return true;
+				}
+			}
+
+			// The whole folder was listed : what isn't in it doesn't exist
+			std::string listed = Utils::FileSystem::getParent(key) + "/*";
+
+			bool parentListed = false;
+			{
+				FileCacheShard& shard = getShard(listed);
+				std::unique_lock<std::mutex> lock = lockShard(shard);
+				parentListed = shard.entries.find(listed) != shard.entries.cend();
+			}
+
+			if (parentListed)
 			{
-				if (!mEnabled)
-					return;
+				mHits++;
+				cache = FileCache(false, false);
+				add(key, cache);
+				return true;
+			}
+
+			mMisses++;
+			return false;
+		}
+
+		void FileCache::remove(const std::string& key)
+		{
+			FileCacheShard& shard = getShard(key);
+			std::unique_lock<std::mutex> lock = lockShard(shard);
+			shard.entries.erase(key);
+		}
 
-				std::unique_lock<std::mutex> lock(mFileCacheMutex);
-				mFileCache[key] = cache;
+		void FileCache::resetCache()
+		{
+			for (auto& shard : mShards)
+			{
+				std::unique_lock<std::mutex> lock = lockShard(shard);
+				shard.entries.clear();
 			}
+		}
 
-			static FileCache* get(const std::string& key)
+		size_t FileCache::size()
+		{
+			size_t count = 0;
+			for (auto& shard : mShards)
 			{
-				if (!mEnabled)
-					return nullptr;
+				std::unique_lock<std::mutex> lock = lockShard(shard);
+				count += shard.entries.size();
+			}
+
+			return count;
+		}
+
+#if defined(__linux__)
+		// inotify : the entries of the folders that change are dropped, so the cache can stay enabled for the whole run
+		static int								sWatchFd = -1;
+		static std::atomic<bool>				sWatchRunning(false);
+		static std::thread						sWatchThread;
+		static std::mutex						sWatchLock;
+		static std::unordered_map<int, std::string>	sWatchedFolders; // watch descriptor -> folder
+		static std::unordered_set<std::string>	sWatchedPaths;
+		static FileSystemCacheActivator*		sWatchActivator = nullptr;
+
+		bool FileCache::watchParent(const std::string& key)
+		{
+			if (sWatchFd < 0)
+				return true;
+
+			std::string folder = Utils::FileSystem::getParent(key);
 
-				std::unique_lock<std::mutex> lock(mFileCacheMutex);
+			std::unique_lock<std::mutex> lock(sWatchLock);
+			if (sWatchedPaths.find(folder) != sWatchedPaths.cend())
+				return true;
 
-				auto it = mFileCache.find(key);
-				if (it != mFileCache.cend())
-					return &it->second;
+			int wd = inotify_add_watch(sWatchFd, folder.c_str(), IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR);
+			if (wd < 0)
+				return false; // missing folder, or out of watches
 
-				it = mFileCache.find(Utils::FileSystem::getParent(key)+"/*");
-				if (it != mFileCache.cend())
+			sWatchedFolders[wd] = folder;
+			sWatchedPaths.insert(folder);
+			return true;
+		}
+
+		static void watchFileCache()
+		{
+			// Aligned for the inotify_event structures
+			char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+			while (sWatchRunning)
+			{
+				struct pollfd fd;
+				fd.fd = sWatchFd;
+				fd.events = POLLIN;
+
+				if (poll(&fd, 1, 250) <= 0)
+					continue;
+
+				ssize_t length = read(sWatchFd, buffer, sizeof(buffer));
+				for (ssize_t i = 0; i < length; )
 				{
-					mFileCache[key] = FileCache(false, false);
-					return &mFileCache[key];
-				}				
+					const struct inotify_event* event = (const struct inotify_event*)(buffer + i);
+					i += sizeof(struct inotify_event) + event->len;
+
+					if (event->mask & IN_Q_OVERFLOW)
+					{
+						// Events lost : start over
+						FileCache::resetCache();
+						continue;
+					}
+
+					std::string folder;
+					{
+						std::unique_lock<std::mutex> lock(sWatchLock);
+
+						auto it = sWatchedFolders.find(event->wd);
+						if (it == sWatchedFolders.cend())
+							continue;
+
+						folder = it->second;
+
+						if (event->mask & IN_IGNORED)
+						{
+							sWatchedPaths.erase(folder);
+							sWatchedFolders.erase(it);
+						}
+					}
+
+					if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_UNMOUNT | IN_IGNORED))
+					{
+						// A whole tree gone or unmounted, or a folder no longer watched : its entries could stay wrong forever
+						FileCache::resetCache();
+						continue;
+					}
 
-				return nullptr;
+					// The listing of the folder is incomplete now, and the entry of the file wrong
+					FileCache::remove(folder + "/*");
+					if (event->len > 0)
+						FileCache::remove(folder + "/" + event->name);
+				}
 			}
+		}
 
-			static void resetCache()
+		bool enableFileCacheWatch()
+		{
+			if (sWatchFd >= 0)
+				return true;
+
+			sWatchFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+			if (sWatchFd < 0)
 			{
-				std::unique_lock<std::mutex> lock(mFileCacheMutex);
-				mFileCache.clear();
+				LOG(LogWarning) << "FileSystem : inotify is not available, the stat cache is only used while loading";
+				return false;
 			}
 
-			static void setEnabled(bool value) { mEnabled = value; }
+			sWatchRunning = true;
+			sWatchThread = std::thread(watchFileCache);
 
-		private:
-			static std::map<std::string, FileCache> mFileCache;
-			static std::mutex mFileCacheMutex;
-			static bool mEnabled;
-		};
+			// Keeps the cache enabled. What was cached before isn't watched.
+			sWatchActivator = new FileSystemCacheActivator();
+			FileCache::resetCache();
+			return true;
+		}
 
-		std::map<std::string, FileCache> FileCache::mFileCache;
-		std::mutex FileCache::mFileCacheMutex;
-		bool FileCache::mEnabled = false;
+		void disableFileCacheWatch()
+		{
+			if (sWatchFd < 0)
+				return;
+
+			sWatchRunning = false;
+			if (sWatchThread.joinable())
+				sWatchThread.join();
+
+			delete sWatchActivator;
+			sWatchActivator = nullptr;
+
+			close(sWatchFd);
+			sWatchFd = -1;
+
+			std::unique_lock<std::mutex> lock(sWatchLock);
+			sWatchedFolders.clear();
+			sWatchedPaths.clear();
+		}
+
+		// Stops the thread on the exit paths that skip disableFileCacheWatch(), before its std::thread is destroyed
+		static struct FileCacheWatchGuard
+		{
+			~FileCacheWatchGuard() { disableFileCacheWatch(); }
+		} sWatchGuard;
+#else
+		bool FileCache::watchParent(const std::string& key)
+		{
+			return true;
+		}
+
+		bool enableFileCacheWatch()
+		{
+			return false;
+		}
+
+		void disableFileCacheWatch()
+		{
+
+		}
+#endif
+
+		FileCacheStatistics getFileCacheStatistics()
+		{
+			FileCacheStatistics stats;
+			stats.hits = FileCache::mHits;
+			stats.misses = FileCache::mMisses;
+			stats.contentions = FileCache::mContentions;
+			stats.entries = FileCache::size();
+			return stats;
+		}
 
 		FileSystemCacheActivator::FileSystemCacheActivator()
 		{
-			if (mReferenceCount == 0)
+			if (mReferenceCount++ == 0)
 			{
 				FileCache::setEnabled(true);
 				FileCache::resetCache();
 			}
-
-			mReferenceCount++;
 		}
 
 		FileSystemCacheActivator::~FileSystemCacheActivator()
 		{
-			mReferenceCount--;
-
-			if (mReferenceCount <= 0)
+			if (--mReferenceCount <= 0)
 			{
+				FileCacheStatistics stats = getFileCacheStatistics();
+				LOG(LogDebug) << "FileSystem cache : " << stats.hits << " hits, " << stats.misses << " misses, " << stats.contentions << " contended locks, " << stats.entries << " entries";
+
 				FileCache::setEnabled(false);
 				FileCache::resetCache();
 			}
 		}
 
-		int FileSystemCacheActivator::mReferenceCount = 0;
+		std::atomic<int> FileSystemCacheActivator::mReferenceCount(0);
 			   
 		fileList getDirInfo(const std::string& _path/*, const bool _recursive*/)
 		{
@@ -881,9 +1140,9 @@ namespace Utils
 			if (_path.empty())
 				return false;
 
-			auto it = FileCache::get(_path);
-			if (it != nullptr)
-				return it->exists;
+			FileCache it;
+			if (FileCache::get(_path, it))
+				return it.exists;
 
 #ifdef WIN32			
 			DWORD dwAttr = GetFileAttributes(_path.c_str());
@@ -916,6 +1175,21 @@ namespace Utils
 			return 0;
 		}
 
+		time_t getFileModificationTime(const std::string& _path)
+		{
+			if (!exists(_path))
+				return 0;
+
+			std::string path = getGenericPath(_path);
+			struct stat64 info;
+
+			// check if stat64 succeeded
+			if ((stat64(path.c_str(), &info) == 0))
+				return info.st_mtime;
+
+			return 0;
+		}
+
 		bool isAbsolute(const std::string& _path)
 		{
 			if (_path.size() >= 2 && _path[0] == ':' && _path[1] == '/')
@@ -933,9 +1207,9 @@ namespace Utils
 
 		bool isRegularFile(const std::string& _path)
 		{
-			auto it = FileCache::get(_path);
-			if (it != nullptr)
-				return it->exists && !it->directory && !it->isSymLink;
+			FileCache it;
+			if (FileCache::get(_path, it))
+				return it.exists && !it.directory && !it.isSymLink;
 
 			std::string path = getGenericPath(_path);
 			struct stat64 info;
@@ -954,9 +1228,9 @@ namespace Utils
 			if (_path.empty())
 				return false;
 				
-			auto it = FileCache::get(_path);
-			if (it != nullptr && !it->isSymLink)
-				return it->exists && it->directory;
+			FileCache it;
+			if (FileCache::get(_path, it) && !it.isSymLink)
+				return it.exists && it.directory;
 
 #ifdef WIN32
 			DWORD dwAttr = GetFileAttributes(_path.c_str());
@@ -980,9 +1254,9 @@ namespace Utils
 			if (_path.empty())
 				return false;
 
-			auto it = FileCache::get(_path);
-			if (it != nullptr)
-				return it->exists && it->isSymLink;
+			FileCache it;
+			if (FileCache::get(_path, it))
+				return it.exists && it.isSymLink;
 				
 			std::string path = getGenericPath(_path);
 
@@ -1009,9 +1283,9 @@ namespace Utils
 			if (_path.empty())
 				return false;
 				
-			auto it = FileCache::get(_path);
-			if (it != nullptr)
-				return it->exists && it->hidden;
+			FileCache it;
+			if (FileCache::get(_path, it))
+				return it.exists && it.hidden;
 
 			std::string path = getGenericPath(_path);
 
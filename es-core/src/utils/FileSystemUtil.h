@@ -2,6 +2,8 @@
 #ifndef ES_CORE_UTILS_FILE_SYSTEM_UTIL_H
 #define ES_CORE_UTILS_FILE_SYSTEM_UTIL_H
 
+#include <atomic>
+#include <ctime>
 #include <list>
 #include <string>
 #include <vector>
@@ -37,6 +39,7 @@ namespace Utils
 		bool        createDirectory    (const std::string& _path);
 		bool        exists             (const std::string& _path);
 		size_t		getFileSize(const std::string& _path);
+		time_t		getFileModificationTime(const std::string& _path);
 		bool        isAbsolute         (const std::string& _path);
 		bool        isRegularFile      (const std::string& _path);
 		bool        isDirectory        (const std::string& _path);
@@ -60,6 +63,8 @@ namespace Utils
 		void		writeAllText	   (const std::string fileName, const std::string text);
 		bool		copyFile(const std::string src, const std::string dst);
 
+		// Caches exists/isDirectory/... results while at least one activator lives (the gamelists loading).
+		// A folder listed by getDirInfo/getDirContent also answers for the files it doesn't contain.
 		class FileSystemCacheActivator
 		{
 		public:
@@ -67,8 +72,23 @@ namespace Utils
 			~FileSystemCacheActivator();			
 
 		private:
-			static int mReferenceCount;
+			static std::atomic<int> mReferenceCount;
 		};
+
+		// Keeps the cache enabled until disableFileCacheWatch(), the entries of the folders that change being dropped (inotify).
+		// Returns false where it's not supported (the cache then only lives with the activators).
+		bool        enableFileCacheWatch ();
+		void        disableFileCacheWatch();
+
+		struct FileCacheStatistics
+		{
+			size_t hits;
+			size_t misses;
+			size_t contentions; // lookups that waited for another thread
+			size_t entries;
+		};
+
+		FileCacheStatistics getFileCacheStatistics();
 		
 	} // FileSystem::
 
@@ -0,0 +1,486 @@
+#include <string>
+#include "utils/PixelUtil.h"
+
+#include <string.h>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PIXEL_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define PIXEL_NEON 1
+#include <arm_neon.h>
+#if defined(__linux__) && !defined(__aarch64__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+#endif
+
+namespace Utils
+{
+	namespace Pixel
+	{
+		// (x * a + 127) / 255, as the SIMD versions round it
+		static inline unsigned char mulAlpha(unsigned int x, unsigned int a)
+		{
+			unsigned int t = x * a + 128;
+			return (unsigned char)((t + (t >> 8)) >> 8);
+
+		} // mulAlpha
+
+//////////////////////////////////////////////////////////////////////////
+
+		static void swapRedBlueScalar(const unsigned char* src, unsigned char* dst, size_t count)
+		{
+			const unsigned int* in  = (const unsigned int*)src;
+			unsigned int*       out = (unsigned int*)dst;
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				const unsigned int c = in[i];
+				out[i] = (c & 0xFF00FF00) | ((c & 0xFF) << 16) | ((c >> 16) & 0xFF);
+			}
+
+		} // swapRedBlueScalar
+
+		static void swapRedBlue565Scalar(unsigned char* pixels, size_t count)
+		{
+			unsigned short* px = (unsigned short*)pixels;
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				const unsigned short c = px[i];
+				px[i] = (unsigned short)((c & 0x07E0) | (c << 11) | (c >> 11));
+			}
+
+		} // swapRedBlue565Scalar
+
+		static void swapRowsScalar(unsigned char* a, unsigned char* b, size_t size)
+		{
+			unsigned char temp[256];
+
+			while (size > 0)
+			{
+				const size_t chunk = size < sizeof(temp) ? size : sizeof(temp);
+				memcpy(temp, a, chunk);
+				memcpy(a, b, chunk);
+				memcpy(b, temp, chunk);
+
+				a += chunk;
+				b += chunk;
+				size -= chunk;
+			}
+
+		} // swapRowsScalar
+
+		static void premultiplyAlphaScalar(unsigned char* pixels, size_t count)
+		{
+			for (size_t i = 0; i < count; ++i, pixels += 4)
+			{
+				const unsigned int a = pixels[3];
+				pixels[0] = mulAlpha(pixels[0], a);
+				pixels[1] = mulAlpha(pixels[1], a);
+				pixels[2] = mulAlpha(pixels[2], a);
+			}
+
+		} // premultiplyAlphaScalar
+
+		// One destination row of an exact halving, from two source rows
+		static void halveRowScalar(const unsigned char* row0, const unsigned char* row1, unsigned char* dst, size_t dstWidth)
+		{
+			for (size_t x = 0; x < dstWidth; ++x, row0 += 8, row1 += 8, dst += 4)
+				for (int c = 0; c < 4; ++c)
+					dst[c] = (unsigned char)((row0[c] + row0[c + 4] + row1[c] + row1[c + 4] + 2) >> 2);
+
+		} // halveRowScalar
+
+//////////////////////////////////////////////////////////////////////////
+
+#if PIXEL_SSE2
+		static void swapRedBlueSSE2(const unsigned char* src, unsigned char* dst, size_t count)
+		{
+			const __m128i maskAG = _mm_set1_epi32((int)0xFF00FF00);
+			const __m128i maskRB = _mm_set1_epi32(0x00FF00FF);
+
+			size_t i = 0;
+			for (; i + 4 <= count; i += 4)
+			{
+				const __m128i c  = _mm_loadu_si128((const __m128i*)(src + i * 4));
+				const __m128i rb = _mm_and_si128(c, maskRB);
+				const __m128i br = _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16));
+				_mm_storeu_si128((__m128i*)(dst + i * 4), _mm_or_si128(_mm_and_si128(c, maskAG), br));
+			}
+
+			swapRedBlueScalar(src + i * 4, dst + i * 4, count - i);
+
+		} // swapRedBlueSSE2
+
+		static void swapRedBlue565SSE2(unsigned char* pixels, size_t count)
+		{
+			const __m128i maskG = _mm_set1_epi16(0x07E0);
+
+			size_t i = 0;
+			for (; i + 8 <= count; i += 8)
+			{
+				const __m128i c = _mm_loadu_si128((const __m128i*)(pixels + i * 2));
+				const __m128i rb = _mm_or_si128(_mm_slli_epi16(c, 11), _mm_srli_epi16(c, 11));
+				_mm_storeu_si128((__m128i*)(pixels + i * 2), _mm_or_si128(_mm_and_si128(c, maskG), rb));
+			}
+
+			swapRedBlue565Scalar(pixels + i * 2, count - i);
+
+		} // swapRedBlue565SSE2
+
+		static void swapRowsSSE2(unsigned char* a, unsigned char* b, size_t size)
+		{
+			size_t i = 0;
+			for (; i + 16 <= size; i += 16)
+			{
+				const __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+				const __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+				_mm_storeu_si128((__m128i*)(a + i), vb);
+				_mm_storeu_si128((__m128i*)(b + i), va);
+			}
+
+			swapRowsScalar(a + i, b + i, size - i);
+
+		} // swapRowsSSE2
+
+		// 2 pixels as 16 bits lanes
+		static inline __m128i premultiply2SSE2(__m128i px)
+		{
+			// Alpha of each pixel in its 4 lanes, and 255 in the alpha lane so alpha is kept
+			__m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(px, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			alpha = _mm_or_si128(_mm_and_si128(alpha, _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1)), _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0));
+
+			__m128i t = _mm_add_epi16(_mm_mullo_epi16(px, alpha), _mm_set1_epi16(128));
+			return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+
+		} // premultiply2SSE2
+
+		static void premultiplyAlphaSSE2(unsigned char* pixels, size_t count)
+		{
+			const __m128i zero = _mm_setzero_si128();
+
+			size_t i = 0;
+			for (; i + 4 <= count; i += 4)
+			{
+				const __m128i c  = _mm_loadu_si128((const __m128i*)(pixels + i * 4));
+				const __m128i lo = premultiply2SSE2(_mm_unpacklo_epi8(c, zero));
+				const __m128i hi = premultiply2SSE2(_mm_unpackhi_epi8(c, zero));
+				_mm_storeu_si128((__m128i*)(pixels + i * 4), _mm_packus_epi16(lo, hi));
+			}
+
+			premultiplyAlphaScalar(pixels + i * 4, count - i);
+
+		} // premultiplyAlphaSSE2
+
+		static void halveRowSSE2(const unsigned char* row0, const unsigned char* row1, unsigned char* dst, size_t dstWidth)
+		{
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i two  = _mm_set1_epi16(2);
+
+			size_t x = 0;
+			for (; x + 2 <= dstWidth; x += 2)
+			{
+				// 4 source pixels of each row -> 2 destination pixels
+				const __m128i r0 = _mm_loadu_si128((const __m128i*)(row0 + x * 8));
+				const __m128i r1 = _mm_loadu_si128((const __m128i*)(row1 + x * 8));
+
+				const __m128i lo  = _mm_add_epi16(_mm_unpacklo_epi8(r0, zero), _mm_unpacklo_epi8(r1, zero)); // p0, p1
+				const __m128i hi  = _mm_add_epi16(_mm_unpackhi_epi8(r0, zero), _mm_unpackhi_epi8(r1, zero)); // p2, p3
+				const __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));   // p0 + p1, p2 + p3
+
+				_mm_storel_epi64((__m128i*)(dst + x * 4), _mm_packus_epi16(_mm_srli_epi16(_mm_add_epi16(sum, two), 2), zero));
+			}
+
+			halveRowScalar(row0 + x * 8, row1 + x * 8, dst + x * 4, dstWidth - x);
+
+		} // halveRowSSE2
+#endif // PIXEL_SSE2
+
+//////////////////////////////////////////////////////////////////////////
+
+#if PIXEL_NEON
+		static void swapRedBlueNEON(const unsigned char* src, unsigned char* dst, size_t count)
+		{
+			size_t i = 0;
+			for (; i + 16 <= count; i += 16)
+			{
+				uint8x16x4_t c = vld4q_u8(src + i * 4);
+				const uint8x16_t r = c.val[0];
+				c.val[0] = c.val[2];
+				c.val[2] = r;
+				vst4q_u8(dst + i * 4, c);
+			}
+
+			swapRedBlueScalar(src + i * 4, dst + i * 4, count - i);
+
+		} // swapRedBlueNEON
+
+		static void swapRedBlue565NEON(unsigned char* pixels, size_t count)
+		{
+			const uint16x8_t maskG = vdupq_n_u16(0x07E0);
+
+			size_t i = 0;
+			for (; i + 8 <= count; i += 8)
+			{
+				const uint16x8_t c = vld1q_u16((const uint16_t*)(pixels + i * 2));
+				const uint16x8_t rb = vorrq_u16(vshlq_n_u16(c, 11), vshrq_n_u16(c, 11));
+				vst1q_u16((uint16_t*)(pixels + i * 2), vorrq_u16(vandq_u16(c, maskG), rb));
+			}
+
+			swapRedBlue565Scalar(pixels + i * 2, count - i);
+
+		} // swapRedBlue565NEON
+
+		static void swapRowsNEON(unsigned char* a, unsigned char* b, size_t size)
+		{
+			size_t i = 0;
+			for (; i + 16 <= size; i += 16)
+			{
+				const uint8x16_t va = vld1q_u8(a + i);
+				const uint8x16_t vb = vld1q_u8(b + i);
+				vst1q_u8(a + i, vb);
+				vst1q_u8(b + i, va);
+			}
+
+			swapRowsScalar(a + i, b + i, size - i);
+
+		} // swapRowsNEON
+
+		static inline uint8x8_t mulAlphaNEON(uint8x8_t x, uint8x8_t a)
+		{
+			const uint16x8_t t = vmull_u8(x, a);
+			return vraddhn_u16(t, vrshrq_n_u16(t, 8));
+
+		} // mulAlphaNEON
+
+		static void premultiplyAlphaNEON(unsigned char* pixels, size_t count)
+		{
+			size_t i = 0;
+			for (; i + 8 <= count; i += 8)
+			{
+				uint8x8x4_t c = vld4_u8(pixels + i * 4);
+				c.val[0] = mulAlphaNEON(c.val[0], c.val[3]);
+				c.val[1] = mulAlphaNEON(c.val[1], c.val[3]);
+				c.val[2] = mulAlphaNEON(c.val[2], c.val[3]);
+				vst4_u8(pixels + i * 4, c);
+			}
+
+			premultiplyAlphaScalar(pixels + i * 4, count - i);
+
+		} // premultiplyAlphaNEON
+
+		static void halveRowNEON(const unsigned char* row0, const unsigned char* row1, unsigned char* dst, size_t dstWidth)
+		{
+			size_t x = 0;
+			for (; x + 8 <= dstWidth; x += 8)
+			{
+				// 16 source pixels of each row -> 8 destination pixels
+				const uint8x16x4_t r0 = vld4q_u8(row0 + x * 8);
+				const uint8x16x4_t r1 = vld4q_u8(row1 + x * 8);
+
+				uint8x8x4_t out;
+				for (int c = 0; c < 4; ++c)
+					out.val[c] = vrshrn_n_u16(vaddq_u16(vpaddlq_u8(r0.val[c]), vpaddlq_u8(r1.val[c])), 2);
+
+				vst4_u8(dst + x * 4, out);
+			}
+
+			halveRowScalar(row0 + x * 8, row1 + x * 8, dst + x * 4, dstWidth - x);
+
+		} // halveRowNEON
+#endif // PIXEL_NEON
+
+//////////////////////////////////////////////////////////////////////////
+
+		struct Kernels
+		{
+			void (*swapRedBlue)     (const unsigned char* src, unsigned char* dst, size_t count);
+			void (*swapRedBlue565)  (unsigned char* pixels, size_t count);
+			void (*swapRows)        (unsigned char* a, unsigned char* b, size_t size);
+			void (*premultiplyAlpha)(unsigned char* pixels, size_t count);
+			void (*halveRow)        (const unsigned char* row0, const unsigned char* row1, unsigned char* dst, size_t dstWidth);
+		};
+
+		static bool isSupported(Implementation implementation)
+		{
+			switch (implementation)
+			{
+			case SCALAR:
+				return true;
+
+#if PIXEL_SSE2
+			case SSE2:
+#if defined(__GNUC__) && !defined(__x86_64__)
+				return __builtin_cpu_supports("sse2");
+#else
+				return true; // part of x86-64
+#endif
+#endif
+
+#if PIXEL_NEON
+			case NEON:
+#if defined(__linux__) && !defined(__aarch64__)
+				return (getauxval(AT_HWCAP) & HWCAP_NEON) != 0;
+#else
+				return true; // part of ARMv8
+#endif
+#endif
+
+			default:
+				return false;
+			}
+
+		} // isSupported
+
+		static Kernels getKernels(Implementation implementation)
+		{
+			switch (implementation)
+			{
+#if PIXEL_SSE2
+			case SSE2: return { swapRedBlueSSE2, swapRedBlue565SSE2, swapRowsSSE2, premultiplyAlphaSSE2, halveRowSSE2 };
+#endif
+#if PIXEL_NEON
+			case NEON: return { swapRedBlueNEON, swapRedBlue565NEON, swapRowsNEON, premultiplyAlphaNEON, halveRowNEON };
+#endif
+			default:   return { swapRedBlueScalar, swapRedBlue565Scalar, swapRowsScalar, premultiplyAlphaScalar, halveRowScalar };
+			}
+
+		} // getKernels
+
+		// Function statics : images can be loaded before the static initialization of this file
+		static Implementation& currentImplementation()
+		{
+			static Implementation implementation = isSupported(NEON) ? NEON : isSupported(SSE2) ? SSE2 : SCALAR;
+			return implementation;
+
+		} // currentImplementation
+
+		static Kernels& currentKernels()
+		{
+			static Kernels kernels = getKernels(currentImplementation());
+			return kernels;
+
+		} // currentKernels
+
+//////////////////////////////////////////////////////////////////////////
+
+		Implementation getImplementation()
+		{
+			return currentImplementation();
+
+		} // getImplementation
+
+		const char* getImplementationName(Implementation implementation)
+		{
+			switch (implementation)
+			{
+			case SSE2: return "sse2";
+			case NEON: return "neon";
+			default:   return "scalar";
+			}
+
+		} // getImplementationName
+
+		bool setImplementation(Implementation implementation)
+		{
+			if (!isSupported(implementation))
+				return false;
+
+			currentImplementation() = implementation;
+			currentKernels()        = getKernels(implementation);
+			return true;
+
+		} // setImplementation
+
+		void swapRedBlue(const unsigned char* src, unsigned char* dst, size_t count)
+		{
+			currentKernels().swapRedBlue(src, dst, count);
+
+		} // swapRedBlue
+
+		void swapRedBlue565(unsigned char* pixels, size_t count)
+		{
+			currentKernels().swapRedBlue565(pixels, count);
+
+		} // swapRedBlue565
+
+		void flipVertical(unsigned char* pixels, size_t width, size_t height)
+		{
+			const size_t rowSize = width * 4;
+
+			for (size_t y = 0; y < height / 2; ++y)
+				currentKernels().swapRows(pixels + y * rowSize, pixels + (height - 1 - y) * rowSize, rowSize);
+
+		} // flipVertical
+
+		void premultiplyAlpha(unsigned char* pixels, size_t count)
+		{
+			currentKernels().premultiplyAlpha(pixels, count);
+
+		} // premultiplyAlpha
+
+		void boxDownscale(const unsigned char* src, size_t srcWidth, size_t srcHeight, size_t srcPitch, unsigned char* dst, size_t dstWidth, size_t dstHeight)
+		{
+			if (dstWidth == 0 || dstHeight == 0 || dstWidth > srcWidth || dstHeight > srcHeight)
+				return;
+
+			if (srcWidth == dstWidth * 2 && srcHeight == dstHeight * 2)
+			{
+				for (size_t y = 0; y < dstHeight; ++y)
+					currentKernels().halveRow(src + y * 2 * srcPitch, src + (y * 2 + 1) * srcPitch, dst + y * dstWidth * 4, dstWidth);
+
+				return;
+			}
+
+			// Columns of each destination pixel, and the sums of its channels over the rows of the current destination row
+			std::vector<size_t>       columns(dstWidth + 1);
+			std::vector<unsigned int> sums(dstWidth * 4);
+
+			for (size_t x = 0; x <= dstWidth; ++x)
+				columns[x] = x * srcWidth / dstWidth;
+
+			for (size_t y = 0; y < dstHeight; ++y)
+			{
+				const size_t firstRow = y * srcHeight / dstHeight;
+				const size_t lastRow  = (y + 1) * srcHeight / dstHeight;
+
+				memset(sums.data(), 0, sums.size() * sizeof(unsigned int));
+
+				for (size_t row = firstRow; row < lastRow; ++row)
+				{
+					const unsigned char* in = src + row * srcPitch;
+
+					for (size_t x = 0; x < dstWidth; ++x)
+					{
+						unsigned int* sum = &sums[x * 4];
+						for (size_t column = columns[x]; column < columns[x + 1]; ++column)
+						{
+							const unsigned char* px = in + column * 4;
+							sum[0] += px[0];
+							sum[1] += px[1];
+							sum[2] += px[2];
+							sum[3] += px[3];
+						}
+					}
+				}
+
+				unsigned char* out = dst + y * dstWidth * 4;
+
+				for (size_t x = 0; x < dstWidth; ++x)
+				{
+					const unsigned int area = (unsigned int)((columns[x + 1] - columns[x]) * (lastRow - firstRow));
+					for (int c = 0; c < 4; ++c)
+						out[x * 4 + c] = (unsigned char)((sums[x * 4 + c] + area / 2) / area);
+				}
+			}
+
+		} // boxDownscale
+
+	} // Pixel::
+
+} // Utils::
@@ -0,0 +1,44 @@
+#include <string>
+#pragma once
+#ifndef ES_CORE_UTILS_PIXEL_UTIL_H
+#define ES_CORE_UTILS_PIXEL_UTIL_H
+
+#include <stddef.h>
+
+namespace Utils
+{
+	//
+	// 32 bits pixel kernels, with NEON (ARM) and SSE2 (x86) versions of the hot loops. The implementation is chosen once,
+	// on the first call, from what the CPU supports ; the scalar one gives the same results.
+	// Pixels are 4 bytes (2 for the 565 ones), rows are tightly packed unless a pitch is given. Source and destination can be the same buffer where noted.
+	//
+	namespace Pixel
+	{
+		enum Implementation
+		{
+			SCALAR,
+			SSE2,
+			NEON
+		};
+
+		Implementation getImplementation();
+		const char*    getImplementationName(Implementation implementation);
+
+		// Forces an implementation (es-bench compares them), returns false if the CPU doesn't support it
+		bool           setImplementation    (Implementation implementation);
+
+		// BGRA <-> RGBA, in place if src == dst
+		void swapRedBlue     (const unsigned char* src, unsigned char* dst, size_t count);
+		void swapRedBlue565  (unsigned char* pixels, size_t count); // 16 bits pixels, in place
+		void flipVertical    (unsigned char* pixels, size_t width, size_t height);
+		void premultiplyAlpha(unsigned char* pixels, size_t count); // RGBA or BGRA, alpha last
+
+		// Average of the source pixels each destination pixel covers (dstWidth <= srcWidth, dstHeight <= srcHeight).
+		// Exact halvings use the SIMD kernels.
+		void boxDownscale    (const unsigned char* src, size_t srcWidth, size_t srcHeight, size_t srcPitch, unsigned char* dst, size_t dstWidth, size_t dstHeight);
+
+	} // Pixel::
+
+} // Utils::
+
+#endif // ES_CORE_UTILS_PIXEL_UTIL_H
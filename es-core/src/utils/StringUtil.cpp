@@ -482,6 +482,34 @@ namespace Utils
 			}
 		}
 
+		std::u32string ignoreCaseKey(const std::string& _string)
+		{
+			std::u32string key;
+			key.reserve(_string.length());
+
+			size_t pos = 0;
+			while (pos < _string.length())
+			{
+				char c = _string[pos];
+				int u;
+
+				if ((c & 0x80) == 0)
+				{
+					u = (c >= 'a' && c <= 'z') ? c - 0x20 : c;
+					pos++;
+				}
+				else
+					u = toupperUnicode(chars2Unicode(_string, pos));
+
+				if (u == 0)
+					break;
+
+				key.push_back((char32_t)u);
+			}
+
+			return key;
+		}
+
 		stringVector commaStringToVector(const std::string& _string)
 		{
 			stringVector vector;
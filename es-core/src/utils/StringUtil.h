@@ -31,6 +31,7 @@ namespace Utils
 		std::vector<std::string> splitAny(const std::string& s, const std::string& seperator);
 		std::string join(const std::vector<std::string>& items, std::string separator);
         int			compareIgnoreCase(const std::string& name1, const std::string& name2);
+		std::u32string ignoreCaseKey	(const std::string& _string); // comparing two keys gives the same order as compareIgnoreCase
 
 		// for Korean text input
 		const std::vector<const char*> KOREAN_CHOSUNG_LIST = { "ㄱ", "ㄲ", "ㄴ", "ㄷ", "ㄸ", "ㄹ", "ㅁ", "ㅂ", "ㅃ", "ㅅ", "ㅆ", "ㅇ", "ㅈ", "ㅉ", "ㅊ", "ㅋ", "ㅌ", "ㅍ", "ㅎ" };
@@ -1,94 +1,255 @@
 #include <string>
 #include "ThreadPool.h"
 
+#include "Settings.h"
+
 #if WIN32
 #include <Windows.h>
 #endif
 
 namespace Utils
 {
-	ThreadPool::ThreadPool() : mRunning(true), mWaiting(false), mNumWork(0)
-	{
-		size_t num_threads = std::thread::hardware_concurrency() * 2;
+	static thread_local ThreadPool* tCurrentPool = nullptr;
+	static thread_local size_t tWorkerIndex = 0;
 
-		auto doWork = [&](size_t id)
-		{
-#if WIN32
-			auto mask = (static_cast<DWORD_PTR>(1) << id);
-			SetThreadAffinityMask(GetCurrentThread(), mask);
-#endif
+	ThreadPool::ThreadPool(int threadCount) : mRunning(true), mQueuedCount(0), mNextQueue(0)
+	{
+		size_t num_threads = threadCount > 0 ? (size_t)threadCount : (size_t)std::thread::hardware_concurrency();
+		if (num_threads == 0)
+			num_threads = 2;
 
-			while (mRunning)
-			{
-				_mutex.lock();
-				if (!mWorkQueue.empty())
-				{
-					auto work = mWorkQueue.front();
-					mWorkQueue.pop();
-					_mutex.unlock();
-
-					try
-					{
-						work();
-					}
-					catch (...) {}
-
-					mNumWork--;
-				}
-				else
-				{
-					_mutex.unlock();
-
-					// Extra code : Exit finished threads
-					if (mWaiting)
-						return;
-
-					std::this_thread::yield();
-					std::this_thread::sleep_for(std::chrono::milliseconds(1));
-				}
-			}
-		};
+		mQueues.reserve(num_threads);
+		for (size_t i = 0; i < num_threads; i++)
+			mQueues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue()));
 
 		mThreads.reserve(num_threads);
-
 		for (size_t i = 0; i < num_threads; i++)
-			mThreads.push_back(std::thread(doWork, i));
+			mThreads.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+
+		mDefaultGroup = std::make_shared<TaskGroup>(this);
 	}
 
 	ThreadPool::~ThreadPool()
 	{
-		mRunning = false;
+		mDefaultGroup->wait();
+
+		{
+			std::unique_lock<std::mutex> lock(mSleepLock);
+			mRunning = false;
+		}
+
+		mSleepCondition.notify_all();
 
 		for (std::thread& t : mThreads)
 			if (t.joinable())
 				t.join();
 	}
 
+	ThreadPool* ThreadPool::getShared()
+	{
+		static ThreadPool sharedPool(Settings::getInstance()->getInt("LoaderThreads"));
+		return &sharedPool;
+	}
+
+	bool ThreadPool::isWorkerThread() const
+	{
+		return tCurrentPool == this;
+	}
+
+	void ThreadPool::submit(work_function work)
+	{
+		// Work queued from a worker goes to its own deque (it's likely to be hot in cache), other work is spread round-robin
+		size_t index = isWorkerThread() ? tWorkerIndex : (mNextQueue++ % mQueues.size());
+
+		{
+			std::unique_lock<std::mutex> lock(mQueues[index]->lock);
+			mQueues[index]->tasks.push_back(work);
+		}
+
+		mQueuedCount++;
+
+		{
+			std::unique_lock<std::mutex> lock(mSleepLock);
+		}
+
+		mSleepCondition.notify_one();
+	}
+
+	bool ThreadPool::popTask(size_t index, work_function& work)
+	{
+		size_t count = mQueues.size();
+
+		// Own queue first, newest task
+		if (index < count)
+		{
+			WorkerQueue* queue = mQueues[index].get();
+
+			std::unique_lock<std::mutex> lock(queue->lock);
+			if (!queue->tasks.empty())
+			{
+				work = std::move(queue->tasks.back());
+				queue->tasks.pop_back();
+				mQueuedCount--;
+				return true;
+			}
+		}
+
+		// Then steal the oldest task of another worker
+		for (size_t i = 1; i <= count; i++)
+		{
+			WorkerQueue* queue = mQueues[(index + i) % count].get();
+			if (queue == (index < count ? mQueues[index].get() : nullptr))
+				continue;
+
+			std::unique_lock<std::mutex> lock(queue->lock, std::try_to_lock);
+			if (!lock.owns_lock() || queue->tasks.empty())
+				continue;
+
+			work = std::move(queue->tasks.front());
+			queue->tasks.pop_front();
+			mQueuedCount--;
+			return true;
+		}
+
+		return false;
+	}
+
+	bool ThreadPool::runPendingTask()
+	{
+		if (mQueuedCount.load() <= 0)
+			return false;
+
+		work_function work;
+		if (!popTask(isWorkerThread() ? tWorkerIndex : mQueues.size(), work))
+			return false;
+
+		work();
+		return true;
+	}
+
+	void ThreadPool::workerLoop(size_t index)
+	{
+#if WIN32
+		auto mask = (static_cast<DWORD_PTR>(1) << index);
+		SetThreadAffinityMask(GetCurrentThread(), mask);
+#endif
+
+		tCurrentPool = this;
+		tWorkerIndex = index;
+
+		while (true)
+		{
+			work_function work;
+			if (popTask(index, work))
+			{
+				work();
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(mSleepLock);
+			mSleepCondition.wait(lock, [this] { return !mRunning || mQueuedCount.load() > 0; });
+
+			if (!mRunning && mQueuedCount.load() <= 0)
+				return;
+		}
+	}
+
 	void ThreadPool::queueWorkItem(work_function work)
 	{
-		_mutex.lock();
-		mWorkQueue.push(work);
-		mNumWork++;
-		_mutex.unlock();
+		mDefaultGroup->run(work);
 	}
 
 	void ThreadPool::wait()
 	{
-		mWaiting = true;
-		while (mNumWork.load() > 0)
-			std::this_thread::yield();
+		mDefaultGroup->wait();
 	}
 
 	void ThreadPool::wait(work_function work, int delay)
 	{
-		mWaiting = true;
+		mDefaultGroup->wait(work, delay);
+	}
+
+	TaskGroup::TaskGroup(ThreadPool* pool) : mPool(pool != nullptr ? pool : ThreadPool::getShared()), mState(std::make_shared<State>())
+	{
+	}
+
+	TaskGroup::~TaskGroup()
+	{
+		wait();
+	}
+
+	void TaskGroup::run(ThreadPool::work_function work)
+	{
+		auto state = mState;
+		auto pool = mPool;
 
-		while (mNumWork.load() > 0)
+		state->pending++;
+
+		mPool->submit([pool, state, work]
+		{
+			try
+			{
+				work();
+			}
+			catch (...) {}
+
+			finish(pool, state);
+		});
+	}
+
+	void TaskGroup::finish(ThreadPool* pool, const std::shared_ptr<State>& state)
+	{
+		if (--state->pending != 0)
+			return;
+
+		std::vector<ThreadPool::work_function> continuations;
+
+		{
+			std::unique_lock<std::mutex> lock(state->lock);
+			continuations.swap(state->continuations);
+		}
+
+		state->done.notify_all();
+
+		for (auto& continuation : continuations)
+			pool->submit(continuation);
+	}
+
+	void TaskGroup::then(ThreadPool::work_function continuation)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mState->lock);
+			if (mState->pending.load() != 0)
+			{
+				mState->continuations.push_back(continuation);
+				return;
+			}
+		}
+
+		mPool->submit(continuation);
+	}
+
+	void TaskGroup::wait()
+	{
+		while (mState->pending.load() != 0)
+		{
+			// Help the pool rather than blocking : this is what makes nested waits from inside a task safe
+			if (mPool->runPendingTask())
+				continue;
+
+			std::unique_lock<std::mutex> lock(mState->lock);
+			mState->done.wait_for(lock, std::chrono::milliseconds(5), [this] { return mState->pending.load() == 0; });
+		}
+	}
+
+	void TaskGroup::wait(ThreadPool::work_function work, int delay)
+	{
+		while (mState->pending.load() != 0)
 		{
 			work();
 
-			std::this_thread::yield();
-			std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+			std::unique_lock<std::mutex> lock(mState->lock);
+			mState->done.wait_for(lock, std::chrono::milliseconds(delay), [this] { return mState->pending.load() == 0; });
 		}
 	}
-}
\ No newline at end of file
+}
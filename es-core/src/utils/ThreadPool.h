@@ -1,33 +1,116 @@
 #include <string>
 #pragma once
+#ifndef ES_CORE_UTILS_THREAD_POOL_H
+#define ES_CORE_UTILS_THREAD_POOL_H
 
 #include <thread>
 #include <mutex>
-#include <queue>
+#include <condition_variable>
+#include <deque>
 #include <atomic>
 #include <functional>
+#include <future>
+#include <memory>
+#include <vector>
 
 namespace Utils
 {
+	class TaskGroup;
+
+	// Work-stealing scheduler : every worker owns a deque, pops its own work LIFO and steals FIFO from the others.
+	// Idle workers are parked on a condition variable instead of polling.
 	class ThreadPool
 	{
 	public:
 		typedef std::function<void(void)> work_function;
 
-		ThreadPool();
+		ThreadPool(int threadCount = 0); // 0 -> one worker per hardware thread
 		~ThreadPool();
 
+		// Long-lived pool shared by the loaders. Its size comes from the "LoaderThreads" setting.
+		static ThreadPool* getShared();
+
+		// Queues work into this pool's default task group
 		void queueWorkItem(work_function work);
 		void wait();
 		void wait(work_function work, int delay = 50);
 
+		size_t getThreadCount() const { return mThreads.size(); }
+		bool isWorkerThread() const;
+
 	private:
-		bool mRunning;
-		bool mWaiting;
-		std::queue<work_function> mWorkQueue;
-		std::atomic<size_t> mNumWork;
-		std::mutex _mutex;
+		friend class TaskGroup;
+
+		struct WorkerQueue
+		{
+			std::mutex				lock;
+			std::deque<work_function>	tasks;
+		};
+
+		void submit(work_function work);
+		bool runPendingTask();
+		bool popTask(size_t index, work_function& work);
+		void workerLoop(size_t index);
+
+		std::vector<std::unique_ptr<WorkerQueue>> mQueues;
 		std::vector<std::thread> mThreads;
 
+		std::atomic<bool>	mRunning;
+		std::atomic<int>	mQueuedCount;
+		std::atomic<size_t>	mNextQueue;
+
+		std::mutex				mSleepLock;
+		std::condition_variable	mSleepCondition;
+
+		std::shared_ptr<TaskGroup> mDefaultGroup;
+	};
+
+	// A set of tasks running in a ThreadPool that can be waited for independently from the other users of the pool.
+	class TaskGroup
+	{
+	public:
+		TaskGroup(ThreadPool* pool = nullptr); // nullptr -> shared pool
+		~TaskGroup();
+
+		void run(ThreadPool::work_function work);
+
+		template<typename F>
+		auto async(F work) -> std::future<decltype(work())>
+		{
+			typedef decltype(work()) result_type;
+
+			auto task = std::make_shared<std::packaged_task<result_type()>>(work);
+			run([task] { (*task)(); });
+			return task->get_future();
+		}
+
+		// Runs once all the tasks queued so far are finished (immediately queued if the group is idle)
+		void then(ThreadPool::work_function continuation);
+
+		// Helps the pool until the group is done. Safe to call from a worker thread.
+		void wait();
+
+		// Calls 'work' every 'delay' ms until the group is done, without running tasks on the calling thread (used for loading screens).
+		void wait(ThreadPool::work_function work, int delay = 50);
+
+		bool isDone() const { return mState->pending.load() == 0; }
+
+	private:
+		struct State
+		{
+			State() : pending(0) { }
+
+			std::atomic<size_t>		pending;
+			std::mutex				lock;
+			std::condition_variable	done;
+			std::vector<ThreadPool::work_function> continuations;
+		};
+
+		static void finish(ThreadPool* pool, const std::shared_ptr<State>& state);
+
+		ThreadPool*				mPool;
+		std::shared_ptr<State>	mState;
 	};
-}
\ No newline at end of file
+}
+
+#endif // ES_CORE_UTILS_THREAD_POOL_H